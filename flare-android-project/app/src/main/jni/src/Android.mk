@@ -20,9 +20,11 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/AnimationManager.cpp \
 	../../../../../../src/AnimationSet.cpp \
 	../../../../../../src/AStarContainer.cpp \
+	../../../../../../src/AStarHierarchy.cpp \
 	../../../../../../src/AStarNode.cpp \
 	../../../../../../src/Avatar.cpp \
 	../../../../../../src/BehaviorStandard.cpp \
+	../../../../../../src/Benchmark.cpp \
 	../../../../../../src/CampaignManager.cpp \
 	../../../../../../src/CombatText.cpp \
 	../../../../../../src/CursorManager.cpp \
@@ -33,8 +35,11 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/EnemyGroupManager.cpp \
 	../../../../../../src/EnemyManager.cpp \
 	../../../../../../src/EngineSettings.cpp \
+	../../../../../../src/EntityGrid.cpp \
 	../../../../../../src/EventManager.cpp \
 	../../../../../../src/FileParser.cpp \
+	../../../../../../src/FileParserCache.cpp \
+	../../../../../../src/FlowField.cpp \
 	../../../../../../src/FontEngine.cpp \
 	../../../../../../src/GameSlotPreview.cpp \
 	../../../../../../src/GameState.cpp \
@@ -56,7 +61,9 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/LootManager.cpp \
 	../../../../../../src/Map.cpp \
 	../../../../../../src/MapParallax.cpp \
+	../../../../../../src/MapPreloader.cpp \
 	../../../../../../src/MapCollision.cpp \
+	../../../../../../src/MapLayer.cpp \
 	../../../../../../src/MapRenderer.cpp \
 	../../../../../../src/Menu.cpp \
 	../../../../../../src/MenuActionBar.cpp \
@@ -82,15 +89,19 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/MenuTouchControls.cpp \
 	../../../../../../src/MenuVendor.cpp \
 	../../../../../../src/MessageEngine.cpp \
+	../../../../../../src/ModArchive.cpp \
 	../../../../../../src/ModManager.cpp \
 	../../../../../../src/NPC.cpp \
 	../../../../../../src/NPCManager.cpp \
+	../../../../../../src/PathRequestQueue.cpp \
 	../../../../../../src/PowerManager.cpp \
+	../../../../../../src/Profiler.cpp \
 	../../../../../../src/QuestLog.cpp \
 	../../../../../../src/RenderDevice.cpp \
 	../../../../../../src/SaveLoad.cpp \
 	../../../../../../src/SDLInputState.cpp \
 	../../../../../../src/SDLHardwareRenderDevice.cpp \
+	../../../../../../src/SDLSoftwareBlitter.cpp \
 	../../../../../../src/SDLSoftwareRenderDevice.cpp \
 	../../../../../../src/SDLSoundManager.cpp \
 	../../../../../../src/SDLFontEngine.cpp \
@@ -101,6 +112,7 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/StatBlock.cpp \
 	../../../../../../src/Stats.cpp \
 	../../../../../../src/Subtitles.cpp \
+	../../../../../../src/TaskGraph.cpp \
 	../../../../../../src/TileSet.cpp \
 	../../../../../../src/TooltipData.cpp \
 	../../../../../../src/TooltipManager.cpp \
@@ -17,194 +17,195 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
 #include "AStarContainer.h"
-#include <cstring>
-#include <cfloat>
-
-AStarContainer::AStarContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit)
-	: size(0)
-	, node_limit(_node_limit)
-	, map_width(_map_width)
-	, map_height(_map_height)
-{
-	nodes.resize(node_limit, NULL);
 
-	//initialise the map array. A -1 value will mean there is no node at that position
-	map_pos.resize(map_width);
-	for (unsigned i=0; i<map_width; ++i) {
-		map_pos[i].resize(map_height, -1);
-	}
+#include <algorithm>
+
+AStarContainer::AStarContainer()
+	: node_limit(0)
+	, map_width(0)
+	, map_height(0)
+	, open_size(0)
+	, close_size(0)
+	, generation(0)
+	, shortest_h(-1)
+	, nodes_used(0)
+{
 }
 
 AStarContainer::~AStarContainer() {
-	for(unsigned int i=0; i<size; i++)
-		delete nodes[i];
-	nodes.clear();
 }
 
-int AStarContainer::getSize() {
-	return size;
+void AStarContainer::init(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit) {
+	map_width = _map_width;
+	map_height = _map_height;
+
+	const size_t map_area = static_cast<size_t>(map_width) * static_cast<size_t>(map_height);
+	tile_generation.assign(map_area, 0);
+	tile_node.assign(map_area, -1);
+	tile_heap.assign(map_area, -1);
+	tile_state.assign(map_area, NODE_NONE);
+	generation = 0;
+
+	reset(_node_limit);
 }
 
-void AStarContainer::add(AStarNode* node) {
-	if (size >= node_limit) return;
+void AStarContainer::reset(unsigned int _node_limit) {
+	node_limit = _node_limit;
 
-	//add the new node at the end and update its index
-	nodes[size] = node;
-	map_pos[node->getX()][node->getY()] = static_cast<short>(size);
-
-	//reorder the heap based on f ordering, staring with thenewly added node and working up the tree from there
-	int m = size;
-
-	AStarNode* temp = NULL;
-	while(m != 0) {
-		//if the current nodes f value is shorter than its parent, they need to be swapped
-		if(nodes[m]->getFinalCost() <= nodes[m/2]->getFinalCost()) {
-			temp = nodes[m/2];
-			nodes[m/2] = nodes[m];
-			map_pos[nodes[m/2]->getX()][nodes[m/2]->getY()] = static_cast<short>(m/2);
-			nodes[m] = temp;
-			map_pos[nodes[m]->getX()][nodes[m]->getY()] = static_cast<short>(m);
-			m=m/2;
-		}
-		else
-			break;
+	// the pool only grows when a search asks for a higher limit than any previous search
+	// both the open and closed sets are capped at node_limit
+	if (nodes.size() < node_limit * 2)
+		nodes.resize(node_limit * 2);
+	if (heap.size() < node_limit)
+		heap.resize(node_limit, -1);
+
+	open_size = 0;
+	close_size = 0;
+	nodes_used = 0;
+	shortest_h = -1;
+
+	// bumping the generation invalidates every tile entry at once
+	// on wrap-around, the stamps must be cleared so that stale entries don't appear valid
+	generation++;
+	if (generation == 0) {
+		std::fill(tile_generation.begin(), tile_generation.end(), 0);
+		generation = 1;
 	}
-	size++;
 }
 
-AStarNode* AStarContainer::get_shortest_f() {
-	return nodes[0];
+int AStarContainer::getOpenSize() {
+	return open_size;
 }
 
-void AStarContainer::remove(AStarNode* node) {
+int AStarContainer::getCloseSize() {
+	return close_size;
+}
 
-	unsigned int heap_indexv = map_pos[node->getX()][node->getY()] + 1;
+bool AStarContainer::isOpenEmpty() {
+	return open_size == 0;
+}
 
-	//swap the last node in the list with the node being deleted
-	nodes[heap_indexv-1] = nodes[size-1];
-	map_pos[nodes[heap_indexv-1]->getX()][nodes[heap_indexv-1]->getY()] = static_cast<short>(heap_indexv-1);
+int AStarContainer::tileIndex(int x, int y) {
+	return x + y * map_width;
+}
 
-	size--;
+bool AStarContainer::addOpen(const Point& pos, const Point& parent_pos, float actual_cost, float estimated_cost) {
+	if (open_size >= node_limit || nodes_used >= nodes.size()) return false;
 
-	if(size == 0) {
-		map_pos[node->getX()][node->getY()] = -1;
-		return;
-	}
+	int i = tileIndex(pos.x, pos.y);
 
-	// reorder the heap to maintain the f ordering, starting at the node which replaced the deleted node, and working down the tree
+	AStarNode* node = &nodes[nodes_used];
+	*node = AStarNode(pos);
+	node->setParent(parent_pos);
+	node->setActualCost(actual_cost);
+	node->setEstimatedCost(estimated_cost);
 
-	while(true) {
-		//start at the node which dropped down the tree on the previous iteration
-		unsigned int heap_indexu = heap_indexv;
-		if(2*heap_indexu+1 <= size) { //if both children exist
-			//Select the lowest of the two children.
-			if(nodes[heap_indexu-1]->getFinalCost() >= nodes[2*heap_indexu-1]->getFinalCost()) heap_indexv = 2*heap_indexu;
-			if(nodes[heap_indexv-1]->getFinalCost() >= nodes[2*heap_indexu]->getFinalCost()) heap_indexv = 2*heap_indexu+1;
-		}
-		else if (2*heap_indexu <= size) { //if only child #1 exists
-			//Check if the F cost is greater than the child
-			if(nodes[heap_indexu-1]->getFinalCost() >= nodes[2*heap_indexu-1]->getFinalCost()) heap_indexv = 2*heap_indexu;
-		}
+	tile_generation[i] = generation;
+	tile_node[i] = nodes_used;
+	tile_state[i] = NODE_OPEN;
 
-		if(heap_indexu != heap_indexv) { //If parent's F > one or both of its children, swap them
-			AStarNode* temp = nodes[heap_indexu-1];
-			nodes[heap_indexu-1] = nodes[heap_indexv-1];
-			map_pos[nodes[heap_indexu-1]->getX()][nodes[heap_indexu-1]->getY()] = static_cast<short>(heap_indexu-1);
-			nodes[heap_indexv-1] = temp;
-			map_pos[nodes[heap_indexv-1]->getX()][nodes[heap_indexv-1]->getY()] = static_cast<short>(heap_indexv-1);
-		}
-		else {
-			break;//if item <= both children, exit loop
-		}
-	}//Repeat forever
+	//add the new node at the end and update its index
+	heap[open_size] = nodes_used;
+	tile_heap[i] = open_size;
 
-	//remove the node from the map pos index
-	map_pos[node->getX()][node->getY()] = -1;
-}
+	nodes_used++;
+	open_size++;
 
-bool AStarContainer::exists(const Point& pos) {
-	return map_pos[pos.x][pos.y] != -1;
-}
+	//reorder the heap based on f ordering, staring with the newly added node and working up the tree from there
+	heapUp(open_size-1);
 
-AStarNode* AStarContainer::get(int x, int y) {
-	return nodes[map_pos[x][y]];
+	return true;
 }
 
-bool AStarContainer::isEmpty() {
-	return size == 0;
+AStarNode* AStarContainer::get_shortest_f() {
+	return &nodes[heap[0]];
 }
 
-void AStarContainer::updateParent(const Point& pos, const Point& parent_pos, float score) {
-	get(pos.x, pos.y)->setParent(parent_pos);
-	get(pos.x, pos.y)->setActualCost(score);
+void AStarContainer::closeShortest() {
+	AStarNode* node = &nodes[heap[0]];
+	int i = tileIndex(node->getX(), node->getY());
 
-	//reorder the heap based on the new f value of this node. starting at the updated node and working up the tree
-	int m = map_pos[pos.x][pos.y];
-	AStarNode* temp = NULL;
-	while(m != 0) {
-		//if the current node has a lower f value than its parent in the heap, swap them
-		if(nodes[m]->getFinalCost() <= nodes[m/2]->getFinalCost()) {
-			temp = nodes[m/2];
-			nodes[m/2] = nodes[m];
-			map_pos[nodes[m/2]->getX()][nodes[m/2]->getY()] = static_cast<short>(m/2);
-			nodes[m] = temp;
-			map_pos[nodes[m]->getX()][nodes[m]->getY()] = static_cast<short>(m);
-			m=m/2;
-		}
-		else
-			break;
+	//swap the last node in the heap with the node being removed
+	open_size--;
+	if (open_size > 0) {
+		heapSwap(0, open_size);
+		heapDown(0);
 	}
-}
 
-AStarCloseContainer::AStarCloseContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit)
-	: size(0)
-	, node_limit(_node_limit)
-	, map_width(_map_width)
-	, map_height(_map_height)
-{
-	nodes.resize(node_limit, NULL);
+	tile_heap[i] = -1;
+	tile_state[i] = NODE_CLOSED;
+	close_size++;
 
-	//initialise the map array. A -1 value will mean there is no node at that position
-	map_pos.resize(map_width);
-	for (unsigned i=0; i<map_width; ++i) {
-		map_pos[i].resize(map_height, -1);
-	}
+	// keep track of the closest node to the target so that get_shortest_h() doesn't need to search
+	if (shortest_h == -1 || node->getH() < nodes[shortest_h].getH())
+		shortest_h = tile_node[i];
 }
 
-AStarCloseContainer::~AStarCloseContainer() {
-	for(unsigned int i=0; i<size; i++)
-		delete nodes[i];
-	nodes.clear();
+bool AStarContainer::isOpen(const Point& pos) {
+	int i = tileIndex(pos.x, pos.y);
+	return tile_generation[i] == generation && tile_state[i] == NODE_OPEN;
 }
 
-int AStarCloseContainer::getSize() {
-	return size;
+bool AStarContainer::isClosed(const Point& pos) {
+	int i = tileIndex(pos.x, pos.y);
+	return tile_generation[i] == generation && tile_state[i] == NODE_CLOSED;
+}
+
+AStarNode* AStarContainer::get(int x, int y) {
+	return &nodes[tile_node[tileIndex(x, y)]];
 }
 
-void AStarCloseContainer::add(AStarNode* node) {
-	if (size >= node_limit) return;
+void AStarContainer::updateParent(const Point& pos, const Point& parent_pos, float score) {
+	AStarNode* node = get(pos.x, pos.y);
+	node->setParent(parent_pos);
+	node->setActualCost(score);
 
-	nodes[size] = node;
-	map_pos[node->getX()][node->getY()] = static_cast<short>(size);
-	size++;
+	//reorder the heap based on the new f value of this node. starting at the updated node and working up the tree
+	heapUp(tile_heap[tileIndex(pos.x, pos.y)]);
 }
 
-bool AStarCloseContainer::exists(const Point& pos) {
-	return map_pos[pos.x][pos.y] != -1;
+AStarNode* AStarContainer::get_shortest_h() {
+	if (shortest_h == -1)
+		return NULL;
+	return &nodes[shortest_h];
 }
 
-AStarNode* AStarCloseContainer::get(int x, int y) {
-	return nodes[map_pos[x][y]];
+void AStarContainer::heapSwap(unsigned int a, unsigned int b) {
+	int temp = heap[a];
+	heap[a] = heap[b];
+	heap[b] = temp;
+	tile_heap[tileIndex(nodes[heap[a]].getX(), nodes[heap[a]].getY())] = a;
+	tile_heap[tileIndex(nodes[heap[b]].getX(), nodes[heap[b]].getY())] = b;
 }
 
-AStarNode* AStarCloseContainer::get_shortest_h() {
-	AStarNode *current = NULL;
-	float lowest_score = FLT_MAX;
-	for(unsigned int i = 0; i < size; i++) {
-		if(nodes[i]->getH() < lowest_score) {
-			lowest_score = nodes[i]->getH();
-			current = nodes[i];
+void AStarContainer::heapUp(unsigned int m) {
+	while (m != 0) {
+		//if the current node has a lower f value than its parent in the heap, swap them
+		unsigned int parent = (m-1) / 2;
+		if (nodes[heap[m]].getFinalCost() <= nodes[heap[parent]].getFinalCost()) {
+			heapSwap(m, parent);
+			m = parent;
 		}
+		else
+			break;
+	}
+}
+
+void AStarContainer::heapDown(unsigned int m) {
+	while (true) {
+		unsigned int lowest = m;
+		unsigned int left = 2*m + 1;
+		unsigned int right = 2*m + 2;
+
+		//select the lowest of the node and its children
+		if (left < open_size && nodes[heap[lowest]].getFinalCost() >= nodes[heap[left]].getFinalCost()) lowest = left;
+		if (right < open_size && nodes[heap[lowest]].getFinalCost() >= nodes[heap[right]].getFinalCost()) lowest = right;
+
+		//if item <= both children, exit loop
+		if (lowest == m)
+			break;
+
+		heapSwap(m, lowest);
+		m = lowest;
 	}
-	return current;
 }
@@ -22,91 +22,96 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "AStarNode.h"
 
-typedef std::vector< std::vector<short> > AStar_Grid;
-
-/* Designed to be used for the Open nodes.
-*  Unsuitable for Closed nodes but a close node conatiner is declared below
+/* Reusable workspace for the A* open and closed node sets.
+*  One instance lives in MapCollision and is sized once per map in init(), so that computePath() does not allocate.
+*
+*  Nodes are taken from a preallocated pool. Each map tile has a slot in a flat index that is only valid when its
+*  generation stamp matches the current search, so reset() costs O(1) instead of O(map area).
 *
 *  All code in the class assumes that the nodes and points provided are within the bounds of the map limits
 */
 class AStarContainer {
 public:
-	AStarContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit);
-	AStarContainer(const AStarContainer&); // copy constructor not yet implemented
-
+	AStarContainer();
 	~AStarContainer();
-	int getSize();
+
+	// sizes the tile index for a new map and preallocates the node pool
+	void init(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit);
+	// empties the open and closed sets for a new search
+	void reset(unsigned int _node_limit);
+
+	int getOpenSize();
+	int getCloseSize();
+	bool isOpenEmpty();
+
 	//assumes that the node is not already in the collection
-	void add(AStarNode* node);
-	//assumes that there is at least 1 node in the collection
+	//returns false if the node limit has been reached
+	bool addOpen(const Point& pos, const Point& parent_pos, float actual_cost, float estimated_cost);
+	//assumes that there is at least 1 node in the open set
 	AStarNode* get_shortest_f();
-	//assumes that the node exists in the collection
-	void remove(AStarNode* node);
-	bool exists(const Point& pos);
+	//moves the node with the lowest f value from the open set to the closed set
+	void closeShortest();
+	bool isOpen(const Point& pos);
+	bool isClosed(const Point& pos);
 	//assumes that the node exists in the collection
 	AStarNode* get(int x, int y);
-	bool isEmpty();
 	void updateParent(const Point& pos, const Point& parent_pos, float score);
+	//returns the closed node with the lowest h value
+	AStarNode* get_shortest_h();
 
 private:
-	unsigned int size;
+	AStarContainer(const AStarContainer&); // copy constructor not implemented
+
+	enum {
+		NODE_NONE = 0,
+		NODE_OPEN = 1,
+		NODE_CLOSED = 2
+	};
+
+	int tileIndex(int x, int y);
+	void heapSwap(unsigned int a, unsigned int b);
+	void heapUp(unsigned int m);
+	void heapDown(unsigned int m);
+
 	unsigned int node_limit;
 	unsigned int map_width;
 	unsigned int map_height;
+	unsigned int open_size;
+	unsigned int close_size;
+	unsigned int generation;
+	int shortest_h;
+
+	// preallocated node storage; every node created during a search lives here
+	std::vector<AStarNode> nodes;
+	unsigned int nodes_used;
 
-	/* This is an array of AStarNode pointers. This is the main data for this collection.
-	*  The size of the array is based on the node limit.
+	/* This is an array of node pool indices. It holds the open set.
 	*
 	*  The nodes in this array are ordered based on their f value and the node with the lowest f value is always at position 0.
 	*  The ordering is not linear, so after positon 0, we cannot assume that position 1 has the second shortest f value.
 	*
 	*  The ordering is based on a binary heap structure.
-	*  Essentially, each node can have up to 2 child nodes and each child node must have a lower f value than its parent.
+	*  Essentially, each node can have up to 2 child nodes and each child node must have a higher f value than its parent.
 	*  This rule must be maintained whenever nodes are added or removed or their f value changes
 	*
 	*  The tree is represented by a 1 dimentional array where position 0 has children at position 1 and 2
 	*  Node 1 would have children at position 3 and 4 and node 2 would have children at position 5 and 6 and so on
 	*
 	*  A more detailed explanation of the structure can be found at the below web address.
-	*  Please note that there is additional code found in this class which is not mentioned in the article. This is to provide an index based on map position.
 	*  Also note that the code within the article is based on arrays with starting position 1, whereas we use 0 based arrays.
 	*  http://www.policyalmanac.org/games/binaryHeaps.htm
 	*/
-	std::vector<AStarNode*> nodes;
+	std::vector<int> heap;
 
-	/* This is a 2d array of shorts ([map_width][map_height]) which acts as an index for the main node array.
-	*  Elements can be accessed using cartesian coordinates e.g. map_pos[x][y]
-	*  To access an AStarNode based on map position use: nodes[map_pos[x][y]]
-	*
-	*  The data in this array is initialised as -1, which indicates hat there is no corresponding node for that position
-	*  This must be maintained when nodes are added, removed and re-ordered in the node array
+	/* These are flat arrays ([map_width * map_height]) indexed by x + y * map_width.
+	*  A tile's entries are only meaningful if tile_generation matches the current generation.
+	*  tile_node is the node pool index, tile_state is one of NODE_OPEN or NODE_CLOSED,
+	*  and tile_heap is the position of an open node in the heap array.
 	*/
-	AStar_Grid map_pos;
-};
-
-/* This class is used to store the closed list of a* nodes
-*  The nodes within this class have no ordering but stil have a map position index
-*/
-class AStarCloseContainer {
-public:
-	AStarCloseContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit);
-	AStarCloseContainer(const AStarCloseContainer&); // copy constructor not yet implemented
-	~AStarCloseContainer();
-
-	int getSize();
-	void add(AStarNode* node);
-	bool exists(const Point& pos);
-	AStarNode* get(int x, int y);
-	AStarNode* get_shortest_h();
-
-private:
-	unsigned int size;
-	unsigned int node_limit;
-	unsigned int map_width;
-	unsigned int map_height;
-	std::vector<AStarNode*> nodes;
-	AStar_Grid map_pos;
-
+	std::vector<unsigned int> tile_generation;
+	std::vector<int> tile_node;
+	std::vector<int> tile_heap;
+	std::vector<unsigned char> tile_state;
 };
 
 #endif // ASTARCONTAINER_H
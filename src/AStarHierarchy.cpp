@@ -0,0 +1,409 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "AStarHierarchy.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+static const float DIAGONAL_COST = 1.41421356f;
+
+AStarHierarchy::AStarHierarchy()
+	: map_width(0)
+	, map_height(0)
+	, clusters_w(0)
+	, clusters_h(0)
+	, any_dirty(false)
+	, nodes_expanded(0)
+	, generation(0)
+	, start_cluster(-1)
+	, end_cluster(-1)
+{
+}
+
+AStarHierarchy::~AStarHierarchy() {
+}
+
+void AStarHierarchy::init(int _map_width, int _map_height) {
+	map_width = _map_width;
+	map_height = _map_height;
+
+	clusters_w = (map_width + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+	clusters_h = (map_height + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+	passable.assign(map_width * map_height, 0);
+
+	clusters.clear();
+	clusters.resize(clusters_w * clusters_h);
+	for (int cy = 0; cy < clusters_h; ++cy) {
+		for (int cx = 0; cx < clusters_w; ++cx) {
+			AStarCluster& cluster = clusters[cx + cy * clusters_w];
+			cluster.bounds.x = cx * CLUSTER_SIZE;
+			cluster.bounds.y = cy * CLUSTER_SIZE;
+			cluster.bounds.w = std::min(CLUSTER_SIZE, map_width - cluster.bounds.x);
+			cluster.bounds.h = std::min(CLUSTER_SIZE, map_height - cluster.bounds.y);
+			cluster.dirty = true;
+		}
+	}
+	any_dirty = true;
+
+	local_cost.resize(CLUSTER_SIZE * CLUSTER_SIZE);
+	start_cost.resize(MAX_CLUSTER_NODES);
+	end_cost.resize(MAX_CLUSTER_NODES);
+
+	// two extra ids are used for the start and end tiles
+	size_t id_count = clusters.size() * MAX_CLUSTER_NODES + 2;
+	node_g.assign(id_count, 0);
+	node_parent.assign(id_count, -1);
+	node_generation.assign(id_count, 0);
+	generation = 0;
+}
+
+void AStarHierarchy::setPassable(int x, int y, bool _passable) {
+	if (x < 0 || y < 0 || x >= map_width || y >= map_height)
+		return;
+
+	unsigned char value = _passable ? 1 : 0;
+	if (passable[x + y * map_width] == value)
+		return;
+
+	passable[x + y * map_width] = value;
+
+	int cx = x / CLUSTER_SIZE;
+	int cy = y / CLUSTER_SIZE;
+	markDirty(cx, cy);
+
+	// tiles on a cluster border also decide the transitions of the neighbouring cluster
+	if (x % CLUSTER_SIZE == 0) markDirty(cx-1, cy);
+	if (x % CLUSTER_SIZE == CLUSTER_SIZE-1) markDirty(cx+1, cy);
+	if (y % CLUSTER_SIZE == 0) markDirty(cx, cy-1);
+	if (y % CLUSTER_SIZE == CLUSTER_SIZE-1) markDirty(cx, cy+1);
+}
+
+void AStarHierarchy::markDirty(int cluster_x, int cluster_y) {
+	if (cluster_x < 0 || cluster_y < 0 || cluster_x >= clusters_w || cluster_y >= clusters_h)
+		return;
+
+	clusters[cluster_x + cluster_y * clusters_w].dirty = true;
+	any_dirty = true;
+}
+
+void AStarHierarchy::update() {
+	if (!any_dirty)
+		return;
+
+	for (size_t i = 0; i < clusters.size(); ++i) {
+		if (clusters[i].dirty)
+			buildCluster(static_cast<int>(i));
+	}
+	any_dirty = false;
+}
+
+bool AStarHierarchy::isPassable(int x, int y) const {
+	if (x < 0 || y < 0 || x >= map_width || y >= map_height)
+		return false;
+
+	return passable[x + y * map_width] != 0;
+}
+
+int AStarHierarchy::getClusterIndex(int x, int y) const {
+	return (x / CLUSTER_SIZE) + (y / CLUSTER_SIZE) * clusters_w;
+}
+
+bool AStarHierarchy::isLongDistance(const Point& start, const Point& end) const {
+	if (clusters.empty())
+		return false;
+
+	int dx = abs(start.x - end.x);
+	int dy = abs(start.y - end.y);
+	return std::max(dx, dy) > CLUSTER_SIZE;
+}
+
+/**
+ * Places transitions along the border shared by cluster and its neighbour.
+ * Starting at from, length tiles are checked by moving along step.
+ * The matching tile on the neighbour's side is found by adding across.
+ */
+void AStarHierarchy::addEntrances(AStarCluster& cluster, const Point& from, const Point& step, const Point& across, int length) {
+	int run_start = -1;
+
+	for (int i = 0; i <= length; ++i) {
+		bool open_tile = false;
+		if (i < length) {
+			int x = from.x + step.x * i;
+			int y = from.y + step.y * i;
+			open_tile = isPassable(x, y) && isPassable(x + across.x, y + across.y);
+		}
+
+		if (open_tile && run_start == -1) {
+			run_start = i;
+		}
+		else if (!open_tile && run_start != -1) {
+			int run_end = i - 1;
+			if (run_end - run_start + 1 < MAX_SINGLE_ENTRANCE) {
+				int mid = (run_start + run_end) / 2;
+				addTransition(cluster, Point(from.x + step.x * mid, from.y + step.y * mid));
+			}
+			else {
+				addTransition(cluster, Point(from.x + step.x * run_start, from.y + step.y * run_start));
+				addTransition(cluster, Point(from.x + step.x * run_end, from.y + step.y * run_end));
+			}
+			run_start = -1;
+		}
+	}
+}
+
+void AStarHierarchy::addTransition(AStarCluster& cluster, const Point& pos) {
+	for (size_t i = 0; i < cluster.nodes.size(); ++i) {
+		if (cluster.nodes[i].x == pos.x && cluster.nodes[i].y == pos.y)
+			return;
+	}
+	cluster.nodes.push_back(pos);
+}
+
+int AStarHierarchy::findNode(int cluster_index, const Point& pos) const {
+	const AStarCluster& cluster = clusters[cluster_index];
+	for (size_t i = 0; i < cluster.nodes.size(); ++i) {
+		if (cluster.nodes[i].x == pos.x && cluster.nodes[i].y == pos.y)
+			return static_cast<int>(i);
+	}
+	return -1;
+}
+
+void AStarHierarchy::buildCluster(int index) {
+	AStarCluster& cluster = clusters[index];
+	const Rect& b = cluster.bounds;
+
+	cluster.nodes.clear();
+	cluster.edges.clear();
+
+	// entrances are computed from both sides of a border in the same order, so both clusters agree on them
+	if (b.x > 0)
+		addEntrances(cluster, Point(b.x, b.y), Point(0, 1), Point(-1, 0), b.h);
+	if (b.x + b.w < map_width)
+		addEntrances(cluster, Point(b.x + b.w - 1, b.y), Point(0, 1), Point(1, 0), b.h);
+	if (b.y > 0)
+		addEntrances(cluster, Point(b.x, b.y), Point(1, 0), Point(0, -1), b.w);
+	if (b.y + b.h < map_height)
+		addEntrances(cluster, Point(b.x, b.y + b.h - 1), Point(1, 0), Point(0, 1), b.w);
+
+	cluster.edges.resize(cluster.nodes.size());
+	for (size_t i = 0; i < cluster.nodes.size(); ++i) {
+		searchCluster(index, cluster.nodes[i], start_cost);
+		for (size_t j = 0; j < cluster.nodes.size(); ++j) {
+			if (i != j && start_cost[j] >= 0)
+				cluster.edges[i].push_back(AStarEdge(static_cast<int>(j), start_cost[j]));
+		}
+	}
+
+	cluster.dirty = false;
+}
+
+void AStarHierarchy::searchCluster(int index, const Point& source, std::vector<float>& node_cost) {
+	const AStarCluster& cluster = clusters[index];
+	const Rect& b = cluster.bounds;
+
+	std::fill(local_cost.begin(), local_cost.end(), -1.f);
+	local_heap.clear();
+
+	int source_index = (source.x - b.x) + (source.y - b.y) * CLUSTER_SIZE;
+	local_cost[source_index] = 0;
+	local_heap.push_back(HeapEntry(0, source_index));
+
+	while (!local_heap.empty()) {
+		std::pop_heap(local_heap.begin(), local_heap.end());
+		HeapEntry current = local_heap.back();
+		local_heap.pop_back();
+
+		if (current.f > local_cost[current.id])
+			continue;
+
+		int x = b.x + current.id % CLUSTER_SIZE;
+		int y = b.y + current.id / CLUSTER_SIZE;
+
+		for (int dy = -1; dy <= 1; ++dy) {
+			for (int dx = -1; dx <= 1; ++dx) {
+				if (dx == 0 && dy == 0) continue;
+
+				int nx = x + dx;
+				int ny = y + dy;
+				if (nx < b.x || ny < b.y || nx >= b.x + b.w || ny >= b.y + b.h) continue;
+				if (!isPassable(nx, ny)) continue;
+
+				int n = (nx - b.x) + (ny - b.y) * CLUSTER_SIZE;
+				float cost = current.f + ((dx != 0 && dy != 0) ? DIAGONAL_COST : 1.f);
+				if (local_cost[n] < 0 || cost < local_cost[n]) {
+					local_cost[n] = cost;
+					local_heap.push_back(HeapEntry(cost, n));
+					std::push_heap(local_heap.begin(), local_heap.end());
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < cluster.nodes.size(); ++i) {
+		const Point& p = cluster.nodes[i];
+		node_cost[i] = local_cost[(p.x - b.x) + (p.y - b.y) * CLUSTER_SIZE];
+	}
+}
+
+Point AStarHierarchy::getNodePos(int id) const {
+	int start_id = static_cast<int>(clusters.size()) * MAX_CLUSTER_NODES;
+	if (id == start_id)
+		return search_start;
+	else if (id == start_id + 1)
+		return search_end;
+
+	return clusters[id / MAX_CLUSTER_NODES].nodes[id % MAX_CLUSTER_NODES];
+}
+
+/**
+ * Octile distance to the end tile; never overestimates the true cost
+ */
+float AStarHierarchy::estimate(const Point& p) const {
+	float dx = static_cast<float>(abs(p.x - search_end.x));
+	float dy = static_cast<float>(abs(p.y - search_end.y));
+	return std::max(dx, dy) + (DIAGONAL_COST - 1.f) * std::min(dx, dy);
+}
+
+void AStarHierarchy::relax(int id, int parent, float g) {
+	if (node_generation[id] == generation && node_g[id] <= g)
+		return;
+
+	node_generation[id] = generation;
+	node_g[id] = g;
+	node_parent[id] = parent;
+	open.push_back(HeapEntry(g + estimate(getNodePos(id)), id));
+	std::push_heap(open.begin(), open.end());
+}
+
+bool AStarHierarchy::findPath(const Point& start, const Point& end, std::vector<Point>& waypoints) {
+	waypoints.clear();
+	nodes_expanded = 0;
+
+	if (clusters.empty() || !isPassable(start.x, start.y) || !isPassable(end.x, end.y))
+		return false;
+
+	update();
+
+	search_start = start;
+	search_end = end;
+	start_cluster = getClusterIndex(start.x, start.y);
+	end_cluster = getClusterIndex(end.x, end.y);
+
+	searchCluster(start_cluster, start, start_cost);
+
+	// if both tiles share a cluster, they may also be connected directly
+	float direct_cost = -1;
+	if (start_cluster == end_cluster) {
+		const Rect& b = clusters[start_cluster].bounds;
+		direct_cost = local_cost[(end.x - b.x) + (end.y - b.y) * CLUSTER_SIZE];
+	}
+
+	searchCluster(end_cluster, end, end_cost);
+
+	generation++;
+	if (generation == 0) {
+		std::fill(node_generation.begin(), node_generation.end(), 0);
+		generation = 1;
+	}
+
+	const int start_id = static_cast<int>(clusters.size()) * MAX_CLUSTER_NODES;
+	const int end_id = start_id + 1;
+
+	open.clear();
+	node_generation[start_id] = generation;
+	node_g[start_id] = 0;
+	node_parent[start_id] = -1;
+
+	// the start tile connects to every transition it can reach inside its own cluster
+	const AStarCluster& first = clusters[start_cluster];
+	for (size_t i = 0; i < first.nodes.size(); ++i) {
+		if (start_cost[i] >= 0)
+			relax(start_cluster * MAX_CLUSTER_NODES + static_cast<int>(i), start_id, start_cost[i]);
+	}
+	if (direct_cost >= 0)
+		relax(end_id, start_id, direct_cost);
+
+	bool found = false;
+
+	while (!open.empty()) {
+		std::pop_heap(open.begin(), open.end());
+		HeapEntry current = open.back();
+		open.pop_back();
+
+		// skip entries that were superseded by a cheaper route
+		if (current.f > node_g[current.id] + estimate(getNodePos(current.id)) + 0.001f)
+			continue;
+
+		if (current.id == end_id) {
+			found = true;
+			break;
+		}
+
+		nodes_expanded++;
+
+		int cluster_index = current.id / MAX_CLUSTER_NODES;
+		int node_index = current.id % MAX_CLUSTER_NODES;
+		const AStarCluster& cluster = clusters[cluster_index];
+		const Point& pos = cluster.nodes[node_index];
+		float g = node_g[current.id];
+
+		// intra-cluster edges
+		const std::vector<AStarEdge>& edges = cluster.edges[node_index];
+		for (size_t i = 0; i < edges.size(); ++i) {
+			relax(cluster_index * MAX_CLUSTER_NODES + edges[i].target, current.id, g + edges[i].cost);
+		}
+
+		// inter-cluster edges connect a transition to the one directly across the border
+		static const int dirs[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+		for (int d = 0; d < 4; ++d) {
+			int nx = pos.x + dirs[d][0];
+			int ny = pos.y + dirs[d][1];
+			if (nx < 0 || ny < 0 || nx >= map_width || ny >= map_height) continue;
+
+			int other = getClusterIndex(nx, ny);
+			if (other == cluster_index) continue;
+
+			int other_node = findNode(other, Point(nx, ny));
+			if (other_node != -1)
+				relax(other * MAX_CLUSTER_NODES + other_node, current.id, g + 1.f);
+		}
+
+		// transitions in the end cluster connect to the end tile
+		if (cluster_index == end_cluster && end_cost[node_index] >= 0) {
+			relax(end_id, current.id, g + end_cost[node_index]);
+		}
+	}
+
+	if (!found)
+		return false;
+
+	// store waypoints from end to start, then reverse them
+	int id = end_id;
+	while (id != start_id) {
+		waypoints.push_back(getNodePos(id));
+		id = node_parent[id];
+	}
+	std::reverse(waypoints.begin(), waypoints.end());
+
+	return true;
+}
+
+int AStarHierarchy::getNodesExpanded() const {
+	return nodes_expanded;
+}
@@ -0,0 +1,156 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class AStarHierarchy
+ *
+ * Abstract cluster graph used for long distance pathfinding (HPA*).
+ * The map is split into square clusters. Where two neighbouring clusters share passable border tiles,
+ * transition nodes are placed on both sides. Transition nodes within a cluster are connected by edges
+ * holding the cost of the shortest path between them inside that cluster.
+ *
+ * A search on this graph yields a list of waypoints that MapCollision refines with regular A*.
+ */
+
+#ifndef ASTARHIERARCHY_H
+#define ASTARHIERARCHY_H
+
+#include <vector>
+
+#include "Utils.h"
+
+class AStarEdge {
+public:
+	int target;
+	float cost;
+
+	AStarEdge(int _target, float _cost)
+		: target(_target)
+		, cost(_cost)
+	{}
+};
+
+class AStarCluster {
+public:
+	Rect bounds;
+	bool dirty;
+
+	// transition tiles inside this cluster
+	std::vector<Point> nodes;
+
+	// intra-cluster edges for each transition tile; targets are indices into nodes
+	std::vector< std::vector<AStarEdge> > edges;
+
+	AStarCluster()
+		: dirty(true)
+	{}
+};
+
+class AStarHierarchy {
+public:
+	static const int CLUSTER_SIZE = 16;
+
+	AStarHierarchy();
+	~AStarHierarchy();
+
+	// resize for a new map; all tiles start out impassable
+	void init(int _map_width, int _map_height);
+
+	// flag a tile as passable or not, marking the clusters that depend on it for rebuilding
+	void setPassable(int x, int y, bool passable);
+
+	// rebuild the transitions and edges of every dirty cluster
+	void update();
+
+	// returns true if both tiles are far enough apart for the hierarchy to be worth using
+	bool isLongDistance(const Point& start, const Point& end) const;
+
+	// fills waypoints with transition tiles from start to end (excluding start, including end)
+	// returns false if no abstract path exists
+	bool findPath(const Point& start, const Point& end, std::vector<Point>& waypoints);
+
+	// the number of abstract nodes expanded by the most recent findPath()
+	int getNodesExpanded() const;
+
+private:
+	AStarHierarchy(const AStarHierarchy&); // copy constructor not implemented
+
+	// each border tile of a cluster can hold at most one transition
+	static const int MAX_CLUSTER_NODES = CLUSTER_SIZE * 4;
+
+	// long entrances get a transition at each end instead of one in the middle
+	static const int MAX_SINGLE_ENTRANCE = 6;
+
+	class HeapEntry {
+	public:
+		float f;
+		int id;
+		HeapEntry(float _f, int _id)
+			: f(_f)
+			, id(_id)
+		{}
+		bool operator<(const HeapEntry& other) const {
+			// reversed so that std::push_heap builds a min-heap
+			return f > other.f;
+		}
+	};
+
+	bool isPassable(int x, int y) const;
+	int getClusterIndex(int x, int y) const;
+	void markDirty(int cluster_x, int cluster_y);
+
+	void buildCluster(int index);
+	void addEntrances(AStarCluster& cluster, const Point& from, const Point& step, const Point& across, int length);
+	void addTransition(AStarCluster& cluster, const Point& pos);
+	int findNode(int cluster_index, const Point& pos) const;
+
+	// Dijkstra restricted to one cluster; costs to each of the cluster's nodes are written to node_cost (-1 if unreachable)
+	void searchCluster(int index, const Point& source, std::vector<float>& node_cost);
+
+	Point getNodePos(int id) const;
+	float estimate(const Point& p) const;
+	void relax(int id, int parent, float g);
+
+	int map_width;
+	int map_height;
+	int clusters_w;
+	int clusters_h;
+	bool any_dirty;
+	int nodes_expanded;
+
+	std::vector<unsigned char> passable;
+	std::vector<AStarCluster> clusters;
+
+	// workspace for searchCluster()
+	std::vector<float> local_cost;
+	std::vector<HeapEntry> local_heap;
+
+	// workspace for findPath(); entries are valid when their generation stamp matches
+	std::vector<float> node_g;
+	std::vector<int> node_parent;
+	std::vector<unsigned int> node_generation;
+	std::vector<HeapEntry> open;
+	std::vector<float> start_cost;
+	std::vector<float> end_cost;
+	unsigned int generation;
+	Point search_start;
+	Point search_end;
+	int start_cluster;
+	int end_cluster;
+};
+
+#endif // ASTARHIERARCHY_H
@@ -56,51 +56,34 @@ void AStarNode::setParent(const Point& p) {
 	this->parent = p;
 }
 
-std::list<Point> AStarNode::getNeighbours(int limitX, int limitY) const {
-	Point toAdd;
-	std::list<Point> res;
+int AStarNode::getNeighbours(Point* neighbours, int limitX, int limitY) const {
+	int count = 0;
 	if (x>node_stride && y>node_stride) {
-		toAdd.x = x-node_stride;
-		toAdd.y = y-node_stride;
-		res.push_back(toAdd);
+		neighbours[count++] = Point(x-node_stride, y-node_stride);
 	}
 	if (x>node_stride && (limitY==0 || y<limitY-node_stride)) {
-		toAdd.x = x-node_stride;
-		toAdd.y = y+node_stride;
-		res.push_back(toAdd);
+		neighbours[count++] = Point(x-node_stride, y+node_stride);
 	}
 	if (y>node_stride && (limitX==0 || x<limitX-node_stride)) {
-		toAdd.x = x+node_stride;
-		toAdd.y = y-node_stride;
-		res.push_back(toAdd);
+		neighbours[count++] = Point(x+node_stride, y-node_stride);
 	}
 	if ((limitX==0 || x<limitX-node_stride) && (limitY==0 || y<limitY-node_stride)) {
-		toAdd.x = x+node_stride;
-		toAdd.y = y+node_stride;
-		res.push_back(toAdd);
+		neighbours[count++] = Point(x+node_stride, y+node_stride);
 	}
 	if (x>node_stride) {
-		toAdd.x = x-node_stride;
-		toAdd.y = y;
-		res.push_back(toAdd);
+		neighbours[count++] = Point(x-node_stride, y);
 	}
 	if (y>node_stride) {
-		toAdd.x = x;
-		toAdd.y = y-node_stride;
-		res.push_back(toAdd);
+		neighbours[count++] = Point(x, y-node_stride);
 	}
 	if (limitX==0 || x<limitX-node_stride) {
-		toAdd.x = x+node_stride;
-		toAdd.y = y;
-		res.push_back(toAdd);
+		neighbours[count++] = Point(x+node_stride, y);
 	}
 	if (limitY==0 || y<limitY-node_stride) {
-		toAdd.x = x;
-		toAdd.y = y+node_stride;
-		res.push_back(toAdd);
+		neighbours[count++] = Point(x, y+node_stride);
 	}
 
-	return res;
+	return count;
 }
 
 
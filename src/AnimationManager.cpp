@@ -25,14 +25,16 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include <cassert>
 
+const Uint32 AnimationManager::EVICTION_DELAY;
+const size_t AnimationManager::NO_ENTRY;
+
 AnimationSet *AnimationManager::getAnimationSet(const std::string& filename) {
-	std::vector<std::string>::iterator found = find(names.begin(), names.end(), filename);
-	if (found != names.end()) {
-		size_t index = static_cast<size_t>(distance(names.begin(), found));
-		if (sets[index] == 0) {
-			sets[index] = new AnimationSet(filename);
+	size_t index = findEntry(filename);
+	if (index != NO_ENTRY) {
+		if (entries[index].set == NULL) {
+			entries[index].set = new AnimationSet(filename);
 		}
-		return sets[index];
+		return entries[index].set;
 	}
 	else {
 		Utils::logError("AnimationManager::getAnimationSet(): %s not found", filename.c_str());
@@ -43,42 +45,59 @@ AnimationSet *AnimationManager::getAnimationSet(const std::string& filename) {
 	}
 }
 
-AnimationManager::AnimationManager() {
+AnimationSet *AnimationManager::getAnimationSet(const Handle& handle) {
+	size_t index = findEntry(handle);
+	if (index == NO_ENTRY) {
+		Utils::logError("AnimationManager::getAnimationSet(): Invalid handle %u:%u", static_cast<unsigned>(handle.index), handle.generation);
+		return NULL;
+	}
+
+	// the set is loaded on first use
+	if (entries[index].set == NULL) {
+		entries[index].set = new AnimationSet(entries[index].name);
+	}
+	return entries[index].set;
+}
+
+AnimationManager::AnimationManager()
+	: entry_count(0) {
+	rehash(256);
 }
 
 AnimationManager::~AnimationManager() {
-	cleanUp();
+	clearUnused();
 // NDEBUG is used by posix to disable assertions, so use the same MACRO.
 #ifndef NDEBUG
-	if (!names.empty()) {
+	if (entry_count > 0) {
 		Utils::logError("AnimationManager: Still holding these animations:");
-		for (size_t i = 0; i < names.size(); i++) {
-			Utils::logError("%s %d", names[i].c_str(), counts[i]);
+		for (size_t i = 0; i < entries.size(); i++) {
+			if (entries[i].in_use)
+				Utils::logError("%s %d", entries[i].name.c_str(), entries[i].count);
 		}
 	}
-	assert(names.size() == 0);
+	assert(entry_count == 0);
 #endif
 }
 
-void AnimationManager::increaseCount(const std::string &name) {
-	std::vector<std::string>::iterator found = find(names.begin(), names.end(), name);
-	if (found != names.end()) {
-		size_t index = static_cast<size_t>(distance(names.begin(), found));
-		counts[index]++;
+AnimationManager::Handle AnimationManager::increaseCount(const std::string &name) {
+	size_t index = findEntry(name);
+	if (index != NO_ENTRY) {
+		entries[index].count++;
 	}
 	else {
-		sets.push_back(0);
-		names.push_back(name);
-		counts.push_back(1);
+		index = addEntry(name);
 	}
+
+	Handle handle;
+	handle.index = index;
+	handle.generation = entries[index].generation;
+	return handle;
 }
 
 void AnimationManager::decreaseCount(const std::string &name) {
-
-	std::vector<std::string>::iterator found = find(names.begin(), names.end(), name);
-	if (found != names.end()) {
-		size_t index = static_cast<size_t>(distance(names.begin(), found));
-		counts[index]--;
+	size_t index = findEntry(name);
+	if (index != NO_ENTRY) {
+		releaseEntry(index);
 	}
 	else {
 		Utils::logError("AnimationManager::decreaseCount(): %s not found", name.c_str());
@@ -87,15 +106,155 @@ void AnimationManager::decreaseCount(const std::string &name) {
 	}
 }
 
+void AnimationManager::decreaseCount(const Handle& handle) {
+	size_t index = findEntry(handle);
+	if (index != NO_ENTRY) {
+		releaseEntry(index);
+	}
+	else {
+		Utils::logError("AnimationManager::decreaseCount(): Invalid handle %u:%u", static_cast<unsigned>(handle.index), handle.generation);
+	}
+}
+
 void AnimationManager::cleanUp() {
-	int i = static_cast<int>(sets.size()) - 1;
-	while (i >= 0) {
-		if (counts[i] <= 0) {
-			delete sets[i];
-			counts.erase(counts.begin()+i);
-			sets.erase(sets.begin()+i);
-			names.erase(names.begin()+i);
+	removeUnused(EVICTION_DELAY);
+}
+
+void AnimationManager::clearUnused() {
+	removeUnused(0);
+}
+
+/**
+ * FNV-1a
+ */
+Uint32 AnimationManager::hashName(const std::string &name) {
+	Uint32 hash = 2166136261u;
+	for (size_t i = 0; i < name.length(); ++i) {
+		hash ^= static_cast<unsigned char>(name[i]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+size_t AnimationManager::findEntry(const std::string &name) const {
+	size_t index = buckets[hashName(name) & (buckets.size() - 1)];
+	while (index != NO_ENTRY) {
+		if (entries[index].name == name)
+			return index;
+		index = entries[index].next;
+	}
+	return NO_ENTRY;
+}
+
+size_t AnimationManager::findEntry(const Handle& handle) const {
+	if (handle.index >= entries.size())
+		return NO_ENTRY;
+
+	const Entry& entry = entries[handle.index];
+	if (!entry.in_use || entry.generation != handle.generation)
+		return NO_ENTRY;
+
+	return handle.index;
+}
+
+size_t AnimationManager::addEntry(const std::string &name) {
+	size_t index;
+	if (!free_entries.empty()) {
+		index = free_entries.back();
+		free_entries.pop_back();
+	}
+	else {
+		index = entries.size();
+		entries.resize(entries.size() + 1);
+	}
+
+	Entry& entry = entries[index];
+	entry.name = name;
+	entry.set = NULL;
+	entry.count = 1;
+	entry.in_use = true;
+
+	size_t bucket = hashName(name) & (buckets.size() - 1);
+	entry.next = buckets[bucket];
+	buckets[bucket] = index;
+
+	entry_count++;
+	if (entry_count > buckets.size())
+		rehash(buckets.size() * 2);
+
+	return index;
+}
+
+void AnimationManager::removeEntry(size_t index) {
+	Entry& entry = entries[index];
+
+	size_t* link = &buckets[hashName(entry.name) & (buckets.size() - 1)];
+	while (*link != index) {
+		link = &entries[*link].next;
+	}
+	*link = entry.next;
+
+	delete entry.set;
+	entry.set = NULL;
+	entry.name.clear();
+	entry.count = 0;
+	entry.in_use = false;
+	entry.next = NO_ENTRY;
+
+	// invalidate the handles to this entry
+	entry.generation++;
+	if (entry.generation == 0)
+		entry.generation = 1;
+
+	free_entries.push_back(index);
+	entry_count--;
+}
+
+void AnimationManager::releaseEntry(size_t index) {
+	Entry& entry = entries[index];
+	entry.count--;
+
+	if (entry.count <= 0) {
+		entry.release_ticks = SDL_GetTicks();
+		if (!entry.released) {
+			entry.released = true;
+			released_entries.push_back(index);
+		}
+	}
+}
+
+void AnimationManager::removeUnused(Uint32 delay) {
+	const Uint32 now = SDL_GetTicks();
+
+	size_t kept = 0;
+	for (size_t i = 0; i < released_entries.size(); ++i) {
+		size_t index = released_entries[i];
+		Entry& entry = entries[index];
+
+		if (entry.count > 0) {
+			// referenced again before it was removed
+			entry.released = false;
 		}
-		--i;
+		else if (now - entry.release_ticks >= delay) {
+			entry.released = false;
+			removeEntry(index);
+		}
+		else {
+			released_entries[kept++] = index;
+		}
+	}
+	released_entries.resize(kept);
+}
+
+void AnimationManager::rehash(size_t bucket_count) {
+	buckets.assign(bucket_count, NO_ENTRY);
+
+	for (size_t i = 0; i < entries.size(); ++i) {
+		if (!entries[i].in_use)
+			continue;
+
+		size_t bucket = hashName(entries[i].name) & (bucket_count - 1);
+		entries[i].next = buckets[bucket];
+		buckets[bucket] = i;
 	}
 }
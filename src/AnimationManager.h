@@ -16,6 +16,19 @@ You should have received a copy of the GNU General Public License along with
 FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
+/**
+ * class AnimationManager
+ *
+ * Keeps one AnimationSet per animation file, shared by everything that uses it.
+ * Users hold a reference count on each set, either by name or through a Handle returned by increaseCount().
+ *
+ * Names are found through a hash table. A Handle refers to a slot in the registry directly; slots are reused
+ * once a set is removed, so each Handle carries the slot's generation to detect that it is out of date.
+ *
+ * Sets that are no longer referenced are only deleted by cleanUp() after EVICTION_DELAY milliseconds,
+ * so that animations which are used again soon, such as those of repeated powers, aren't loaded again.
+ */
+
 #ifndef ANIMATION_MANAGER_H
 #define ANIMATION_MANAGER_H
 
@@ -24,12 +37,21 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 class AnimationSet;
 
 class AnimationManager {
-private:
-	std::vector<AnimationSet*> sets;
-	std::vector<std::string> names;
-	std::vector<int> counts;
-
 public:
+	class Handle {
+	public:
+		size_t index;
+		unsigned generation;
+
+		Handle()
+			: index(0)
+			, generation(0) {
+		}
+		bool isValid() const { return generation != 0; }
+	};
+
+	static const Uint32 EVICTION_DELAY = 5000;
+
 	AnimationManager();
 	~AnimationManager();
 
@@ -37,10 +59,58 @@ public:
 	 * @param name: the filename of what to load starting below the animations folder.
 	 */
 	AnimationSet *getAnimationSet(const std::string &name);
+	AnimationSet *getAnimationSet(const Handle& handle);
 
 	void decreaseCount(const std::string &name);
-	void increaseCount(const std::string &name);
+	void decreaseCount(const Handle& handle);
+	Handle increaseCount(const std::string &name);
+
+	// deletes the sets that haven't been referenced for EVICTION_DELAY milliseconds
 	void cleanUp();
+
+	// deletes all sets that aren't referenced, such as before their images become invalid
+	void clearUnused();
+
+private:
+	static const size_t NO_ENTRY = static_cast<size_t>(-1);
+
+	class Entry {
+	public:
+		std::string name;
+		AnimationSet *set;
+		int count;
+		unsigned generation;
+		Uint32 release_ticks;
+		bool in_use;
+		bool released; // listed in released_entries
+		size_t next; // next entry in the same hash bucket
+
+		Entry()
+			: set(NULL)
+			, count(0)
+			, generation(1)
+			, release_ticks(0)
+			, in_use(false)
+			, released(false)
+			, next(NO_ENTRY) {
+		}
+	};
+
+	static Uint32 hashName(const std::string &name);
+
+	size_t findEntry(const std::string &name) const;
+	size_t findEntry(const Handle& handle) const;
+	size_t addEntry(const std::string &name);
+	void removeEntry(size_t index);
+	void releaseEntry(size_t index);
+	void removeUnused(Uint32 delay);
+	void rehash(size_t bucket_count);
+
+	std::vector<Entry> entries;
+	std::vector<size_t> free_entries;
+	std::vector<size_t> buckets; // first entry of each bucket
+	std::vector<size_t> released_entries; // entries whose count has dropped to 0
+	size_t entry_count;
 };
 
 #endif // __ANIMATION_MANAGER__
@@ -119,7 +119,8 @@ void AnimationSet::load() {
 					Utils::Exit(128);
 				}
 
-				sprite = render_device->loadImage(parser.val, RenderDevice::ERROR_NORMAL);
+				// animations only use explicit frame rects, so the image doesn't need to be ready yet
+				sprite = render_device->loadImageAsync(parser.val, RenderDevice::ERROR_NORMAL);
 			}
 			else if (parser.key == "render_size") {
 				// @ATTR render_size|int, int : Width, Height|Width and height of animation.
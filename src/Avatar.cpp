@@ -44,6 +44,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MessageEngine.h"
 #include "ModManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "SaveLoad.h"
 #include "Settings.h"
@@ -256,6 +257,9 @@ void Avatar::loadGraphics(std::vector<Layer_gfx> _img_gfx) {
 		}
 	}
 	anim->cleanUp();
+
+	// the layer images were decoded in parallel; don't draw the avatar without them
+	render_device->waitForImageLoads();
 }
 
 /**
@@ -359,6 +363,8 @@ void Avatar::set_direction() {
  * @param npc True if the player is talking to an NPC. Can limit ability to move/attack in certain conditions
  */
 void Avatar::logic(std::vector<ActionData> &action_queue, bool restrict_power_use) {
+	PROFILER_ZONE("Avatar::logic");
+
 	// clear current space to allow correct movement
 	mapr->collider.unblock(stats.pos.x, stats.pos.y);
 
@@ -929,6 +935,7 @@ void Avatar::transform() {
 	loadSoundsFromStatBlock(charmed_stats);
 	loadStepFX("NULL");
 
+	stats.refresh_base = true;
 	stats.applyEffects();
 
 	transform_pos = stats.pos;
@@ -1000,6 +1007,7 @@ void Avatar::untransform() {
 	charmed_stats = NULL;
 	hero_stats = NULL;
 
+	stats.refresh_base = true;
 	stats.applyEffects();
 	stats.untransform_on_hit = false;
 }
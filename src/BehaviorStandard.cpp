@@ -39,6 +39,8 @@ BehaviorStandard::BehaviorStandard(Enemy *_e)
 	, collided(false)
 	, path_found(false)
 	, chance_calc_path(0)
+	, path_request(PathRequestQueue::NO_REQUEST)
+	, nearby()
 	, target_dist(0)
 	, pursue_pos(-1, -1)
 	, los(false)
@@ -48,6 +50,19 @@ BehaviorStandard::BehaviorStandard(Enemy *_e)
 {
 }
 
+BehaviorStandard::~BehaviorStandard() {
+	cancelPathRequest();
+}
+
+/**
+ * Drops a background path search whose result is no longer wanted, so that it can't replace a newer path
+ */
+void BehaviorStandard::cancelPathRequest() {
+	if (mapr && path_request != PathRequestQueue::NO_REQUEST)
+		mapr->path_queue.cancel(path_request);
+	path_request = PathRequestQueue::NO_REQUEST;
+}
+
 /**
  * One frame of logic for this behavior
  */
@@ -130,12 +145,17 @@ void BehaviorStandard::findTarget() {
 		target_dist = 0;
 	}
 
-	for (size_t i = 0; i < enemym->enemies.size(); ++i) {
-		if (!enemym->enemies[i]->stats.corpse && enemym->enemies[i]->stats.hero_ally) {
+	// only allies that are closer than the hero can become the target
+	nearby.clear();
+	if (target_dist > 0)
+		enemym->grid.getInRadius(e->stats.pos, target_dist, nearby);
+
+	for (size_t i = 0; i < nearby.size(); ++i) {
+		if (!nearby[i]->stats.hero && !nearby[i]->stats.corpse && nearby[i]->stats.hero_ally) {
 			//now work out the distance to the minion and compare it to the distance to the current targer (we want to target the closest ally)
-			float ally_dist = Utils::calcDist(e->stats.pos, enemym->enemies[i]->stats.pos);
+			float ally_dist = Utils::calcDist(e->stats.pos, nearby[i]->stats.pos);
 			if (ally_dist < target_dist) {
-				target_stats = &enemym->enemies[i]->stats;
+				target_stats = &nearby[i]->stats;
 				target_dist = ally_dist;
 			}
 		}
@@ -371,6 +391,9 @@ void BehaviorStandard::checkMove() {
 
 				bool recalculate_path = false;
 
+				// entities that bumped into something need their own path around it
+				bool use_flow_field = e->stats.in_combat && !fleeing && !collided;
+
 				//if theres no path, it needs to be calculated
 				if(path.empty())
 					recalculate_path = true;
@@ -398,11 +421,22 @@ void BehaviorStandard::checkMove() {
 
 				prev_target = pursue_pos;
 
+				// pick up a path that was computed in the background
+				if (path_request != PathRequestQueue::NO_REQUEST && mapr->path_queue.poll(path_request, path, path_found))
+					path_request = PathRequestQueue::NO_REQUEST;
+
 				// target first waypoint
 				if(recalculate_path) {
 					chance_calc_path = -100;
-					path.clear();
-					path_found = mapr->collider.computePath(e->stats.pos, pursue_pos, path, e->stats.movement_type, MapCollision::DEFAULT_PATH_LIMIT);
+					if (use_flow_field) {
+						cancelPathRequest();
+						path.clear();
+						path_found = mapr->collider.computeFlowPath(e->stats.pos, pursue_pos, path, e->stats.movement_type);
+					}
+					else if (path_request == PathRequestQueue::NO_REQUEST) {
+						// keep following the old path until the new one is ready
+						path_request = mapr->path_queue.request(e->stats.pos, pursue_pos, e->stats.movement_type);
+					}
 				}
 
 				if(!path.empty()) {
@@ -414,6 +448,7 @@ void BehaviorStandard::checkMove() {
 				}
 			}
 			else {
+				cancelPathRequest();
 				path.clear();
 			}
 
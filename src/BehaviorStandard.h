@@ -22,6 +22,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "EnemyBehavior.h"
 
 class Enemy;
+class Entity;
 class Point;
 
 class BehaviorStandard : public EnemyBehavior {
@@ -36,6 +37,7 @@ private:
 	virtual void checkMoveStateMove();
 	void updateState();
 	FPoint getWanderPoint();
+	void cancelPathRequest();
 
 protected:
 	//variables for patfinding
@@ -44,6 +46,10 @@ protected:
 	bool collided;
 	bool path_found;
 	int chance_calc_path;
+	int path_request;
+
+	// entities returned by grid queries
+	std::vector<Entity*> nearby;
 
 	float target_dist;
 	FPoint pursue_pos;
@@ -56,6 +62,7 @@ protected:
 
 public:
 	explicit BehaviorStandard(Enemy *_e);
+	~BehaviorStandard();
 	void logic();
 
 };
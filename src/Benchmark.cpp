@@ -0,0 +1,274 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "Avatar.h"
+#include "Benchmark.h"
+#include "Enemy.h"
+#include "EnemyGroupManager.h"
+#include "EnemyManager.h"
+#include "GameStatePlay.h"
+#include "HazardManager.h"
+#include "MapRenderer.h"
+#include "PowerManager.h"
+#include "Settings.h"
+#include "SharedGameResources.h"
+#include "SharedResources.h"
+#include "Stats.h"
+
+#include <stdio.h>
+
+const char* const Benchmark::ZONE_NAMES[Benchmark::ZONE_COUNT] = {
+	"EnemyManager::logic",
+	"HazardManager::logic",
+	"LootManager::logic",
+	"StatBlock::logic"
+};
+
+bool Benchmark::running = false;
+Uint64 Benchmark::zone_ticks[Benchmark::ZONE_COUNT];
+unsigned long Benchmark::zone_calls[Benchmark::ZONE_COUNT];
+
+Benchmark::Benchmark()
+	: ticks(1000)
+	, enemy_count(50)
+	, ally_count(0)
+	, power_id(0)
+	, power_interval(10)
+	, volley_size(1)
+	, enemies_alive(0)
+	, allies_alive(0)
+	, hazards_peak(0) {
+}
+
+Benchmark::~Benchmark() {
+}
+
+bool Benchmark::run() {
+	srand(RANDOM_SEED);
+
+	if (enemy_category.empty() && enemy_count + ally_count > 0) {
+		std::vector<std::string> categories = enemyg->getCategories();
+		if (categories.empty()) {
+			Utils::logError("Benchmark: No enemy categories were found.");
+			return false;
+		}
+		enemy_category = categories[0];
+	}
+
+	if (power_id != 0 && (power_id < 0 || static_cast<size_t>(power_id) >= powers->powers.size())) {
+		Utils::logError("Benchmark: Power %d doesn't exist.", power_id);
+		return false;
+	}
+	if (power_interval == 0)
+		power_interval = 1;
+	if (volley_size == 0)
+		volley_size = 1;
+
+	GameStatePlay* play = new GameStatePlay();
+	play->resetGame();
+
+	// the spawn map teleports the hero to the first map of the game
+	runTicks(play, settings->max_frames_per_sec);
+
+	if (!map_filename.empty()) {
+		mapr->teleportation = true;
+		mapr->teleport_mapname = map_filename;
+		mapr->teleport_destination = FPoint(-1, -1);
+		runTicks(play, settings->max_frames_per_sec);
+	}
+
+	if (!map_filename.empty() && mapr->getFilename() != map_filename) {
+		Utils::logError("Benchmark: Unable to load map '%s'.", map_filename.c_str());
+		delete play;
+		return false;
+	}
+	map_filename = mapr->getFilename();
+
+	// spawning is done outside of the timed ticks
+	spawnCreatures();
+	runTicks(play, 1);
+
+	for (int i = 0; i < ZONE_COUNT; ++i) {
+		zone_ticks[i] = 0;
+		zone_calls[i] = 0;
+	}
+	hazards_peak = 0;
+
+	Utils::logInfo("Benchmark: Running %u ticks on '%s' with %u enemies and %u allies from '%s'.", ticks, map_filename.c_str(), enemy_count, ally_count, enemy_category.c_str());
+
+	running = true;
+	Uint64 start_ticks = SDL_GetPerformanceCounter();
+
+	for (unsigned i = 0; i < ticks; ++i) {
+		if (i > 0 && i % settings->max_frames_per_sec == 0)
+			spawnCreatures();
+		if (power_id != 0 && i % power_interval == 0)
+			castPower();
+
+		runTicks(play, 1);
+	}
+
+	Uint64 end_ticks = SDL_GetPerformanceCounter();
+	running = false;
+
+	countCreatures();
+
+	writeResults(static_cast<double>(end_ticks - start_ticks) / static_cast<double>(SDL_GetPerformanceFrequency()));
+
+	delete play;
+	return true;
+}
+
+void Benchmark::runTicks(GameStatePlay* play, unsigned count) {
+	for (unsigned i = 0; i < count; ++i) {
+		// the benchmark measures combat, so the hero is kept alive
+		pc->stats.hp = pc->stats.get(Stats::HP_MAX);
+
+		play->logic();
+
+		hazards_peak = std::max(hazards_peak, hazards->h.size());
+	}
+}
+
+/**
+ * Counts the enemies and allies spawned by the benchmark that are still alive
+ */
+void Benchmark::countCreatures() {
+	enemies_alive = 0;
+	allies_alive = 0;
+
+	for (size_t i = 0; i < enemym->enemies.size(); ++i) {
+		const StatBlock& stats = enemym->enemies[i]->stats;
+		if (!stats.alive || !stats.summoned || stats.summoner != NULL)
+			continue;
+
+		if (stats.hero_ally)
+			allies_alive++;
+		else
+			enemies_alive++;
+	}
+}
+
+/**
+ * Replaces the enemies and allies that have died
+ * The new creatures are added by the next call to EnemyManager::logic()
+ */
+void Benchmark::spawnCreatures() {
+	countCreatures();
+
+	for (size_t i = enemies_alive; i < enemy_count; ++i) {
+		spawnCreature(!MapCollision::IS_ALLY);
+	}
+	for (size_t i = allies_alive; i < ally_count; ++i) {
+		spawnCreature(MapCollision::IS_ALLY);
+	}
+}
+
+void Benchmark::spawnCreature(bool hero_ally) {
+	Map_Enemy espawn(enemy_category, mapr->collider.getRandomNeighbor(Point(pc->stats.pos), SPAWN_RADIUS, !MapCollision::IGNORE_BLOCKED));
+	espawn.hero_ally = hero_ally;
+
+	// the tile may already be taken by a creature that was spawned this tick
+	if (!mapr->collider.isEmpty(espawn.pos.x, espawn.pos.y))
+		return;
+
+	mapr->collider.block(espawn.pos.x, espawn.pos.y, hero_ally);
+	powers->map_enemies.push(espawn);
+}
+
+void Benchmark::castPower() {
+	float distance = 0;
+	Enemy* nearest = enemym->getNearestEnemy(pc->stats.pos, false, &distance, static_cast<float>(SPAWN_RADIUS * 2));
+	if (!nearest)
+		return;
+
+	powers->activate(power_id, &pc->stats, nearest->stats.pos);
+
+	if (volley_size <= 1)
+		return;
+
+	// the rest of the volley is spread over the other living enemies around the hero
+	volley_targets.clear();
+	enemym->grid.getInRadius(pc->stats.pos, static_cast<float>(SPAWN_RADIUS * 2), volley_targets);
+
+	size_t count = 0;
+	for (size_t i = 0; i < volley_targets.size(); ++i) {
+		const StatBlock& stats = volley_targets[i]->stats;
+		if (stats.hero || stats.hero_ally || stats.hp <= 0 || volley_targets[i] == nearest)
+			continue;
+
+		volley_targets[count] = volley_targets[i];
+		count++;
+	}
+	volley_targets.resize(count);
+
+	for (unsigned i = 1; i < volley_size; ++i) {
+		const Entity* target = volley_targets.empty() ? nearest : volley_targets[(i-1) % volley_targets.size()];
+		powers->activate(power_id, &pc->stats, target->stats.pos);
+	}
+}
+
+void Benchmark::writeResults(double seconds) {
+	std::stringstream ss;
+	ss << "{\n";
+	ss << "\t\"map\": \"" << escapeJSON(map_filename) << "\",\n";
+	ss << "\t\"enemy_category\": \"" << escapeJSON(enemy_category) << "\",\n";
+	ss << "\t\"ticks\": " << ticks << ",\n";
+	ss << "\t\"seconds\": " << seconds << ",\n";
+	ss << "\t\"ticks_per_second\": " << (seconds > 0 ? static_cast<double>(ticks) / seconds : 0) << ",\n";
+	ss << "\t\"enemies\": " << enemy_count << ",\n";
+	ss << "\t\"enemies_alive\": " << enemies_alive << ",\n";
+	ss << "\t\"allies\": " << ally_count << ",\n";
+	ss << "\t\"allies_alive\": " << allies_alive << ",\n";
+	ss << "\t\"power\": " << power_id << ",\n";
+	ss << "\t\"volley\": " << volley_size << ",\n";
+	ss << "\t\"hazards_peak\": " << hazards_peak << ",\n";
+	ss << "\t\"zones\": {\n";
+	for (int i = 0; i < ZONE_COUNT; ++i) {
+		double ms = static_cast<double>(zone_ticks[i]) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+		ss << "\t\t\"" << ZONE_NAMES[i] << "\": { \"ms\": " << ms << ", \"calls\": " << zone_calls[i] << " }";
+		ss << (i + 1 < ZONE_COUNT ? ",\n" : "\n");
+	}
+	ss << "\t}\n";
+	ss << "}\n";
+
+	if (output_filename.empty()) {
+		printf("%s", ss.str().c_str());
+		fflush(stdout);
+		return;
+	}
+
+	std::ofstream outfile(output_filename.c_str(), std::ios::out | std::ios::trunc);
+	if (!outfile.is_open()) {
+		Utils::logError("Benchmark: Unable to write '%s'.", output_filename.c_str());
+		return;
+	}
+	outfile << ss.str();
+	outfile.close();
+
+	Utils::logInfo("Benchmark: %.1f ticks per second. Results written to '%s'.", seconds > 0 ? static_cast<double>(ticks) / seconds : 0, output_filename.c_str());
+}
+
+std::string Benchmark::escapeJSON(const std::string& str) {
+	std::string ret;
+	for (size_t i = 0; i < str.length(); ++i) {
+		if (str[i] == '"' || str[i] == '\\')
+			ret += '\\';
+		ret += str[i];
+	}
+	return ret;
+}
@@ -0,0 +1,120 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class Benchmark
+ *
+ * Measures the cost of the game logic. Started with the --benchmark command line option.
+ *
+ * A new game is started on the benchmark map, and a number of enemies and allies are spawned around the hero.
+ * GameStatePlay::logic() is then called for a fixed number of ticks, as fast as possible and without rendering.
+ * The hero is healed before every tick and may cast a power at the nearest enemy, to keep hazards in play.
+ * A volley casts the power several times at once, spread over the enemies around the hero.
+ * Dead enemies and allies are replaced once per second of game time.
+ *
+ * The results are written as JSON: ticks per second, and the time spent in the subsystems that are
+ * wrapped in BENCHMARK_ZONE(). Zones can be nested, so their times don't add up to the total.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "CommonIncludes.h"
+#include "Profiler.h"
+
+// times the rest of the scope for the benchmark, and records it as a profiler zone with the same name
+#define BENCHMARK_ZONE(zone) \
+	Benchmark::Timer benchmark_timer(zone); \
+	PROFILER_ZONE(Benchmark::ZONE_NAMES[zone])
+
+class Entity;
+class GameStatePlay;
+
+class Benchmark {
+public:
+	enum {
+		ZONE_ENEMY_LOGIC = 0,
+		ZONE_HAZARD_LOGIC = 1,
+		ZONE_LOOT_LOGIC = 2,
+		ZONE_STATBLOCK_LOGIC = 3,
+		ZONE_COUNT = 4
+	};
+
+	// adds the time until it goes out of scope to a zone; does nothing unless a benchmark is running
+	class Timer {
+	public:
+		explicit Timer(int _zone)
+			: zone(_zone)
+			, start(running ? SDL_GetPerformanceCounter() : 0) {
+		}
+		~Timer() {
+			if (start != 0) {
+				zone_ticks[zone] += SDL_GetPerformanceCounter() - start;
+				zone_calls[zone]++;
+			}
+		}
+
+	private:
+		int zone;
+		Uint64 start;
+	};
+
+	Benchmark();
+	~Benchmark();
+
+	// returns false if the scenario couldn't be set up
+	bool run();
+
+	std::string map_filename; // empty uses the map that a new game starts on
+	std::string enemy_category; // empty uses the first category in alphabetical order
+	std::string output_filename; // empty prints the results
+	unsigned ticks;
+	unsigned enemy_count;
+	unsigned ally_count;
+	int power_id; // 0 doesn't cast a power
+	unsigned power_interval;
+	unsigned volley_size; // the number of times the power is cast at once
+
+	static const char* const ZONE_NAMES[ZONE_COUNT];
+
+	static bool running;
+	static Uint64 zone_ticks[ZONE_COUNT];
+	static unsigned long zone_calls[ZONE_COUNT];
+
+private:
+	// the same scenario is spawned on every run
+	static const unsigned RANDOM_SEED = 1;
+	static const int SPAWN_RADIUS = 8;
+
+	void runTicks(GameStatePlay* play, unsigned count);
+	void countCreatures();
+	void spawnCreatures();
+	void spawnCreature(bool hero_ally);
+	void castPower();
+	void writeResults(double seconds);
+
+	static std::string escapeJSON(const std::string& str);
+
+	size_t enemies_alive;
+	size_t allies_alive;
+	size_t hazards_peak;
+
+	// reused by castPower()
+	std::vector<Entity*> volley_targets;
+};
+
+#endif // BENCHMARK_H
@@ -30,6 +30,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "CommonIncludes.h"
 #include "FileParser.h"
 #include "FontEngine.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SharedResources.h"
 #include "UtilsParsing.h"
@@ -130,6 +131,8 @@ void CombatText::addInt(int num, const FPoint& location, int displaytype) {
 }
 
 void CombatText::logic(const FPoint& _cam) {
+	PROFILER_ZONE("CombatText::logic");
+
 	cam = _cam;
 
 	for(std::vector<Combat_Text_Item>::iterator it = combat_text.begin(); it != combat_text.end(); ++it) {
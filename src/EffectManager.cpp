@@ -33,6 +33,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 EffectDef::EffectDef()
 	: id("")
+	, id_index(EffectManager::NO_ID_INDEX)
 	, type("")
 	, name("")
 	, icon(-1)
@@ -48,6 +49,7 @@ EffectDef::EffectDef()
 
 Effect::Effect()
 	: id("")
+	, id_index(EffectManager::NO_ID_INDEX)
 	, name("")
 	, icon(-1)
 	, ticks(0)
@@ -56,6 +58,7 @@ Effect::Effect()
 	, magnitude(0)
 	, magnitude_max(0)
 	, animation_name("")
+	, animation_handle()
 	, animation(NULL)
 	, item(false)
 	, trigger(-1)
@@ -80,6 +83,7 @@ Effect& Effect::operator=(const Effect& other) {
 	unloadAnimation();
 
 	id = other.id;
+	id_index = other.id_index;
 	name = other.name;
 	icon = other.icon;
 	ticks = other.ticks;
@@ -109,25 +113,32 @@ Effect::~Effect() {
 void Effect::loadAnimation(const std::string &s) {
 	if (!s.empty()) {
 		animation_name = s;
-		anim->increaseCount(animation_name);
-		AnimationSet *animationSet = anim->getAnimationSet(animation_name);
+		animation_handle = anim->increaseCount(animation_name);
+		AnimationSet *animationSet = anim->getAnimationSet(animation_handle);
 		animation = animationSet->getAnimation("");
 	}
 }
 
 void Effect::unloadAnimation() {
 	if (animation) {
-		if (!animation_name.empty())
-			anim->decreaseCount(animation_name);
+		if (animation_handle.isValid())
+			anim->decreaseCount(animation_handle);
+		animation_handle = AnimationManager::Handle();
 		delete animation;
 		animation = NULL;
 	}
 }
 
+const size_t EffectManager::NO_ID_INDEX;
+std::map<std::string, size_t> EffectManager::id_indexes;
+
 EffectManager::EffectManager()
-	: bonus(std::vector<int>(Stats::COUNT + eset->damage_types.count, 0))
+	: bonus_dirty(false)
+	, stat_effect_count(0)
+	, bonus(std::vector<int>(Stats::COUNT + eset->damage_types.count, 0))
 	, bonus_resist(std::vector<int>(eset->elements.list.size(), 0))
 	, bonus_primary(std::vector<int>(eset->primary_stats.list.size(), 0))
+	, bonus_changed(true)
 	, triggered_others(false)
 	, triggered_block(false)
 	, triggered_hit(false)
@@ -135,6 +146,10 @@ EffectManager::EffectManager()
 	, triggered_joincombat(false)
 	, triggered_death(false)
 	, refresh_stats(false) {
+	for (int i = 0; i < Effect::TYPE_COUNT; ++i) {
+		type_counts[i] = 0;
+	}
+
 	clearStatus();
 }
 
@@ -163,7 +178,9 @@ void EffectManager::clearStatus() {
 	death_sentence = false;
 	fear = false;
 	knockback_speed = 0;
+}
 
+void EffectManager::clearBonus() {
 	for (unsigned i=0; i<Stats::COUNT + eset->damage_types.count; i++) {
 		bonus[i] = 0;
 	}
@@ -175,6 +192,42 @@ void EffectManager::clearStatus() {
 	for (unsigned i=0; i<bonus_primary.size(); i++) {
 		bonus_primary[i] = 0;
 	}
+
+	bonus_changed = true;
+}
+
+/**
+ * Totals up the stat bonuses of the active effects
+ * The stat effects don't change once they are added, so this is only done when effect_list changes
+ */
+void EffectManager::calcBonus() {
+	clearBonus();
+
+	const int stat_end = Effect::TYPE_COUNT + Stats::COUNT + static_cast<int>(eset->damage_types.count);
+	const int resist_end = stat_end + static_cast<int>(eset->elements.list.size());
+
+	for (size_t i = 0; i < effect_list.size(); ++i) {
+		const int type = effect_list[i].type;
+
+		if (effect_list[i].duration < 0 || type < Effect::TYPE_COUNT)
+			continue;
+
+		// @TYPE ${STATNAME}|Increases ${STATNAME}, where ${STATNAME} is any of the base stats. Examples: hp, avoidance, xp_gain
+		// @TYPE ${DAMAGE_TYPE}|Increases a damage min or max, where ${DAMAGE_TYPE} is any 'min' or 'max' value found in engine/damage_types.txt. Example: dmg_melee_min
+		if (type < stat_end) {
+			bonus[type - Effect::TYPE_COUNT] += effect_list[i].magnitude;
+		}
+		// @TYPE ${ELEMENT}_resist|Increase Resistance % to ${ELEMENT}, where ${ELEMENT} is any found in engine/elements.txt. Example: fire_resist
+		else if (type < resist_end) {
+			bonus_resist[type - stat_end] += effect_list[i].magnitude;
+		}
+		// @TYPE ${PRIMARYSTAT}|Increases ${PRIMARYSTAT}, where ${PRIMARYSTAT} is any of the primary stats defined in engine/primary_stats.txt. Example: physical
+		else {
+			bonus_primary[type - resist_end] += effect_list[i].magnitude;
+		}
+	}
+
+	bonus_dirty = false;
 }
 
 void EffectManager::logic() {
@@ -196,77 +249,85 @@ void EffectManager::logic() {
 				}
 			}
 
-			// @TYPE damage|Damage per second
-			if (effect_list[i].type == Effect::DAMAGE && effect_list[i].ticks % settings->max_frames_per_sec == 1) damage += effect_list[i].magnitude;
-			// @TYPE damage_percent|Damage per second (percentage of max HP)
-			else if (effect_list[i].type == Effect::DAMAGE_PERCENT && effect_list[i].ticks % settings->max_frames_per_sec == 1) damage_percent += effect_list[i].magnitude;
-			// @TYPE hpot|HP restored per second
-			else if (effect_list[i].type == Effect::HPOT && effect_list[i].ticks % settings->max_frames_per_sec == 1) hpot += effect_list[i].magnitude;
-			// @TYPE hpot_percent|HP restored per second (percentage of max HP)
-			else if (effect_list[i].type == Effect::HPOT_PERCENT && effect_list[i].ticks % settings->max_frames_per_sec == 1) hpot_percent += effect_list[i].magnitude;
-			// @TYPE mpot|MP restored per second
-			else if (effect_list[i].type == Effect::MPOT && effect_list[i].ticks % settings->max_frames_per_sec == 1) mpot += effect_list[i].magnitude;
-			// @TYPE mpot_percent|MP restored per second (percentage of max MP)
-			else if (effect_list[i].type == Effect::MPOT_PERCENT && effect_list[i].ticks % settings->max_frames_per_sec == 1) mpot_percent += effect_list[i].magnitude;
-			// @TYPE speed|Changes movement speed. A magnitude of 100 is 100% speed (aka normal speed).
-			else if (effect_list[i].type == Effect::SPEED) speed = (static_cast<float>(effect_list[i].magnitude) * speed) / 100.f;
-			// @TYPE attack_speed|Changes attack speed. A magnitude of 100 is 100% speed (aka normal speed).
-			// attack speed is calculated when getAttackSpeed() is called
-
-			// @TYPE immunity|Applies all immunity effects. Magnitude is ignored.
-			else if (effect_list[i].type == Effect::IMMUNITY) {
-				immunity_damage = true;
-				immunity_slow = true;
-				immunity_stun = true;
-				immunity_hp_steal = true;
-				immunity_mp_steal = true;
-				immunity_knockback = true;
-				immunity_damage_reflect = true;
-				immunity_stat_debuff = true;
-			}
-			// @TYPE immunity_damage|Removes and prevents damage over time. Magnitude is ignored.
-			else if (effect_list[i].type == Effect::IMMUNITY_DAMAGE) immunity_damage = true;
-			// @TYPE immunity_slow|Removes and prevents slow effects. Magnitude is ignored.
-			else if (effect_list[i].type == Effect::IMMUNITY_SLOW) immunity_slow = true;
-			// @TYPE immunity_stun|Removes and prevents stun effects. Magnitude is ignored.
-			else if (effect_list[i].type == Effect::IMMUNITY_STUN) immunity_stun = true;
-			// @TYPE immunity_hp_steal|Prevents HP stealing. Magnitude is ignored.
-			else if (effect_list[i].type == Effect::IMMUNITY_HP_STEAL) immunity_hp_steal = true;
-			// @TYPE immunity_mp_steal|Prevents MP stealing. Magnitude is ignored.
-			else if (effect_list[i].type == Effect::IMMUNITY_MP_STEAL) immunity_mp_steal = true;
-			// @TYPE immunity_knockback|Removes and prevents knockback effects. Magnitude is ignored.
-			else if (effect_list[i].type == Effect::IMMUNITY_KNOCKBACK) immunity_knockback = true;
-			// @TYPE immunity_damage_reflect|Prevents damage reflection. Magnitude is ignored.
-			else if (effect_list[i].type == Effect::IMMUNITY_DAMAGE_REFLECT) immunity_damage_reflect = true;
-			// @TYPE immunity_stat_debuff|Prevents stat value altering effects that have a magnitude less than 0. Magnitude is ignored.
-			else if (effect_list[i].type == Effect::IMMUNITY_STAT_DEBUFF) immunity_stat_debuff = true;
-
-			// @TYPE stun|Can't move or attack. Being attacked breaks stun.
-			else if (effect_list[i].type == Effect::STUN) stun = true;
-			// @TYPE revive|Revives the player. Typically attached to a power that triggers when the player dies.
-			else if (effect_list[i].type == Effect::REVIVE) revive = true;
-			// @TYPE convert|Causes an enemy or an ally to switch allegiance
-			else if (effect_list[i].type == Effect::CONVERT) convert = true;
-			// @TYPE fear|Causes enemies to run away
-			else if (effect_list[i].type == Effect::FEAR) fear = true;
-			// @TYPE knockback|Pushes the target away from the source caster. Speed is the given value divided by the framerate cap.
-			else if (effect_list[i].type == Effect::KNOCKBACK) knockback_speed = static_cast<float>(effect_list[i].magnitude)/static_cast<float>(settings->max_frames_per_sec);
-
-			// @TYPE ${STATNAME}|Increases ${STATNAME}, where ${STATNAME} is any of the base stats. Examples: hp, avoidance, xp_gain
-			// @TYPE ${DAMAGE_TYPE}|Increases a damage min or max, where ${DAMAGE_TYPE} is any 'min' or 'max' value found in engine/damage_types.txt. Example: dmg_melee_min
-			else if (effect_list[i].type >= Effect::TYPE_COUNT && effect_list[i].type < Effect::TYPE_COUNT + Stats::COUNT + static_cast<int>(eset->damage_types.count)) {
-				bonus[effect_list[i].type - Effect::TYPE_COUNT] += effect_list[i].magnitude;
-			}
-			// else if (effect_list[i].type >= Effect::TYPE_COUNT + Stats::COUNT && effect_list[i].type < Effect::TYPE_COUNT + Stats::COUNT + static_cast<int>(eset->damage_types.count)) {
-			// 	bonus[effect_list[i].type - Effect::TYPE_COUNT] += effect_list[i].magnitude;
-			// }
-			// @TYPE ${ELEMENT}_resist|Increase Resistance % to ${ELEMENT}, where ${ELEMENT} is any found in engine/elements.txt. Example: fire_resist
-			else if (effect_list[i].type >= Effect::TYPE_COUNT + Stats::COUNT + static_cast<int>(eset->damage_types.count) && effect_list[i].type < Effect::TYPE_COUNT + Stats::COUNT + static_cast<int>(eset->damage_types.count) + static_cast<int>(eset->elements.list.size())) {
-				bonus_resist[effect_list[i].type - Effect::TYPE_COUNT - Stats::COUNT - eset->damage_types.count] += effect_list[i].magnitude;
-			}
-			// @TYPE ${PRIMARYSTAT}|Increases ${PRIMARYSTAT}, where ${PRIMARYSTAT} is any of the primary stats defined in engine/primary_stats.txt. Example: physical
-			else if (effect_list[i].type >= Effect::TYPE_COUNT) {
-				bonus_primary[effect_list[i].type - Effect::TYPE_COUNT - Stats::COUNT - eset->damage_types.count - eset->elements.list.size()] += effect_list[i].magnitude;
+			const Effect& e = effect_list[i];
+			const bool per_second = (e.ticks % settings->max_frames_per_sec == 1);
+
+			switch (e.type) {
+				// @TYPE damage|Damage per second
+				case Effect::DAMAGE:
+					if (per_second) damage += e.magnitude;
+					break;
+				// @TYPE damage_percent|Damage per second (percentage of max HP)
+				case Effect::DAMAGE_PERCENT:
+					if (per_second) damage_percent += e.magnitude;
+					break;
+				// @TYPE hpot|HP restored per second
+				case Effect::HPOT:
+					if (per_second) hpot += e.magnitude;
+					break;
+				// @TYPE hpot_percent|HP restored per second (percentage of max HP)
+				case Effect::HPOT_PERCENT:
+					if (per_second) hpot_percent += e.magnitude;
+					break;
+				// @TYPE mpot|MP restored per second
+				case Effect::MPOT:
+					if (per_second) mpot += e.magnitude;
+					break;
+				// @TYPE mpot_percent|MP restored per second (percentage of max MP)
+				case Effect::MPOT_PERCENT:
+					if (per_second) mpot_percent += e.magnitude;
+					break;
+				// @TYPE speed|Changes movement speed. A magnitude of 100 is 100% speed (aka normal speed).
+				case Effect::SPEED:
+					speed = (static_cast<float>(e.magnitude) * speed) / 100.f;
+					break;
+				// @TYPE attack_speed|Changes attack speed. A magnitude of 100 is 100% speed (aka normal speed).
+				// attack speed is calculated when getAttackSpeed() is called
+
+				// @TYPE immunity|Applies all immunity effects. Magnitude is ignored.
+				case Effect::IMMUNITY:
+					immunity_damage = true;
+					immunity_slow = true;
+					immunity_stun = true;
+					immunity_hp_steal = true;
+					immunity_mp_steal = true;
+					immunity_knockback = true;
+					immunity_damage_reflect = true;
+					immunity_stat_debuff = true;
+					break;
+				// @TYPE immunity_damage|Removes and prevents damage over time. Magnitude is ignored.
+				case Effect::IMMUNITY_DAMAGE: immunity_damage = true; break;
+				// @TYPE immunity_slow|Removes and prevents slow effects. Magnitude is ignored.
+				case Effect::IMMUNITY_SLOW: immunity_slow = true; break;
+				// @TYPE immunity_stun|Removes and prevents stun effects. Magnitude is ignored.
+				case Effect::IMMUNITY_STUN: immunity_stun = true; break;
+				// @TYPE immunity_hp_steal|Prevents HP stealing. Magnitude is ignored.
+				case Effect::IMMUNITY_HP_STEAL: immunity_hp_steal = true; break;
+				// @TYPE immunity_mp_steal|Prevents MP stealing. Magnitude is ignored.
+				case Effect::IMMUNITY_MP_STEAL: immunity_mp_steal = true; break;
+				// @TYPE immunity_knockback|Removes and prevents knockback effects. Magnitude is ignored.
+				case Effect::IMMUNITY_KNOCKBACK: immunity_knockback = true; break;
+				// @TYPE immunity_damage_reflect|Prevents damage reflection. Magnitude is ignored.
+				case Effect::IMMUNITY_DAMAGE_REFLECT: immunity_damage_reflect = true; break;
+				// @TYPE immunity_stat_debuff|Prevents stat value altering effects that have a magnitude less than 0. Magnitude is ignored.
+				case Effect::IMMUNITY_STAT_DEBUFF: immunity_stat_debuff = true; break;
+
+				// @TYPE stun|Can't move or attack. Being attacked breaks stun.
+				case Effect::STUN: stun = true; break;
+				// @TYPE revive|Revives the player. Typically attached to a power that triggers when the player dies.
+				case Effect::REVIVE: revive = true; break;
+				// @TYPE convert|Causes an enemy or an ally to switch allegiance
+				case Effect::CONVERT: convert = true; break;
+				// @TYPE fear|Causes enemies to run away
+				case Effect::FEAR: fear = true; break;
+				// @TYPE knockback|Pushes the target away from the source caster. Speed is the given value divided by the framerate cap.
+				case Effect::KNOCKBACK:
+					knockback_speed = static_cast<float>(e.magnitude)/static_cast<float>(settings->max_frames_per_sec);
+					break;
+
+				// stat bonuses are totaled by calcBonus()
+				default:
+					break;
 			}
 		}
 		// expire shield effects
@@ -294,6 +355,9 @@ void EffectManager::logic() {
 				effect_list[i].animation->advanceFrame();
 		}
 	}
+
+	if (bonus_dirty)
+		calcBonus();
 }
 
 void EffectManager::addEffect(EffectDef &effect, int duration, int magnitude, int source_type, size_t power_id) {
@@ -307,6 +371,10 @@ void EffectManager::addItemEffect(EffectDef &effect, int duration, int magnitude
 
 void EffectManager::addEffectInternal(EffectDef &effect, int duration, int magnitude, int source_type, bool item, size_t power_id) {
 	int effect_type = getType(effect.type);
+
+	// effects that aren't from powers/effects.txt are interned here
+	if (effect.id_index == NO_ID_INDEX)
+		effect.id_index = getIDIndex(effect.id);
 	refresh_stats = true;
 
 	// if we're already immune, don't add negative effects
@@ -337,7 +405,7 @@ void EffectManager::addEffectInternal(EffectDef &effect, int duration, int magni
 	size_t passive_id = (power_id > 0 && powers->powers[power_id].passive) ? power_id : 0;
 
 	for (size_t i=effect_list.size(); i>0; i--) {
-		if (effect_list[i-1].id == effect.id) {
+		if (effect_list[i-1].id_index == effect.id_index) {
 			if (trigger > -1 && effect_list[i-1].trigger == trigger)
 				return; // trigger effects can only be cast once per trigger
 
@@ -386,6 +454,7 @@ void EffectManager::addEffectInternal(EffectDef &effect, int duration, int magni
 	Effect e;
 
 	e.id = effect.id;
+	e.id_index = effect.id_index;
 	e.name = effect.name;
 	e.icon = effect.icon;
 	e.type = effect_type;
@@ -418,11 +487,46 @@ void EffectManager::addEffectInternal(EffectDef &effect, int duration, int magni
 		effect_list.insert(effect_list.begin() + insert_pos, e);
 	else
 		effect_list.push_back(e);
+
+	countEffect(e, true);
+	bonus_dirty = true;
 }
 
 void EffectManager::removeEffect(size_t id) {
+	countEffect(effect_list[id], false);
 	effect_list.erase(effect_list.begin()+id);
 	refresh_stats = true;
+	bonus_dirty = true;
+}
+
+/**
+ * Keeps the per-id and per-type counts in step with effect_list
+ */
+void EffectManager::countEffect(const Effect& effect, bool added) {
+	if (effect.id_index >= id_counts.size())
+		id_counts.resize(effect.id_index + 1, 0);
+
+	if (added)
+		id_counts[effect.id_index]++;
+	else if (id_counts[effect.id_index] > 0)
+		id_counts[effect.id_index]--;
+
+	if (effect.type > Effect::TYPE_COUNT) {
+		if (added)
+			stat_effect_count++;
+		else if (stat_effect_count > 0)
+			stat_effect_count--;
+	}
+
+	if (effect.type < 0 || effect.type >= Effect::TYPE_COUNT)
+		return;
+
+	if (added)
+		type_counts[effect.type]++;
+	else if (type_counts[effect.type] > 0)
+		type_counts[effect.type]--;
+
+	types.set(effect.type, type_counts[effect.type] > 0);
 }
 
 void EffectManager::removeEffectType(const int type) {
@@ -437,8 +541,11 @@ void EffectManager::removeEffectPassive(size_t id) {
 	}
 }
 
-void EffectManager::removeEffectID(const std::vector< std::pair<std::string, int> >& remove_effects) {
+void EffectManager::removeEffectID(const std::vector< std::pair<size_t, int> >& remove_effects) {
 	for (size_t i = 0; i < remove_effects.size(); i++) {
+		if (!hasEffect(remove_effects[i].first, 1))
+			continue;
+
 		int count = remove_effects[i].second;
 		bool remove_all = (count == 0 ? true : false);
 
@@ -446,7 +553,7 @@ void EffectManager::removeEffectID(const std::vector< std::pair<std::string, int
 			if (!remove_all && count <= 0)
 				break;
 
-			if (effect_list[j-1].id == remove_effects[i].first) {
+			if (effect_list[j-1].id_index == remove_effects[i].first) {
 				removeEffect(j-1);
 				count--;
 			}
@@ -460,6 +567,8 @@ void EffectManager::clearEffects() {
 	}
 
 	clearStatus();
+	clearBonus();
+	bonus_dirty = false;
 
 	// clear triggers
 	triggered_others = triggered_block = triggered_hit = triggered_halfdeath = triggered_joincombat = triggered_death = false;
@@ -575,12 +684,15 @@ int EffectManager::getType(const std::string& type) {
 }
 
 bool EffectManager::isDebuffed() {
+	if (types[Effect::DAMAGE] || types[Effect::DAMAGE_PERCENT] || types[Effect::STUN] || types[Effect::KNOCKBACK])
+		return true;
+
+	// slows and stat penalties depend on their magnitude, which can change as effects stack
+	if (!types[Effect::SPEED] && stat_effect_count == 0)
+		return false;
+
 	for (size_t i=effect_list.size(); i > 0; i--) {
-		if (effect_list[i-1].type == Effect::DAMAGE) return true;
-		else if (effect_list[i-1].type == Effect::DAMAGE_PERCENT) return true;
-		else if (effect_list[i-1].type == Effect::SPEED && effect_list[i-1].magnitude_max < 100) return true;
-		else if (effect_list[i-1].type == Effect::STUN) return true;
-		else if (effect_list[i-1].type == Effect::KNOCKBACK) return true;
+		if (effect_list[i-1].type == Effect::SPEED && effect_list[i-1].magnitude_max < 100) return true;
 		else if (effect_list[i-1].type > Effect::TYPE_COUNT && effect_list[i-1].magnitude_max < 0) return true;
 	}
 	return false;
@@ -616,23 +728,19 @@ void EffectManager::getCurrentAlpha(uint8_t& alpha_mod) {
 	}
 }
 
-bool EffectManager::hasEffect(const std::string& id, int req_count) {
-	if (req_count <= 0)
+bool EffectManager::hasEffect(size_t id_index, int req_count) {
+	if (req_count <= 0 || id_index >= id_counts.size())
 		return false;
 
-	int count = 0;
-
-	for (size_t i=effect_list.size(); i > 0; i--) {
-		if (effect_list[i-1].id == id)
-			count++;
-	}
-
-	return count >= req_count;
+	return id_counts[id_index] >= req_count;
 }
 
 float EffectManager::getAttackSpeed(const std::string& anim_name) {
 	float attack_speed = 100;
 
+	if (!types[Effect::ATTACK_SPEED])
+		return attack_speed;
+
 	for (size_t i = 0; i < effect_list.size(); ++i) {
 		if (effect_list[i].type != Effect::ATTACK_SPEED)
 			continue;
@@ -644,3 +752,21 @@ float EffectManager::getAttackSpeed(const std::string& anim_name) {
 
 	return attack_speed;
 }
+
+size_t EffectManager::getIDIndex(const std::string& id) {
+	std::map<std::string, size_t>::iterator it = id_indexes.find(id);
+	if (it != id_indexes.end())
+		return it->second;
+
+	size_t index = id_indexes.size();
+	id_indexes[id] = index;
+	return index;
+}
+
+size_t EffectManager::findIDIndex(const std::string& id) {
+	std::map<std::string, size_t>::iterator it = id_indexes.find(id);
+	if (it != id_indexes.end())
+		return it->second;
+
+	return NO_ID_INDEX;
+}
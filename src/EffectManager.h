@@ -24,9 +24,12 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef EFFECT_MANAGER_H
 #define EFFECT_MANAGER_H
 
+#include "AnimationManager.h"
 #include "CommonIncludes.h"
 #include "Utils.h"
 
+#include <bitset>
+
 class Animation;
 class Hazard;
 
@@ -71,6 +74,7 @@ public:
 	void unloadAnimation();
 
 	std::string id;
+	size_t id_index; // see EffectManager::getIDIndex()
 	std::string name;
 	int icon;
 	int ticks;
@@ -79,6 +83,7 @@ public:
 	int magnitude;
 	int magnitude_max;
 	std::string animation_name;
+	AnimationManager::Handle animation_handle;
 	Animation* animation;
 	bool item;
 	int trigger;
@@ -96,6 +101,7 @@ public:
 	EffectDef();
 
 	std::string id;
+	size_t id_index; // EffectManager::NO_ID_INDEX until the id has been interned
 	std::string type;
 	std::string name;
 	int icon;
@@ -112,10 +118,23 @@ public:
 class EffectManager {
 private:
 	void removeEffect(size_t id);
+	void countEffect(const Effect& effect, bool added);
 	void clearStatus();
+	void clearBonus();
+	void calcBonus();
 	int getType(const std::string& type);
 	void addEffectInternal(EffectDef &effect, int duration, int magnitude, int source_type, bool item, size_t power_id);
 
+	bool bonus_dirty; // effect_list has changed since the stat bonuses were last totaled
+
+	// the number of effects in effect_list with each interned id, and of each effect type
+	std::vector<unsigned short> id_counts;
+	unsigned short type_counts[Effect::TYPE_COUNT];
+	std::bitset<Effect::TYPE_COUNT> types; // the effect types in effect_list; stat bonus types aren't included
+	size_t stat_effect_count; // the number of stat bonus effects in effect_list
+
+	static std::map<std::string, size_t> id_indexes;
+
 public:
 	EffectManager();
 	~EffectManager();
@@ -124,7 +143,7 @@ public:
 	void addItemEffect(EffectDef &effect, int duration, int magnitude);
 	void removeEffectType(const int type);
 	void removeEffectPassive(size_t id);
-	void removeEffectID(const std::vector< std::pair<std::string, int> >& remove_effects);
+	void removeEffectID(const std::vector< std::pair<size_t, int> >& remove_effects);
 	void clearEffects();
 	void clearNegativeEffects(int type = -1);
 	void clearItemEffects();
@@ -133,7 +152,7 @@ public:
 	bool isDebuffed();
 	void getCurrentColor(Color& color_mod);
 	void getCurrentAlpha(uint8_t& alpha_mod);
-	bool hasEffect(const std::string& id, int req_count);
+	bool hasEffect(size_t id_index, int req_count);
 	float getAttackSpeed(const std::string& anim_name);
 
 	std::vector<Effect> effect_list;
@@ -163,6 +182,7 @@ public:
 	std::vector<int> bonus;
 	std::vector<int> bonus_resist;
 	std::vector<int> bonus_primary;
+	bool bonus_changed; // the bonuses above have been recalculated; cleared by StatBlock::applyEffects()
 
 	bool triggered_others;
 	bool triggered_block;
@@ -174,6 +194,13 @@ public:
 	bool refresh_stats;
 
 	static const int NO_POWER = 0;
+	static const size_t NO_ID_INDEX = static_cast<size_t>(-1);
+
+	// returns the interned index of an effect id, which is added if it hasn't been seen before
+	static size_t getIDIndex(const std::string& id);
+
+	// returns the interned index of an effect id, or NO_ID_INDEX if it hasn't been seen before
+	static size_t findIDIndex(const std::string& id);
 };
 
 #endif
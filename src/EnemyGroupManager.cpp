@@ -129,3 +129,12 @@ std::vector<Enemy_Level> EnemyGroupManager::getEnemiesInCategory(const std::stri
 	}
 	return it->second;
 }
+
+std::vector<std::string> EnemyGroupManager::getCategories() const {
+	std::vector<std::string> categories;
+	std::map<std::string, std::vector<Enemy_Level> >::const_iterator it;
+	for (it = _categories.begin(); it != _categories.end(); ++it) {
+		categories.push_back(it->first);
+	}
+	return categories;
+}
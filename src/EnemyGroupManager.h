@@ -62,6 +62,12 @@ public:
 	 */
 	std::vector<Enemy_Level> getEnemiesInCategory(const std::string& category) const;
 
+	/** To get the names of all enemy categories
+	 *
+	 * @return Category names in alphabetical order.
+	 */
+	std::vector<std::string> getCategories() const;
+
 private:
 
 	/** Container to store enemy data */
@@ -24,6 +24,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Avatar.h"
 #include "BehaviorAlly.h"
 #include "BehaviorStandard.h"
+#include "Benchmark.h"
 #include "CampaignManager.h"
 #include "Enemy.h"
 #include "EnemyBehavior.h"
@@ -61,6 +62,15 @@ void EnemyManager::loadAnimations(Enemy *e) {
 	e->activeAnimation = e->animationSet->getAnimation("");
 }
 
+/**
+ * Enemies are only ever appended, so enemy_index stays valid until the list is cleared
+ */
+void EnemyManager::addEnemy(Enemy *e) {
+	e->enemy_index = enemies.size();
+	enemies.push_back(e);
+	grid.add(e);
+}
+
 Enemy *EnemyManager::getEnemyPrototype(const std::string& type_id) {
 	Enemy* e = new Enemy(prototypes.at(loadEnemyPrototype(type_id)));
 	anim->increaseCount(e->stats.animations);
@@ -124,6 +134,10 @@ void EnemyManager::handleNewMap () {
 	Map_Enemy me;
 	std::queue<Enemy *> allies;
 
+	// empty the grid before any of its entities are deleted
+	grid.init(mapr->w, mapr->h);
+	grid.add(pc);
+
 	// delete existing enemies
 	for (unsigned int i=0; i < enemies.size(); i++) {
 		anim->decreaseCount(enemies[i]->animationSet->getName());
@@ -179,7 +193,7 @@ void EnemyManager::handleNewMap () {
 		e->stats.invincible_requires_status = me.invincible_requires_status;
 		e->stats.invincible_requires_not_status = me.invincible_requires_not_status;
 
-		enemies.push_back(e);
+		addEnemy(e);
 
 		mapr->collider.block(me.pos.x, me.pos.y, !MapCollision::IS_ALLY);
 	}
@@ -197,7 +211,7 @@ void EnemyManager::handleNewMap () {
 		e->stats.pos = spawn_pos;
 		e->stats.direction = pc->stats.direction;
 
-		enemies.push_back(e);
+		addEnemy(e);
 
 		mapr->collider.block(e->stats.pos.x, e->stats.pos.y, MapCollision::IS_ALLY);
 	}
@@ -370,7 +384,7 @@ void EnemyManager::handleSpawn() {
 			}
 		}
 
-		enemies.push_back(e);
+		addEnemy(e);
 
 		mapr->collider.block(e->stats.pos.x, e->stats.pos.y, e->stats.hero_ally);
 	}
@@ -389,6 +403,7 @@ bool EnemyManager::checkPartyMembers() {
  * perform logic() for all enemies
  */
 void EnemyManager::logic() {
+	BENCHMARK_ZONE(Benchmark::ZONE_ENEMY_LOGIC);
 
 	if (player_blocked) {
 		player_blocked_timer.tick();
@@ -398,62 +413,119 @@ void EnemyManager::logic() {
 
 	handleSpawn();
 
+	// the hero has already moved this frame
+	grid.update(pc);
+
 	std::vector<Enemy*>::iterator it;
 	for (it = enemies.begin(); it != enemies.end(); ++it) {
 		// new actions this round
 		(*it)->stats.hero_stealth = hero_stealth;
 		(*it)->logic();
+
+		// catches knockback and teleports, which don't go through Entity::move()
+		grid.update(*it);
 	}
 }
 
 Enemy* EnemyManager::enemyFocus(const Point& mouse, const FPoint& cam, bool alive_only) {
+	// only enemies that are on screen can be under the mouse
+	// the padding accounts for large sprites that extend past the edge of the screen
+	FPoint corner[4];
+	corner[0] = Utils::screenToMap(0, 0, cam.x, cam.y);
+	corner[1] = Utils::screenToMap(settings->view_w, 0, cam.x, cam.y);
+	corner[2] = Utils::screenToMap(0, settings->view_h, cam.x, cam.y);
+	corner[3] = Utils::screenToMap(settings->view_w, settings->view_h, cam.x, cam.y);
+
+	FPoint top_left = corner[0];
+	FPoint bottom_right = corner[0];
+	for (int i = 1; i < 4; ++i) {
+		top_left.x = std::min(top_left.x, corner[i].x);
+		top_left.y = std::min(top_left.y, corner[i].y);
+		bottom_right.x = std::max(bottom_right.x, corner[i].x);
+		bottom_right.y = std::max(bottom_right.y, corner[i].y);
+	}
+	top_left.x -= 4;
+	top_left.y -= 4;
+	bottom_right.x += 4;
+	bottom_right.y += 4;
+
+	grid_results.clear();
+	grid.getInRect(top_left, bottom_right, grid_results);
+
 	Point p;
 	Rect r;
-	for(unsigned int i = 0; i < enemies.size(); i++) {
-		if(alive_only && (enemies[i]->stats.cur_state == StatBlock::ENEMY_DEAD || enemies[i]->stats.cur_state == StatBlock::ENEMY_CRITDEAD)) {
+	for(unsigned int i = 0; i < grid_results.size(); i++) {
+		if (grid_results[i]->stats.hero)
+			continue;
+
+		Enemy *enemy = static_cast<Enemy*>(grid_results[i]);
+
+		if(alive_only && (enemy->stats.cur_state == StatBlock::ENEMY_DEAD || enemy->stats.cur_state == StatBlock::ENEMY_CRITDEAD)) {
 			continue;
 		}
-		p = Utils::mapToScreen(enemies[i]->stats.pos.x, enemies[i]->stats.pos.y, cam.x, cam.y);
+		p = Utils::mapToScreen(enemy->stats.pos.x, enemy->stats.pos.y, cam.x, cam.y);
 
-		Renderable ren = enemies[i]->getRender();
+		Renderable ren = enemy->getRender();
 		r.w = ren.src.w;
 		r.h = ren.src.h;
 		r.x = p.x - ren.offset.x;
 		r.y = p.y - ren.offset.y;
 
 		if (Utils::isWithinRect(r, mouse)) {
-			Enemy *enemy = enemies[i];
 			return enemy;
 		}
 	}
 	return NULL;
 }
 
+/**
+ * Searches the grid in growing circles around pos until a matching enemy is found
+ */
 Enemy* EnemyManager::getNearestEnemy(const FPoint& pos, bool get_corpse, float *saved_distance, float max_range) {
 	Enemy* nearest = NULL;
 	float best_distance = std::numeric_limits<float>::max();
 
-	for (unsigned i=0; i<enemies.size(); i++) {
-		if(!get_corpse && (enemies[i]->stats.cur_state == StatBlock::ENEMY_DEAD || enemies[i]->stats.cur_state == StatBlock::ENEMY_CRITDEAD)) {
-			continue;
-		}
-		if (get_corpse && !enemies[i]->stats.corpse) {
-			continue;
-		}
+	// anything beyond max_range is discarded, so the search doesn't need to go further
+	// getInRadius() excludes the edge of the circle, so search slightly further than max_range
+	float search_limit = std::min(max_range + 1, grid.getMaxRadius());
+	float radius = std::min(static_cast<float>(EntityGrid::CELL_SIZE), search_limit);
+
+	while (true) {
+		grid_results.clear();
+		grid.getInRadius(pos, radius, grid_results);
+
+		for (unsigned i=0; i<grid_results.size(); i++) {
+			if (grid_results[i]->stats.hero)
+				continue;
+
+			Enemy *enemy = static_cast<Enemy*>(grid_results[i]);
+
+			if(!get_corpse && (enemy->stats.cur_state == StatBlock::ENEMY_DEAD || enemy->stats.cur_state == StatBlock::ENEMY_CRITDEAD)) {
+				continue;
+			}
+			if (get_corpse && !enemy->stats.corpse) {
+				continue;
+			}
 
-		float distance = Utils::calcDist(pos, enemies[i]->stats.pos);
-		if (distance < best_distance) {
-			best_distance = distance;
-			nearest = enemies[i];
+			float distance = Utils::calcDist(pos, enemy->stats.pos);
+			if (distance < best_distance) {
+				best_distance = distance;
+				nearest = enemy;
+			}
 		}
+
+		if (nearest || radius >= search_limit)
+			break;
+
+		radius = std::min(radius * 2, search_limit);
 	}
 
+	if (best_distance > max_range)
+		nearest = NULL;
+
 	if (nearest && saved_distance)
 		*saved_distance = best_distance;
 
-	if (!saved_distance && best_distance > max_range)
-		nearest = NULL;
-
 	return nearest;
 }
 
@@ -27,6 +27,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define ENEMY_MANAGER_H
 
 #include "CommonIncludes.h"
+#include "EntityGrid.h"
 #include "Utils.h"
 
 class Animation;
@@ -36,10 +37,14 @@ class EnemyManager {
 private:
 
 	void loadAnimations(Enemy *e);
+	void addEnemy(Enemy *e);
 
 	std::vector<std::string> anim_prefixes;
 	std::vector<std::vector<Animation*> > anim_entities;
 
+	// reused by the grid queries
+	std::vector<Entity*> grid_results;
+
 protected:
 	/**
 	 * callee is responsible for deleting returned enemy object
@@ -68,6 +73,9 @@ public:
 
 	// vars
 	std::vector<Enemy*> enemies;
+
+	// enemies, allies, corpses and the hero, bucketed by position
+	EntityGrid grid;
 	int hero_stealth;
 
 	bool player_blocked;
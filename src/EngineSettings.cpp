@@ -29,7 +29,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Utils.h"
 #include "UtilsParsing.h"
 
-void EngineSettings::load() {
+void EngineSettings::load(bool defer_errors) {
 	misc.load();
 	resolutions.load();
 	gameplay.load();
@@ -45,6 +45,18 @@ void EngineSettings::load() {
 	tileset.load();
 	widgets.load();
 	xp.load();
+
+	if (!defer_errors)
+		checkErrors();
+}
+
+void EngineSettings::checkErrors() {
+	if (tileset.units_per_pixel_x == 0 || tileset.units_per_pixel_y == 0) {
+		Utils::logError("EngineSettings: One of UNITS_PER_PIXEL values is zero! %dx%d", static_cast<int>(tileset.units_per_pixel_x), static_cast<int>(tileset.units_per_pixel_y));
+		Utils::logErrorDialog("EngineSettings: One of UNITS_PER_PIXEL values is zero! %dx%d", static_cast<int>(tileset.units_per_pixel_x), static_cast<int>(tileset.units_per_pixel_y));
+		mods->resetModConfig();
+		Utils::Exit(1);
+	}
 }
 
 void EngineSettings::Misc::load() {
@@ -72,6 +84,8 @@ void EngineSettings::Misc::load() {
 	keep_buyback_on_map_change = true;
 	sfx_unable_to_cast = "";
 	combat_aborts_npc_interact = true;
+	flow_field_pathing = true;
+	flow_field_normal_movement_only = true;
 
 	FileParser infile;
 	// @CLASS EngineSettings: Misc|Description of engine/misc.txt
@@ -154,6 +168,12 @@ void EngineSettings::Misc::load() {
 			// @ATTR combat_aborts_npc_interact|bool|If true, the NPC dialog and vendor menus will be closed if the player is attacked.
 			else if (infile.key == "combat_aborts_npc_interact")
 				combat_aborts_npc_interact = Parse::toBool(infile.val);
+			// @ATTR flow_field_pathing|bool|If true, enemies chasing the same target share a single path map instead of each computing their own path.
+			else if (infile.key == "flow_field_pathing")
+				flow_field_pathing = Parse::toBool(infile.val);
+			// @ATTR flow_field_normal_movement_only|bool|If true, flying and intangible creatures compute their own paths instead of using a shared path map.
+			else if (infile.key == "flow_field_normal_movement_only")
+				flow_field_normal_movement_only = Parse::toBool(infile.val);
 
 			else infile.error("EngineSettings: '%s' is not a valid key.", infile.key.c_str());
 		}
@@ -827,12 +847,6 @@ void EngineSettings::Tileset::load() {
 			tile_h = 32;
 		}
 	}
-	if (units_per_pixel_x == 0 || units_per_pixel_y == 0) {
-		Utils::logError("EngineSettings: One of UNITS_PER_PIXEL values is zero! %dx%d", static_cast<int>(units_per_pixel_x), static_cast<int>(units_per_pixel_y));
-		Utils::logErrorDialog("EngineSettings: One of UNITS_PER_PIXEL values is zero! %dx%d", static_cast<int>(units_per_pixel_x), static_cast<int>(units_per_pixel_y));
-		mods->resetModConfig();
-		Utils::Exit(1);
-	}
 };
 
 void EngineSettings::Widgets::load() {
@@ -28,7 +28,14 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 class EngineSettings {
 public:
-	void load();
+	static const bool DEFER_ERRORS = true;
+
+	// the settings can be loaded on a loading thread by passing DEFER_ERRORS
+	// checkErrors() must then be called on the main thread once loading is done
+	void load(bool defer_errors = false);
+
+	// shows an error dialog and exits if the loaded settings can't be used
+	void checkErrors();
 
 	class Misc {
 	public:
@@ -57,6 +64,8 @@ public:
 		bool keep_buyback_on_map_change;
 		std::string sfx_unable_to_cast;
 		bool combat_aborts_npc_interact;
+		bool flow_field_pathing;
+		bool flow_field_normal_movement_only;
 	};
 
 	class Resolutions {
@@ -30,6 +30,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "CampaignManager.h"
 #include "CombatText.h"
 #include "CommonIncludes.h"
+#include "EnemyManager.h"
 #include "EngineSettings.h"
 #include "Entity.h"
 #include "Hazard.h"
@@ -52,6 +53,8 @@ const int directionDeltaX[8] =   {-1, -1, -1,  0,  1,  1,  1,  0};
 const int directionDeltaY[8] =   { 1,  0, -1, -1, -1,  0,  1,  1};
 const float speedMultiplyer[8] = { static_cast<float>(1.0/M_SQRT2), 1.0f, static_cast<float>(1.0/M_SQRT2), 1.0f, static_cast<float>(1.0/M_SQRT2), 1.0f, static_cast<float>(1.0/M_SQRT2), 1.0f};
 
+unsigned Entity::next_entity_id = 0;
+
 Entity::Entity()
 	: sprites(NULL)
 	, sound_attack()
@@ -62,10 +65,16 @@ Entity::Entity()
 	, sound_levelup(0)
 	, sound_lowhp(0)
 	, activeAnimation(NULL)
-	, animationSet(NULL) {
+	, animationSet(NULL)
+	, grid_cell(-1)
+	, enemy_index(0)
+	, entity_id(next_entity_id++) {
 }
 
-Entity::Entity(const Entity& e) {
+Entity::Entity(const Entity& e)
+	: grid_cell(-1)
+	, enemy_index(0)
+	, entity_id(next_entity_id++) {
 	*this = e;
 }
 
@@ -289,6 +298,8 @@ bool Entity::move() {
 	float dy = speed * static_cast<float>(directionDeltaY[stats.direction]);
 
 	bool full_move = mapr->collider.move(stats.pos.x, stats.pos.y, dx, dy, stats.movement_type, mapr->collider.getCollideType(stats.hero));
+	if (enemym)
+		enemym->grid.update(this);
 
 	return full_move;
 }
@@ -77,6 +77,18 @@ public:
 	AnimationSet *animationSet;
 
 	StatBlock stats;
+
+	// bucket index in EnemyManager::grid, or -1 if this entity isn't in the grid
+	int grid_cell;
+
+	// position in EnemyManager::enemies; grid queries are sorted by it to visit entities in the same order as that list
+	size_t enemy_index;
+
+	// unique to this entity; ids are never reused, unlike addresses, so hazards can remember which entities they hit
+	unsigned entity_id;
+
+private:
+	static unsigned next_entity_id;
 };
 
 extern const int directionDeltaX[];
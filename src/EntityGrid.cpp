@@ -0,0 +1,140 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "Entity.h"
+#include "EntityGrid.h"
+
+#include <math.h>
+
+EntityGrid::EntityGrid()
+	: cells_w(0)
+	, cells_h(0)
+{
+}
+
+EntityGrid::~EntityGrid() {
+}
+
+void EntityGrid::init(int map_w, int map_h) {
+	clear();
+
+	cells_w = std::max(1, (map_w + CELL_SIZE - 1) / CELL_SIZE);
+	cells_h = std::max(1, (map_h + CELL_SIZE - 1) / CELL_SIZE);
+	cells.resize(cells_w * cells_h);
+}
+
+void EntityGrid::clear() {
+	for (size_t i = 0; i < cells.size(); ++i) {
+		for (size_t j = 0; j < cells[i].size(); ++j) {
+			cells[i][j]->grid_cell = -1;
+		}
+		cells[i].clear();
+	}
+}
+
+void EntityGrid::add(Entity* e) {
+	if (!e || e->grid_cell != -1 || cells.empty())
+		return;
+
+	e->grid_cell = getCell(e->stats.pos);
+	cells[e->grid_cell].push_back(e);
+}
+
+void EntityGrid::remove(Entity* e) {
+	if (!e || e->grid_cell < 0 || static_cast<size_t>(e->grid_cell) >= cells.size())
+		return;
+
+	std::vector<Entity*>& cell = cells[e->grid_cell];
+	for (size_t i = 0; i < cell.size(); ++i) {
+		if (cell[i] == e) {
+			cell[i] = cell.back();
+			cell.pop_back();
+			break;
+		}
+	}
+
+	e->grid_cell = -1;
+}
+
+void EntityGrid::update(Entity* e) {
+	if (!e || e->grid_cell == -1)
+		return;
+
+	if (getCell(e->stats.pos) != e->grid_cell) {
+		remove(e);
+		add(e);
+	}
+}
+
+void EntityGrid::getInRadius(const FPoint& pos, float radius, std::vector<Entity*>& result) const {
+	if (cells.empty())
+		return;
+
+	int x0 = clampCellX(pos.x - radius);
+	int x1 = clampCellX(pos.x + radius);
+	int y0 = clampCellY(pos.y - radius);
+	int y1 = clampCellY(pos.y + radius);
+
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			const std::vector<Entity*>& cell = cells[x + y * cells_w];
+			for (size_t i = 0; i < cell.size(); ++i) {
+				if (Utils::isWithinRadius(pos, radius, cell[i]->stats.pos))
+					result.push_back(cell[i]);
+			}
+		}
+	}
+}
+
+void EntityGrid::getInRect(const FPoint& top_left, const FPoint& bottom_right, std::vector<Entity*>& result) const {
+	if (cells.empty())
+		return;
+
+	int x0 = clampCellX(top_left.x);
+	int x1 = clampCellX(bottom_right.x);
+	int y0 = clampCellY(top_left.y);
+	int y1 = clampCellY(bottom_right.y);
+
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			const std::vector<Entity*>& cell = cells[x + y * cells_w];
+			for (size_t i = 0; i < cell.size(); ++i) {
+				const FPoint& p = cell[i]->stats.pos;
+				if (p.x >= top_left.x && p.y >= top_left.y && p.x <= bottom_right.x && p.y <= bottom_right.y)
+					result.push_back(cell[i]);
+			}
+		}
+	}
+}
+
+float EntityGrid::getMaxRadius() const {
+	return static_cast<float>((cells_w + cells_h) * CELL_SIZE);
+}
+
+int EntityGrid::getCell(const FPoint& pos) const {
+	return clampCellX(pos.x) + clampCellY(pos.y) * cells_w;
+}
+
+int EntityGrid::clampCellX(float x) const {
+	int cell = static_cast<int>(floorf(x)) / CELL_SIZE;
+	return std::max(0, std::min(cells_w - 1, cell));
+}
+
+int EntityGrid::clampCellY(float y) const {
+	int cell = static_cast<int>(floorf(y)) / CELL_SIZE;
+	return std::max(0, std::min(cells_h - 1, cell));
+}
@@ -0,0 +1,68 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class EntityGrid
+ *
+ * Buckets entities by map position so that hazards and AI only need to look at
+ * entities near them instead of every entity on the map.
+ * Each bucket covers CELL_SIZE x CELL_SIZE tiles. Entities outside the map go in the nearest edge bucket.
+ */
+
+#ifndef ENTITY_GRID_H
+#define ENTITY_GRID_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+class Entity;
+
+class EntityGrid {
+public:
+	static const int CELL_SIZE = 4;
+
+	EntityGrid();
+	~EntityGrid();
+
+	// removes all entities and resizes the grid to cover the map
+	void init(int map_w, int map_h);
+	void clear();
+
+	void add(Entity* e);
+	void remove(Entity* e);
+
+	// moves the entity to a different bucket if its position changed
+	void update(Entity* e);
+
+	// results are appended to the list; order is not the same as EnemyManager::enemies
+	void getInRadius(const FPoint& pos, float radius, std::vector<Entity*>& result) const;
+	void getInRect(const FPoint& top_left, const FPoint& bottom_right, std::vector<Entity*>& result) const;
+
+	// the largest radius that getInRadius() would ever need to search
+	float getMaxRadius() const;
+
+private:
+	int getCell(const FPoint& pos) const;
+	int clampCellX(float x) const;
+	int clampCellY(float y) const;
+
+	int cells_w;
+	int cells_h;
+	std::vector< std::vector<Entity*> > cells;
+};
+
+#endif // ENTITY_GRID_H
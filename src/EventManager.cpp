@@ -719,7 +719,7 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 				ec->y = random_ec.y;
 			}
 
-			if (Filesystem::fileExists(mods->locate(ec->s))) {
+			if (mods->locate(ec->s) != "") {
 				mapr->teleportation = true;
 				mapr->teleport_mapname = ec->s;
 
@@ -747,7 +747,7 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 		else if (ec->type == EventComponent::MAPMOD) {
 			if (ec->s == "collision") {
 				if (ec->x >= 0 && ec->x < mapr->w && ec->y >= 0 && ec->y < mapr->h) {
-					mapr->collider.colmap[ec->x][ec->y] = static_cast<unsigned short>(ec->z);
+					mapr->collider.setTile(ec->x, ec->y, static_cast<unsigned short>(ec->z));
 					mapr->map_change = true;
 				}
 				else
@@ -759,8 +759,10 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 					Utils::logError("EventManager: Mapmod at position (%d, %d) contains invalid tile id (%d).", ec->x, ec->y, ec->z);
 				else if (index >= mapr->layers.size())
 					Utils::logError("EventManager: Mapmod at position (%d, %d) is on an invalid layer.", ec->x, ec->y);
-				else if (ec->x >= 0 && ec->x < mapr->w && ec->y >= 0 && ec->y < mapr->h)
+				else if (ec->x >= 0 && ec->x < mapr->w && ec->y >= 0 && ec->y < mapr->h) {
 					mapr->layers[index][ec->x][ec->y] = static_cast<unsigned short>(ec->z);
+					mapr->invalidateTile(ec->x, ec->y);
+				}
 				else
 					Utils::logError("EventManager: Mapmod at position (%d, %d) is out of bounds 0-255.", ec->x, ec->y);
 			}
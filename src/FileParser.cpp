@@ -17,13 +17,43 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
 #include "FileParser.h"
+#include "FileParserCache.h"
 #include "ModManager.h"
+#include "Settings.h"
 #include "SharedResources.h"
 #include "UtilsFileSystem.h"
 #include "UtilsParsing.h"
 
 #include <stdarg.h>
 
+namespace {
+
+// adds the time until it goes out of scope to a total
+class StatTimer {
+public:
+	StatTimer(bool _enabled, Uint64* _total)
+		: enabled(_enabled)
+		, total(_total)
+		, start(_enabled ? SDL_GetPerformanceCounter() : 0) {
+	}
+	~StatTimer() {
+		if (enabled)
+			*total += SDL_GetPerformanceCounter() - start;
+	}
+
+private:
+	bool enabled;
+	Uint64* total;
+	Uint64 start;
+};
+
+} // namespace
+
+unsigned FileParser::stat_files_cached = 0;
+unsigned FileParser::stat_files_parsed = 0;
+Uint64 FileParser::stat_ticks = 0;
+SDL_SpinLock FileParser::stat_lock = 0;
+
 FileParser::FileParser()
 	: current_index(0)
 	, is_mod_file(false)
@@ -31,6 +61,11 @@ FileParser::FileParser()
 	, line("")
 	, line_number(0)
 	, include_fp(NULL)
+	, cache(NULL)
+	, cache_replay(false)
+	, cache_pos(0)
+	, is_include(false)
+	, ticks(0)
 	, new_section(false)
 	, section("")
 	, key("")
@@ -38,9 +73,26 @@ FileParser::FileParser()
 }
 
 bool FileParser::open(const std::string& _filename, bool _is_mod_file, int _error_mode) {
+	StatTimer timer(!is_include, &ticks);
+
 	is_mod_file = _is_mod_file;
 	error_mode = _error_mode;
 
+	if (!is_include) {
+		discardCache();
+		bool cached = is_mod_file && settings->parser_cache && openCache(_filename);
+
+		SDL_AtomicLock(&stat_lock);
+		if (cached)
+			stat_files_cached++;
+		else
+			stat_files_parsed++;
+		SDL_AtomicUnlock(&stat_lock);
+
+		if (cached)
+			return true;
+	}
+
 	filenames.clear();
 	if (is_mod_file) {
 		filenames = mods->list(_filename, ModManager::LIST_FULL_PATHS);
@@ -51,6 +103,9 @@ bool FileParser::open(const std::string& _filename, bool _is_mod_file, int _erro
 	current_index = 0;
 	line_number = 0;
 
+	if (cache)
+		cache->addSource(_filename, filenames);
+
 	if (filenames.empty()) {
 		if (error_mode != ERROR_NONE)
 			Utils::logError("FileParser: Could not open text file: %s: No such file or directory!", _filename.c_str());
@@ -98,9 +153,65 @@ bool FileParser::open(const std::string& _filename, bool _is_mod_file, int _erro
 		}
 	}
 
+	if (!ret && !is_include)
+		discardCache();
+
 	return ret;
 }
 
+/**
+ * Loads the cache for a mod file if it is valid, or starts recording a new one
+ */
+bool FileParser::openCache(const std::string& filename) {
+	cache = new FileParserCache();
+	if (cache->load(filename)) {
+		cache_replay = true;
+		cache_pos = 0;
+		filenames.clear();
+		current_index = 0;
+		line_number = 0;
+		return true;
+	}
+
+	return false;
+}
+
+void FileParser::recordCache() {
+	if (!cache || cache_replay || is_include)
+		return;
+
+	std::string file;
+	unsigned location_line = 0;
+	getLocation(file, location_line);
+	cache->addRecord(new_section, section, key, val, file, location_line);
+}
+
+void FileParser::discardCache() {
+	if (!is_include)
+		delete cache;
+	cache = NULL;
+	cache_replay = false;
+	cache_pos = 0;
+}
+
+/**
+ * The file and line of the current key pair, which may be in an INCLUDE file
+ */
+void FileParser::getLocation(std::string& file, unsigned& location_line) {
+	if (include_fp) {
+		include_fp->getLocation(file, location_line);
+	}
+	else if (cache_replay) {
+		if (cache_pos > 0)
+			cache->getString(cache->records[cache_pos-1].file, file);
+		location_line = line_number;
+	}
+	else if (current_index < filenames.size()) {
+		file = filenames[current_index];
+		location_line = line_number;
+	}
+}
+
 void FileParser::close() {
 	if (include_fp) {
 		include_fp->close();
@@ -108,9 +219,19 @@ void FileParser::close() {
 		include_fp = NULL;
 	}
 
+	// an unfinished recording can't be replayed
+	discardCache();
+
 	if (infile.is_open())
 		infile.close();
 	infile.clear();
+
+	if (ticks > 0) {
+		SDL_AtomicLock(&stat_lock);
+		stat_ticks += ticks;
+		SDL_AtomicUnlock(&stat_lock);
+		ticks = 0;
+	}
 }
 
 /**
@@ -120,6 +241,20 @@ void FileParser::close() {
  * @return false if EOF, otherwise true
  */
 bool FileParser::next() {
+	StatTimer timer(!is_include, &ticks);
+
+	if (cache_replay) {
+		if (cache_pos >= cache->records.size())
+			return false;
+
+		const FileParserCache::Record& record = cache->records[cache_pos++];
+		new_section = record.new_section;
+		cache->getString(record.section, section);
+		cache->getString(record.key, key);
+		cache->getString(record.val, val);
+		line_number = record.line;
+		return true;
+	}
 
 	std::string starts_with;
 	new_section = false;
@@ -132,6 +267,7 @@ bool FileParser::next() {
 					section = include_fp->section;
 					key = include_fp->key;
 					val = include_fp->val;
+					recordCache();
 					return true;
 				}
 				else {
@@ -175,13 +311,16 @@ bool FileParser::next() {
 					std::string tmp = line.substr(first_space+1);
 
 					include_fp = new FileParser();
-					if (!include_fp || !include_fp->open(tmp, is_mod_file, error_mode)) {
+					include_fp->is_include = true;
+					include_fp->cache = cache;
+					if (!include_fp->open(tmp, is_mod_file, error_mode)) {
 						delete include_fp;
 						include_fp = NULL;
 					}
-
-					// INCLUDE file will inherit the current section
-					include_fp->section = section;
+					else {
+						// INCLUDE file will inherit the current section
+						include_fp->section = section;
+					}
 
 					continue;
 				}
@@ -189,6 +328,7 @@ bool FileParser::next() {
 
 			// this is a keypair. Perform basic parsing and return
 			Parse::getKeyPair(line, key, val);
+			recordCache();
 			return true;
 		}
 
@@ -196,7 +336,14 @@ bool FileParser::next() {
 		infile.clear();
 
 		current_index++;
-		if (current_index == filenames.size()) return false;
+		if (current_index == filenames.size()) {
+			// every key pair has been recorded
+			if (cache && !cache_replay && !is_include) {
+				cache->save();
+				discardCache();
+			}
+			return false;
+		}
 
 		line_number = 0;
 		const std::string current_filename = filenames[current_index];
@@ -205,6 +352,8 @@ bool FileParser::next() {
 			if (error_mode != ERROR_NONE)
 				Utils::logError("FileParser: Could not open text file: %s", current_filename.c_str());
 			infile.clear();
+			if (!is_include)
+				discardCache();
 			return false;
 		}
 		// a new file starts a new section
@@ -221,6 +370,10 @@ bool FileParser::next() {
 std::string FileParser::getRawLine() {
 	line = "";
 
+	// raw lines aren't part of the key pairs that a cache replays
+	if (!is_include)
+		discardCache();
+
 	if (infile.good()) {
 		line = Parse::getLine(infile);
 	}
@@ -243,8 +396,12 @@ void FileParser::errorBuf(const char* buffer) {
 		include_fp->errorBuf(buffer);
 	}
 	else {
+		std::string file;
+		unsigned location_line = 0;
+		getLocation(file, location_line);
+
 		std::stringstream ss;
-		ss << "[" << filenames[current_index] << ":" << line_number << "] " << buffer;
+		ss << "[" << file << ":" << location_line << "] " << buffer;
 		Utils::logError(ss.str().c_str());
 	}
 }
@@ -253,6 +410,17 @@ void FileParser::incrementLineNum() {
 	line_number++;
 }
 
+void FileParser::logStats(const char* when) {
+	SDL_AtomicLock(&stat_lock);
+	unsigned files_cached = stat_files_cached;
+	unsigned files_parsed = stat_files_parsed;
+	Uint64 total_ticks = stat_ticks;
+	SDL_AtomicUnlock(&stat_lock);
+
+	Utils::logInfo("FileParser: %s: %u files replayed from the cache, %u files parsed, %.1f ms total.", when, files_cached, files_parsed,
+		static_cast<double>(total_ticks) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency()));
+}
+
 FileParser::~FileParser() {
 	close();
 }
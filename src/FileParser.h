@@ -26,23 +26,47 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define FILE_PARSER_H
 
 #include "CommonIncludes.h"
+#include "ModArchive.h"
+
+class FileParserCache;
 
 class FileParser {
 private:
 	void errorBuf(const char* buffer);
 
+	bool openCache(const std::string& filename);
+	void recordCache();
+	void discardCache();
+	void getLocation(std::string& file, unsigned& location_line);
+
 	std::vector<std::string> filenames;
 	unsigned current_index;
 	bool is_mod_file;
 	int error_mode;
 
-	std::ifstream infile;
+	ModFileStream infile;
 	std::string line;
 
 	unsigned line_number;
 
 	FileParser* include_fp;
 
+	// when parser_cache is enabled, mod files are either replayed from the cache or recorded into it
+	// parsers for INCLUDE files share the cache of the file that includes them
+	FileParserCache* cache;
+	bool cache_replay;
+	size_t cache_pos;
+	bool is_include;
+
+	// time spent in open() and next(); added to stat_ticks by close()
+	Uint64 ticks;
+
+	// files may be parsed on several threads at once, so the totals are guarded by stat_lock
+	static unsigned stat_files_cached;
+	static unsigned stat_files_parsed;
+	static Uint64 stat_ticks;
+	static SDL_SpinLock stat_lock;
+
 public:
 	enum {
 		ERROR_NONE = 0,
@@ -76,6 +100,9 @@ public:
 	void error(const char* format, ...);
 	void incrementLineNum();
 
+	// logs how many files were replayed from the cache, and the time spent in FileParser so far
+	static void logStats(const char* when);
+
 	/**
 	 * @brief new_section is set to true whenever a new [section] starts. If opening
 	 * multiple files it is also true whenever a new file is opened. Note: This
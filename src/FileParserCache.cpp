@@ -0,0 +1,352 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "FileParserCache.h"
+#include "ModManager.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+#include "Version.h"
+
+#include <string.h>
+
+namespace {
+
+const char CACHE_MAGIC[] = "FLAREFPC";
+const size_t CACHE_MAGIC_LENGTH = 8;
+
+// cache files are only read by the machine that wrote them, so integers are stored in native byte order
+void writeUint32(std::string& dest, Uint32 val) {
+	dest.append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+void writeSint64(std::string& dest, Sint64 val) {
+	dest.append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+void writeString(std::string& dest, const std::string& val) {
+	writeUint32(dest, static_cast<Uint32>(val.length()));
+	dest += val;
+}
+
+class CacheReader {
+public:
+	CacheReader(const std::vector<char>& buffer)
+		: pos(buffer.empty() ? NULL : &buffer[0])
+		, end(buffer.empty() ? NULL : &buffer[0] + buffer.size())
+		, ok(true) {
+	}
+
+	bool readMagic() {
+		if (!check(CACHE_MAGIC_LENGTH) || memcmp(pos, CACHE_MAGIC, CACHE_MAGIC_LENGTH) != 0) {
+			ok = false;
+			return false;
+		}
+		pos += CACHE_MAGIC_LENGTH;
+		return true;
+	}
+
+	Uint32 readUint32() {
+		Uint32 val = 0;
+		if (check(sizeof(val))) {
+			memcpy(&val, pos, sizeof(val));
+			pos += sizeof(val);
+		}
+		return val;
+	}
+
+	Sint64 readSint64() {
+		Sint64 val = 0;
+		if (check(sizeof(val))) {
+			memcpy(&val, pos, sizeof(val));
+			pos += sizeof(val);
+		}
+		return val;
+	}
+
+	std::string readString() {
+		Uint32 length = readUint32();
+		if (!check(length))
+			return "";
+		std::string val(pos, length);
+		pos += length;
+		return val;
+	}
+
+	// returns the position of the string, without copying it
+	const char* skipString(size_t* length) {
+		*length = readUint32();
+		if (!check(*length))
+			return NULL;
+		const char* str = pos;
+		pos += *length;
+		return str;
+	}
+
+	const char* pos;
+	const char* end;
+	bool ok;
+
+private:
+	bool check(size_t length) {
+		if (!ok || static_cast<size_t>(end - pos) < length)
+			ok = false;
+		return ok;
+	}
+};
+
+} // namespace
+
+FileParserCache::FileParserCache() {
+}
+
+FileParserCache::~FileParserCache() {
+}
+
+void FileParserCache::clear() {
+	filename.clear();
+	sources.clear();
+	strings.clear();
+	string_ids.clear();
+	std::vector<char>().swap(buffer);
+	buffer_strings.clear();
+	records.clear();
+}
+
+bool FileParserCache::load(const std::string& _filename) {
+	clear();
+	filename = _filename;
+
+	std::ifstream infile(getCachePath(filename).c_str(), std::ios::in | std::ios::binary);
+	if (!infile.is_open())
+		return false;
+
+	infile.seekg(0, std::ios::end);
+	std::streamoff length = infile.tellg();
+	infile.seekg(0, std::ios::beg);
+	if (length > 0) {
+		buffer.resize(static_cast<size_t>(length));
+		infile.read(&buffer[0], length);
+	}
+	infile.close();
+
+	CacheReader reader(buffer);
+	reader.readMagic();
+
+	bool valid = reader.readUint32() == VERSION;
+	valid = valid && reader.readString() == filename;
+	valid = valid && static_cast<unsigned long>(reader.readSint64()) == getModListHash();
+
+	if (valid) {
+		Uint32 source_count = reader.readUint32();
+		for (Uint32 i = 0; i < source_count && reader.ok; ++i) {
+			sources.resize(sources.size() + 1);
+			Source& source = sources.back();
+			source.name = reader.readString();
+
+			Uint32 path_count = reader.readUint32();
+			for (Uint32 j = 0; j < path_count && reader.ok; ++j) {
+				source.paths.push_back(reader.readString());
+				source.modified_times.push_back(static_cast<long>(reader.readSint64()));
+				source.sizes.push_back(static_cast<long>(reader.readSint64()));
+			}
+		}
+		valid = reader.ok && validate();
+	}
+
+	if (valid) {
+		Uint32 string_count = reader.readUint32();
+		buffer_strings.reserve(string_count);
+		for (Uint32 i = 0; i < string_count && reader.ok; ++i) {
+			size_t str_length = 0;
+			const char* str = reader.skipString(&str_length);
+			buffer_strings.push_back(std::pair<size_t, size_t>(str ? static_cast<size_t>(str - &buffer[0]) : 0, str_length));
+		}
+
+		Uint32 record_count = reader.readUint32();
+		records.reserve(record_count);
+		for (Uint32 i = 0; i < record_count && reader.ok; ++i) {
+			Record record;
+			record.section = reader.readUint32();
+			record.key = reader.readUint32();
+			record.val = reader.readUint32();
+			record.file = reader.readUint32();
+			record.line = reader.readUint32();
+			record.new_section = reader.readUint32() != 0;
+
+			const size_t count = buffer_strings.size();
+			if (record.section >= count || record.key >= count || record.val >= count || record.file >= count)
+				reader.ok = false;
+
+			records.push_back(record);
+		}
+		valid = reader.ok && reader.pos == reader.end;
+	}
+
+	if (!valid) {
+		clear();
+		filename = _filename;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Checks that the source files haven't changed since the cache was written
+ */
+bool FileParserCache::validate() {
+	for (size_t i = 0; i < sources.size(); ++i) {
+		const Source& source = sources[i];
+
+		if (mods->list(source.name, ModManager::LIST_FULL_PATHS) != source.paths)
+			return false;
+
+		for (size_t j = 0; j < source.paths.size(); ++j) {
+			if (mods->getFileModifiedTime(source.paths[j]) != source.modified_times[j])
+				return false;
+			if (mods->getFileSize(source.paths[j]) != source.sizes[j])
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void FileParserCache::save() {
+	std::string data;
+	data.append(CACHE_MAGIC, CACHE_MAGIC_LENGTH);
+	writeUint32(data, VERSION);
+	writeString(data, filename);
+	writeSint64(data, static_cast<Sint64>(getModListHash()));
+
+	writeUint32(data, static_cast<Uint32>(sources.size()));
+	for (size_t i = 0; i < sources.size(); ++i) {
+		const Source& source = sources[i];
+		writeString(data, source.name);
+		writeUint32(data, static_cast<Uint32>(source.paths.size()));
+		for (size_t j = 0; j < source.paths.size(); ++j) {
+			writeString(data, source.paths[j]);
+			writeSint64(data, source.modified_times[j]);
+			writeSint64(data, source.sizes[j]);
+		}
+	}
+
+	writeUint32(data, static_cast<Uint32>(strings.size()));
+	for (size_t i = 0; i < strings.size(); ++i) {
+		writeString(data, strings[i]);
+	}
+
+	writeUint32(data, static_cast<Uint32>(records.size()));
+	for (size_t i = 0; i < records.size(); ++i) {
+		const Record& record = records[i];
+		writeUint32(data, record.section);
+		writeUint32(data, record.key);
+		writeUint32(data, record.val);
+		writeUint32(data, record.file);
+		writeUint32(data, record.line);
+		writeUint32(data, record.new_section ? 1 : 0);
+	}
+
+	Filesystem::createDir(settings->path_user + "cache");
+	Filesystem::createDir(settings->path_user + "cache/parser");
+
+	// write to a temporary file first, so that an interrupted write doesn't leave a broken cache behind
+	const std::string cache_path = getCachePath(filename);
+	const std::string temp_path = cache_path + ".tmp";
+
+	std::ofstream outfile(temp_path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!outfile.is_open())
+		return;
+
+	outfile.write(data.data(), data.length());
+	bool ok = outfile.good();
+	outfile.close();
+
+	if (!ok) {
+		Utils::logError("FileParserCache: Unable to write '%s'. No write access or disk is full!", temp_path.c_str());
+		Filesystem::removeFile(temp_path);
+		return;
+	}
+
+	if (Filesystem::fileExists(cache_path))
+		Filesystem::removeFile(cache_path);
+	Filesystem::renameFile(temp_path, cache_path);
+}
+
+void FileParserCache::addSource(const std::string& name, const std::vector<std::string>& paths) {
+	for (size_t i = 0; i < sources.size(); ++i) {
+		if (sources[i].name == name)
+			return;
+	}
+
+	Source source;
+	source.name = name;
+	source.paths = paths;
+	for (size_t i = 0; i < paths.size(); ++i) {
+		source.modified_times.push_back(mods->getFileModifiedTime(paths[i]));
+		source.sizes.push_back(mods->getFileSize(paths[i]));
+	}
+	sources.push_back(source);
+}
+
+void FileParserCache::addRecord(bool new_section, const std::string& section, const std::string& key, const std::string& val, const std::string& file, unsigned line) {
+	Record record;
+	record.section = intern(section);
+	record.key = intern(key);
+	record.val = intern(val);
+	record.file = intern(file);
+	record.line = line;
+	record.new_section = new_section;
+	records.push_back(record);
+}
+
+void FileParserCache::getString(Uint32 id, std::string& dest) const {
+	if (buffer.empty())
+		dest = strings[id];
+	else
+		dest.assign(&buffer[0] + buffer_strings[id].first, buffer_strings[id].second);
+}
+
+Uint32 FileParserCache::intern(const std::string& str) {
+	std::map<std::string, Uint32>::iterator it = string_ids.find(str);
+	if (it != string_ids.end())
+		return it->second;
+
+	Uint32 id = static_cast<Uint32>(strings.size());
+	strings.push_back(str);
+	string_ids[str] = id;
+	return id;
+}
+
+std::string FileParserCache::getCachePath(const std::string& name) {
+	std::stringstream ss;
+	ss << settings->path_user << "cache/parser/" << std::hex << Utils::hashString(name) << ".bin";
+	return ss.str();
+}
+
+/**
+ * Changing the active mods or the engine version invalidates all cache files
+ */
+unsigned long FileParserCache::getModListHash() {
+	std::string mod_names = VersionInfo::ENGINE.getString();
+	for (size_t i = 0; i < mods->mod_list.size(); ++i) {
+		mod_names += ";" + mods->mod_list[i].name + ":" + mods->mod_list[i].version->getString();
+	}
+	return Utils::hashString(mod_names);
+}
@@ -0,0 +1,100 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class FileParserCache
+ *
+ * The key/value pairs that FileParser returned for a mod data file, including the files
+ * it INCLUDEs, stored in a binary file so that they can be replayed without parsing the text again.
+ *
+ * A cache is only valid while the mod list is unchanged and each source file resolves to the
+ * same paths, with the same sizes and modification times. Cache files are not portable between
+ * machines.
+ */
+
+#ifndef FILE_PARSER_CACHE_H
+#define FILE_PARSER_CACHE_H
+
+#include "CommonIncludes.h"
+
+class FileParserCache {
+public:
+	class Record {
+	public:
+		Uint32 section;
+		Uint32 key;
+		Uint32 val;
+		Uint32 file;
+		Uint32 line;
+		bool new_section;
+
+		Record()
+			: section(0)
+			, key(0)
+			, val(0)
+			, file(0)
+			, line(0)
+			, new_section(false) {
+		}
+	};
+
+	FileParserCache();
+	~FileParserCache();
+
+	// returns false if there is no valid cache for this generic filename
+	bool load(const std::string& _filename);
+	void save();
+
+	// name is a generic filename; paths are the files that ModManager::list() found for it
+	void addSource(const std::string& name, const std::vector<std::string>& paths);
+	void addRecord(bool new_section, const std::string& section, const std::string& key, const std::string& val, const std::string& file, unsigned line);
+
+	void getString(Uint32 id, std::string& dest) const;
+
+	std::vector<Record> records;
+
+private:
+	class Source {
+	public:
+		std::string name;
+		std::vector<std::string> paths;
+		std::vector<long> modified_times;
+		std::vector<long> sizes;
+	};
+
+	static const Uint32 VERSION = 1;
+
+	void clear();
+	bool validate();
+	Uint32 intern(const std::string& str);
+
+	static std::string getCachePath(const std::string& name);
+	static unsigned long getModListHash();
+
+	std::string filename;
+	std::vector<Source> sources;
+
+	// strings of a recorded cache
+	std::vector<std::string> strings;
+	std::map<std::string, Uint32> string_ids;
+
+	// strings of a loaded cache point into its buffer, so they don't need to be allocated
+	std::vector<char> buffer;
+	std::vector<std::pair<size_t, size_t> > buffer_strings;
+};
+
+#endif // FILE_PARSER_CACHE_H
@@ -0,0 +1,132 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "FlowField.h"
+#include "MapCollision.h"
+
+#include <algorithm>
+
+static const float DIAGONAL_COST = 1.41421356f;
+
+FlowField::FlowField()
+	: last_used(0)
+	, valid(false)
+	, target(-1, -1)
+	, movement_type(0)
+{
+}
+
+FlowField::~FlowField() {
+}
+
+/**
+ * Dijkstra outwards from the target, limited to RADIUS tiles in each direction
+ * Entities are ignored, since they would invalidate the field every time they move
+ */
+void FlowField::compute(const MapCollision* collider, const Point& _target, int _movement_type) {
+	target = _target;
+	movement_type = _movement_type;
+
+	bounds.x = std::max(0, target.x - RADIUS);
+	bounds.y = std::max(0, target.y - RADIUS);
+	bounds.w = std::min(collider->map_size.x, target.x + RADIUS + 1) - bounds.x;
+	bounds.h = std::min(collider->map_size.y, target.y + RADIUS + 1) - bounds.y;
+
+	valid = true;
+	cost.assign(std::max(0, bounds.w * bounds.h), -1.f);
+	heap.clear();
+
+	if (!collider->isStaticPassable(target.x, target.y, movement_type))
+		return;
+
+	int target_index = (target.x - bounds.x) + (target.y - bounds.y) * bounds.w;
+	cost[target_index] = 0;
+	heap.push_back(HeapEntry(0, target_index));
+
+	while (!heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end());
+		HeapEntry current = heap.back();
+		heap.pop_back();
+
+		if (current.cost > cost[current.index])
+			continue;
+
+		int x = bounds.x + current.index % bounds.w;
+		int y = bounds.y + current.index / bounds.w;
+
+		for (int dy = -1; dy <= 1; ++dy) {
+			for (int dx = -1; dx <= 1; ++dx) {
+				if (dx == 0 && dy == 0) continue;
+
+				int nx = x + dx;
+				int ny = y + dy;
+				if (nx < bounds.x || ny < bounds.y || nx >= bounds.x + bounds.w || ny >= bounds.y + bounds.h) continue;
+				if (!collider->isStaticPassable(nx, ny, movement_type)) continue;
+
+				int n = (nx - bounds.x) + (ny - bounds.y) * bounds.w;
+				float next_cost = current.cost + ((dx != 0 && dy != 0) ? DIAGONAL_COST : 1.f);
+				if (cost[n] < 0 || next_cost < cost[n]) {
+					cost[n] = next_cost;
+					heap.push_back(HeapEntry(next_cost, n));
+					std::push_heap(heap.begin(), heap.end());
+				}
+			}
+		}
+	}
+}
+
+void FlowField::invalidate() {
+	valid = false;
+}
+
+bool FlowField::isValid() const {
+	return valid;
+}
+
+bool FlowField::matches(const Point& _target, int _movement_type) const {
+	return valid && target.x == _target.x && target.y == _target.y && movement_type == _movement_type;
+}
+
+float FlowField::getCost(int x, int y) const {
+	if (x < bounds.x || y < bounds.y || x >= bounds.x + bounds.w || y >= bounds.y + bounds.h)
+		return -1;
+
+	return cost[(x - bounds.x) + (y - bounds.y) * bounds.w];
+}
+
+bool FlowField::getNextStep(const Point& from, Point& next) const {
+	float best = getCost(from.x, from.y);
+	if (best <= 0)
+		return false;
+
+	bool found = false;
+	for (int dy = -1; dy <= 1; ++dy) {
+		for (int dx = -1; dx <= 1; ++dx) {
+			if (dx == 0 && dy == 0) continue;
+
+			float c = getCost(from.x + dx, from.y + dy);
+			if (c >= 0 && c < best) {
+				best = c;
+				next.x = from.x + dx;
+				next.y = from.y + dy;
+				found = true;
+			}
+		}
+	}
+
+	return found;
+}
@@ -0,0 +1,81 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class FlowField
+ *
+ * Distance to a single target tile for every tile around it.
+ * Any number of entities chasing the same target can follow the field downhill
+ * instead of each running their own A* search.
+ */
+
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <vector>
+
+#include "Utils.h"
+
+class MapCollision;
+
+class FlowField {
+public:
+	// the field covers tiles up to this many tiles away from the target
+	static const int RADIUS = 32;
+
+	FlowField();
+	~FlowField();
+
+	void compute(const MapCollision* collider, const Point& _target, int _movement_type);
+	void invalidate();
+
+	bool isValid() const;
+	bool matches(const Point& _target, int _movement_type) const;
+
+	// returns true and sets next to the neighbouring tile closest to the target
+	bool getNextStep(const Point& from, Point& next) const;
+
+	unsigned int last_used;
+
+private:
+	class HeapEntry {
+	public:
+		float cost;
+		int index;
+		HeapEntry(float _cost, int _index)
+			: cost(_cost)
+			, index(_index)
+		{}
+		bool operator<(const HeapEntry& other) const {
+			// reversed so that std::push_heap builds a min-heap
+			return cost > other.cost;
+		}
+	};
+
+	float getCost(int x, int y) const;
+
+	bool valid;
+	Point target;
+	int movement_type;
+	Rect bounds;
+
+	// cost to reach the target from each tile in bounds; -1 if unreachable
+	std::vector<float> cost;
+	std::vector<HeapEntry> heap;
+};
+
+#endif // FLOWFIELD_H
@@ -128,6 +128,9 @@ void GameSlotPreview::loadGraphics(std::vector<std::string> _img_gfx) {
 	}
 	anim->cleanUp();
 
+	// the layer images were decoded in parallel; don't draw the avatar without them
+	render_device->waitForImageLoads();
+
 	setAnimation("stance");
 }
 
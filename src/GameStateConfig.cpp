@@ -27,6 +27,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
  * Handle game Settings Menu
  */
 
+#include "AnimationManager.h"
 #include "CombatText.h"
 #include "DeviceList.h"
 #include "EngineSettings.h"
@@ -34,11 +35,13 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "GameStateConfig.h"
 #include "GameStateTitle.h"
 #include "InputState.h"
+#include "ItemManager.h"
 #include "MenuConfig.h"
 #include "MessageEngine.h"
 #include "ModManager.h"
 #include "RenderDevice.h"
 #include "Settings.h"
+#include "SharedGameResources.h"
 #include "SharedResources.h"
 #include "SoundManager.h"
 #include "Stats.h"
@@ -87,8 +90,6 @@ void GameStateConfig::logicAccept() {
 		snd->unloadMusic();
 		reload_music = true;
 		reload_backgrounds = true;
-		delete mods;
-		mods = new ModManager(NULL);
 		settings->prev_save_slot = -1;
 	}
 	delete msg;
@@ -103,6 +104,10 @@ void GameStateConfig::logicAccept() {
 	}
 	menu_config->cleanup();
 
+	// the items that were loaded at startup may use the old language or mods; they are loaded again when needed
+	delete items;
+	items = NULL;
+
 	showLoading();
 	// need to delete the "Loading..." message here, as we're recreating our render context
 	if (loading_tip) {
@@ -119,6 +124,9 @@ void GameStateConfig::logicAccept() {
 		settings->soft_reset = true;
 	}
 
+	// unused animations are kept for a while, but their images won't survive the new render context
+	anim->clearUnused();
+
 	render_device->createContext();
 	tooltipm = new TooltipManager();
 	settings->saveSettings();
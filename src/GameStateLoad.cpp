@@ -383,7 +383,7 @@ void GameStateLoad::loadPreview(GameSlot* slot) {
 
 	// fall back to default if it exists
 	for (unsigned int i=0; i<preview_layer.size(); i++) {
-		bool exists = Filesystem::fileExists(mods->locate("animations/avatar/" + slot->stats.gfx_base + "/default_" + preview_layer[i] + ".txt"));
+		bool exists = mods->locate("animations/avatar/" + slot->stats.gfx_base + "/default_" + preview_layer[i] + ".txt") != "";
 		if (exists) {
 			img_gfx.push_back("default_" + preview_layer[i]);
 		}
@@ -567,7 +567,7 @@ void GameStateLoad::updateButtons() {
 	loadPortrait(selected_slot);
 
 	// check status of New Game button
-	if (!Filesystem::fileExists(mods->locate("maps/spawn.txt"))) {
+	if (mods->locate("maps/spawn.txt") == "") {
 		button_new->enabled = false;
 		tablist.remove(button_new);
 		button_new->tooltip = msg->get("Enable a story mod to continue");
@@ -588,7 +588,7 @@ void GameStateLoad::updateButtons() {
 
 		button_load->setLabel(msg->get("Load Game"));
 		if (game_slots[selected_slot]->current_map == "") {
-			if (!Filesystem::fileExists(mods->locate("maps/spawn.txt"))) {
+			if (mods->locate("maps/spawn.txt") == "") {
 				button_load->enabled = false;
 				tablist.remove(button_load);
 				button_load->tooltip = msg->get("Enable a story mod to continue");
@@ -65,6 +65,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "NPC.h"
 #include "NPCManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "QuestLog.h"
 #include "RenderDevice.h"
 #include "SaveLoad.h"
@@ -110,6 +111,8 @@ GameStatePlay::GameStatePlay()
 	loadTitles();
 
 	refreshWidgets();
+
+	FileParser::logStats("game data loaded");
 }
 
 void GameStatePlay::refreshWidgets() {
@@ -212,12 +215,15 @@ void GameStatePlay::checkEnemyFocus() {
 	}
 
 	// save the positions of the nearest enemies for powers that use "target_nearest"
-	Enemy *nearest = enemym->getNearestEnemy(src_pos, !EnemyManager::GET_CORPSE, &(pc->stats.target_nearest_dist), eset->misc.interact_range);
-	if (nearest)
-		pc->stats.target_nearest = &(nearest->stats);
-	Enemy *nearest_corpse = enemym->getNearestEnemy(src_pos, EnemyManager::GET_CORPSE, &(pc->stats.target_nearest_corpse_dist), eset->misc.interact_range);
-	if (nearest_corpse)
-		pc->stats.target_nearest_corpse = &(nearest_corpse->stats);
+	// powers only target an enemy within their own range, so the search stops at the largest of those ranges
+	if (powers->target_nearest_max > 0) {
+		Enemy *nearest = enemym->getNearestEnemy(src_pos, !EnemyManager::GET_CORPSE, &(pc->stats.target_nearest_dist), powers->target_nearest_max);
+		if (nearest)
+			pc->stats.target_nearest = &(nearest->stats);
+		Enemy *nearest_corpse = enemym->getNearestEnemy(src_pos, EnemyManager::GET_CORPSE, &(pc->stats.target_nearest_corpse_dist), powers->target_nearest_max);
+		if (nearest_corpse)
+			pc->stats.target_nearest_corpse = &(nearest_corpse->stats);
+	}
 }
 
 /**
@@ -383,6 +389,9 @@ void GameStatePlay::checkTeleport() {
 
 			menu->mini->prerender(&mapr->collider, mapr->w, mapr->h);
 
+			// the loading screen is still up, so finish decoding the images for the map's entities here
+			render_device->waitForImageLoads();
+
 			// return to title (permadeath) OR auto-save
 			if (pc->stats.permadeath && pc->stats.cur_state == StatBlock::AVATAR_DEAD) {
 				snd->stopMusic();
@@ -620,7 +629,7 @@ void GameStatePlay::checkEquipmentChange() {
 			}
 			// fall back to default if it exists
 			if (gfx.gfx == "") {
-				bool exists = Filesystem::fileExists(mods->locate("animations/avatar/" + pc->stats.gfx_base + "/default_" + gfx.type + ".txt"));
+				bool exists = mods->locate("animations/avatar/" + pc->stats.gfx_base + "/default_" + gfx.type + ".txt") != "";
 				if (exists) gfx.gfx = "default_" + gfx.type;
 			}
 			img_gfx.push_back(gfx);
@@ -877,6 +886,8 @@ void GameStatePlay::updateActionBar(unsigned index) {
  * This includes some message passing between child object
  */
 void GameStatePlay::logic() {
+	PROFILER_ZONE("GameStatePlay::logic");
+
 	if (inpt->window_resized)
 		refreshWidgets();
 
@@ -1052,6 +1063,7 @@ void GameStatePlay::logic() {
  * Render all graphics for a single frame
  */
 void GameStatePlay::render() {
+	PROFILER_ZONE("GameStatePlay::render");
 
 	// Create a list of Renderables from all objects not already on the map.
 	// split the list into the beings alive (may move) and dead beings (must not move)
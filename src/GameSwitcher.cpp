@@ -32,6 +32,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
  * - maybe full-video cutscenes
  */
 
+#include "AnimationManager.h"
 #include "CursorManager.h"
 #include "FileParser.h"
 #include "FontEngine.h"
@@ -170,6 +171,9 @@ void GameSwitcher::logic() {
 	// reset the global tooltip
 	tooltipm->clear();
 
+	// delete animations that have been unused for a while
+	anim->cleanUp();
+
 	// Check if a the game state is to be changed and change it if necessary, deleting the old state
 	GameState* newState = currentState->getRequestedGameState();
 	if (newState != NULL) {
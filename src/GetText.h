@@ -27,10 +27,11 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define GET_TEXT_H
 
 #include "CommonIncludes.h"
+#include "ModArchive.h"
 
 class GetText {
 private:
-	std::ifstream infile;
+	ModFileStream infile;
 	std::string line;
 	std::string sanitize(const std::string& input);
 
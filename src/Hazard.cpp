@@ -26,6 +26,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Animation.h"
 #include "AnimationSet.h"
 #include "AnimationManager.h"
+#include "Entity.h"
 #include "Hazard.h"
 #include "MapCollision.h"
 #include "PowerManager.h"
@@ -37,6 +38,9 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include <cmath>
 
+const size_t Hazard::POOL_CHUNK_SIZE;
+void* Hazard::pool_free = NULL;
+
 Hazard::Hazard(MapCollision *_collider)
 	: active(true)
 	, remove_now(false)
@@ -60,6 +64,7 @@ Hazard::Hazard(MapCollision *_collider)
 	, collider(_collider)
 	, activeAnimation(NULL)
 	, animation_name("")
+	, animation_handle()
 {
 }
 
@@ -123,21 +128,22 @@ Hazard::~Hazard() {
 		}
 
 		for (size_t i = 0; i < entitiesCollided.size(); ++i) {
-			new_parent->addEntity(entitiesCollided[i]);
+			new_parent->addEntityID(entitiesCollided[i]);
 		}
 	}
 	else if (parent) {
-		// remove this hazard from the parent's list of children
+		// remove this hazard from the parent's list of children; the order of the children doesn't matter
 		for (size_t i = 0; i < parent->children.size(); ++i) {
 			if (parent->children[i] == this) {
-				parent->children.erase(parent->children.begin() + i);
+				parent->children[i] = parent->children.back();
+				parent->children.pop_back();
 				break;
 			}
 		}
 	}
 
-	if (!animation_name.empty()) {
-		anim->decreaseCount(animation_name);
+	if (animation_handle.isValid()) {
+		anim->decreaseCount(animation_handle);
 	}
 
 	if (activeAnimation) {
@@ -147,6 +153,38 @@ Hazard::~Hazard() {
 	anim->cleanUp();
 }
 
+void* Hazard::operator new(size_t size) {
+	// a class derived from Hazard wouldn't fit in the slots
+	if (size != sizeof(Hazard))
+		return ::operator new(size);
+
+	if (!pool_free) {
+		char* chunk = static_cast<char*>(::operator new(sizeof(Hazard) * POOL_CHUNK_SIZE));
+		for (size_t i = POOL_CHUNK_SIZE; i > 0; --i) {
+			void* slot = chunk + (i-1) * sizeof(Hazard);
+			*static_cast<void**>(slot) = pool_free;
+			pool_free = slot;
+		}
+	}
+
+	void* slot = pool_free;
+	pool_free = *static_cast<void**>(slot);
+	return slot;
+}
+
+void Hazard::operator delete(void* ptr, size_t size) {
+	if (!ptr)
+		return;
+
+	if (size != sizeof(Hazard)) {
+		::operator delete(ptr);
+		return;
+	}
+
+	*static_cast<void**>(ptr) = pool_free;
+	pool_free = ptr;
+}
+
 void Hazard::logic() {
 
 	// if the hazard is on delay, take no action
@@ -221,8 +259,9 @@ void Hazard::reflect() {
 }
 
 void Hazard::loadAnimation(const std::string &s) {
-	if (!animation_name.empty()) {
-		anim->decreaseCount(animation_name);
+	if (animation_handle.isValid()) {
+		anim->decreaseCount(animation_handle);
+		animation_handle = AnimationManager::Handle();
 	}
 	if (activeAnimation) {
 		delete activeAnimation;
@@ -230,8 +269,8 @@ void Hazard::loadAnimation(const std::string &s) {
 	activeAnimation = NULL;
 	animation_name = s;
 	if (animation_name != "") {
-		anim->increaseCount(animation_name);
-		AnimationSet *animationSet = anim->getAnimationSet(animation_name);
+		animation_handle = anim->increaseCount(animation_name);
+		AnimationSet *animationSet = anim->getAnimationSet(animation_handle);
 		activeAnimation = animationSet->getAnimation("");
 	}
 
@@ -253,9 +292,7 @@ bool Hazard::hasEntity(Entity *ent) {
 		return parent->hasEntity(ent);
 	}
 	else {
-		for(std::vector<Entity*>::iterator it = entitiesCollided.begin(); it != entitiesCollided.end(); ++it)
-			if(*it == ent) return true;
-		return false;
+		return std::binary_search(entitiesCollided.begin(), entitiesCollided.end(), ent->entity_id);
 	}
 }
 
@@ -264,10 +301,16 @@ void Hazard::addEntity(Entity *ent) {
 		parent->addEntity(ent);
 	}
 	else {
-		entitiesCollided.push_back(ent);
+		addEntityID(ent->entity_id);
 	}
 }
 
+void Hazard::addEntityID(unsigned entity_id) {
+	std::vector<unsigned>::iterator it = std::lower_bound(entitiesCollided.begin(), entitiesCollided.end(), entity_id);
+	if (it == entitiesCollided.end() || *it != entity_id)
+		entitiesCollided.insert(it, entity_id);
+}
+
 void Hazard::addRenderable(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
 	if (delay_frames == 0 && activeAnimation) {
 		Renderable re = activeAnimation->getCurrentFrame(animationKind);
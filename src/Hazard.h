@@ -28,6 +28,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 class Entity;
 
+#include "AnimationManager.h"
 #include "CommonIncludes.h"
 #include "Utils.h"
 
@@ -43,6 +44,10 @@ public:
 	Hazard & operator= (const Hazard& other);
 	~Hazard();
 
+	// hazards are allocated from a pool, so that a volley of missiles doesn't go to the system allocator for each one
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr, size_t size);
+
 	void logic();
 	bool hasEntity(Entity*);
 	void addEntity(Entity*);
@@ -83,13 +88,19 @@ public:
 
 private:
     void reflect();
+	void addEntityID(unsigned entity_id);
 
 	const MapCollision *collider;
 	Animation *activeAnimation;
 	std::string animation_name;
+	AnimationManager::Handle animation_handle;
+
+	// Keeps track of entities already hit, as a sorted list of Entity::entity_id
+	std::vector<unsigned> entitiesCollided;
 
-	// Keeps track of entities already hit
-	std::vector<Entity*> entitiesCollided;
+	// freed slots are linked through their first bytes; the slots are never returned to the system
+	static const size_t POOL_CHUNK_SIZE = 64;
+	static void* pool_free;
 };
 
 #endif
@@ -25,6 +25,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "Avatar.h"
 #include "Animation.h"
+#include "Benchmark.h"
 #include "Enemy.h"
 #include "EnemyManager.h"
 #include "EventManager.h"
@@ -37,20 +38,33 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "SoundManager.h"
 #include "UtilsMath.h"
 
+namespace {
+
+// hazards hit entities in the order of EnemyManager::enemies, rather than the order of the grid buckets
+class CompareEnemyIndex {
+public:
+	bool operator()(const Entity* a, const Entity* b) const {
+		return a->enemy_index < b->enemy_index;
+	}
+};
+
+} // namespace
+
 HazardManager::HazardManager()
 	: last_enemy(NULL)
 {
 }
 
 void HazardManager::logic() {
+	BENCHMARK_ZONE(Benchmark::ZONE_HAZARD_LOGIC);
 
 	// remove all hazards with lifespan 0.  Most hazards still display their last frame.
 	for (size_t i=h.size(); i>0; i--) {
 		if (h[i-1]->lifespan == 0) {
-			delete h[i-1];
-			h.erase(h.begin()+(i-1));
+			removeHazard(i-1);
 		}
 	}
+	compactHazards();
 
 	checkNewHazards();
 
@@ -60,8 +74,7 @@ void HazardManager::logic() {
 
 		// remove all hazards that need to die immediately (e.g. exit the map)
 		if (h[i-1]->remove_now) {
-			delete h[i-1];
-			h.erase(h.begin()+(i-1));
+			removeHazard(i-1);
 			continue;
 		}
 
@@ -85,25 +98,35 @@ void HazardManager::logic() {
 		}
 
 	}
+	compactHazards();
 
 	// handle collisions
 	for (size_t i=0; i<h.size(); i++) {
 		if (h[i]->isDangerousNow()) {
 
+			// only entities in the grid cells around the hazard can be hit
+			nearby.clear();
+			enemym->grid.getInRadius(h[i]->pos, h[i]->power->radius, nearby);
+
+			// the first enemy hit by a hazard, and last_enemy, shouldn't depend on how entities are spread over the grid
+			std::sort(nearby.begin(), nearby.end(), CompareEnemyIndex());
+
 			// process hazards that can hurt enemies
 			if (h[i]->source_type != Power::SOURCE_TYPE_ENEMY) { //hero or neutral sources
-				for (unsigned int eindex = 0; eindex < enemym->enemies.size(); eindex++) {
+				for (size_t eindex = 0; eindex < nearby.size(); eindex++) {
+					if (nearby[eindex]->stats.hero)
+						continue;
+
+					Enemy* enemy = static_cast<Enemy*>(nearby[eindex]);
 
 					// only check living enemies
-					if (enemym->enemies[eindex]->stats.hp > 0 && h[i]->active && (enemym->enemies[eindex]->stats.hero_ally == h[i]->power->target_party)) {
-						if (Utils::isWithinRadius(h[i]->pos, h[i]->power->radius, enemym->enemies[eindex]->stats.pos)) {
-							if (!h[i]->hasEntity(enemym->enemies[eindex])) {
-								// hit!
-								h[i]->addEntity(enemym->enemies[eindex]);
-								hitEntity(i, enemym->enemies[eindex]->takeHit(*h[i]));
-								if (!h[i]->power->beacon) {
-									last_enemy = enemym->enemies[eindex];
-								}
+					if (enemy->stats.hp > 0 && h[i]->active && (enemy->stats.hero_ally == h[i]->power->target_party)) {
+						if (!h[i]->hasEntity(enemy)) {
+							// hit!
+							h[i]->addEntity(enemy);
+							hitEntity(i, enemy->takeHit(*h[i]));
+							if (!h[i]->power->beacon) {
+								last_enemy = enemy;
 							}
 						}
 					}
@@ -124,15 +147,18 @@ void HazardManager::logic() {
 				}
 
 				//now process allies
-				for (unsigned int eindex = 0; eindex < enemym->enemies.size(); eindex++) {
+				for (size_t eindex = 0; eindex < nearby.size(); eindex++) {
+					if (nearby[eindex]->stats.hero)
+						continue;
+
+					Enemy* ally = static_cast<Enemy*>(nearby[eindex]);
+
 					// only check living allies
-					if (enemym->enemies[eindex]->stats.hp > 0 && h[i]->active && enemym->enemies[eindex]->stats.hero_ally) {
-						if (Utils::isWithinRadius(h[i]->pos, h[i]->power->radius, enemym->enemies[eindex]->stats.pos)) {
-							if (!h[i]->hasEntity(enemym->enemies[eindex])) {
-								// hit!
-								h[i]->addEntity(enemym->enemies[eindex]);
-								hitEntity(i, enemym->enemies[eindex]->takeHit(*h[i]));
-							}
+					if (ally->stats.hp > 0 && h[i]->active && ally->stats.hero_ally) {
+						if (!h[i]->hasEntity(ally)) {
+							// hit!
+							h[i]->addEntity(ally);
+							hitEntity(i, ally->takeHit(*h[i]));
 						}
 					}
 				}
@@ -143,6 +169,31 @@ void HazardManager::logic() {
 	}
 }
 
+/**
+ * Deletes a hazard and leaves an empty slot, which is removed by compactHazards()
+ * Hazards are iterated from the back when removing them, so the empty slot is never visited.
+ */
+void HazardManager::removeHazard(size_t index) {
+	delete h[index];
+	h[index] = NULL;
+}
+
+/**
+ * Removes the empty slots in a single pass
+ * The remaining hazards keep the order they were spawned in, which decides the hazard that hits first
+ * (and sets last_enemy) when several hazards reach an entity in the same frame.
+ */
+void HazardManager::compactHazards() {
+	size_t count = 0;
+	for (size_t i = 0; i < h.size(); ++i) {
+		if (h[i]) {
+			h[count] = h[i];
+			count++;
+		}
+	}
+	h.resize(count);
+}
+
 void HazardManager::hitEntity(size_t index, const bool hit) {
 	if (!hit) return;
 
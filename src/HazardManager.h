@@ -30,11 +30,17 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 class Avatar;
 class Enemy;
+class Entity;
 class Hazard;
 
 class HazardManager {
 private:
 	void hitEntity(size_t index, const bool hit);
+	void removeHazard(size_t index);
+	void compactHazards();
+
+	// entities near the hazard currently being checked
+	std::vector<Entity*> nearby;
 
 public:
 	HazardManager();
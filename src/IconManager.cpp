@@ -34,6 +34,7 @@ IconManager::IconManager()
 	: current_set(NULL)
 {
 	FileParser infile;
+	std::vector<std::pair<int, std::string> > icon_set_files;
 
 	// @CLASS IconManager|Description of engine/icons.txt
 	if (infile.open("engine/icons.txt", FileParser::MOD_FILE, FileParser::ERROR_NONE)) {
@@ -43,10 +44,7 @@ IconManager::IconManager()
 				int first_id = Parse::popFirstInt(infile.val);
 				std::string filename = Parse::popFirstString(infile.val);
 
-				icon_sets.resize(icon_sets.size()+1);
-				if (!loadIconSet(icon_sets.back(), filename, first_id)) {
-					icon_sets.pop_back();
-				}
+				icon_set_files.push_back(std::pair<int, std::string>(first_id, filename));
 			}
 			else if (infile.key == "text_offset") {
 				// @ATTR text_offset|point|A pixel offset from the top-left to place item quantity text on icons.
@@ -56,6 +54,26 @@ IconManager::IconManager()
 		infile.close();
 	}
 
+	// decode all icon images at once; loadIconSet() then finds them in the image cache
+	std::vector<Image*> pending_images;
+	if (render_device && eset->resolutions.icon_size > 0) {
+		for (size_t i = 0; i < icon_set_files.size(); ++i) {
+			pending_images.push_back(render_device->loadImageAsync(icon_set_files[i].second, RenderDevice::ERROR_NONE));
+		}
+		render_device->waitForImageLoads();
+	}
+
+	for (size_t i = 0; i < icon_set_files.size(); ++i) {
+		icon_sets.resize(icon_sets.size()+1);
+		if (!loadIconSet(icon_sets.back(), icon_set_files[i].second, icon_set_files[i].first)) {
+			icon_sets.pop_back();
+		}
+	}
+
+	for (size_t i = 0; i < pending_images.size(); ++i) {
+		pending_images[i]->unref();
+	}
+
 	if (icon_sets.empty()) {
 		// no icons.txt file, so load icons.png legacy-style
 		icon_sets.resize(1);
@@ -85,7 +85,7 @@ Item::Item()
 	, no_stash(NO_STASH_IGNORE) {
 }
 
-ItemManager::ItemManager()
+ItemManager::ItemManager(bool defer_sounds)
 {
 	// These values are a bit arbitrary, but they should be a good starting point.
 	items.reserve(1000);
@@ -97,6 +97,19 @@ ItemManager::ItemManager()
 	if (items.empty()) {
 		addUnknownItem(1);
 	}
+
+	if (!defer_sounds)
+		loadSounds();
+}
+
+/**
+ * Sounds are loaded after all item files have been parsed, so that only the sound that an item ends up with is loaded
+ */
+void ItemManager::loadSounds() {
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (!items[i].sfx.empty() && items[i].sfx_id == 0)
+			items[i].sfx_id = snd->load(items[i].sfx, "ItemManager");
+	}
 }
 
 /**
@@ -290,7 +303,6 @@ void ItemManager::loadItems(const std::string& filename) {
 		else if (infile.key == "soundfx") {
 			// @ATTR soundfx|filename|Sound effect filename to play for the specific item.
 			items[id].sfx = infile.val;
-			items[id].sfx_id = snd->load(items[id].sfx, "ItemManager");
 		}
 		else if (infile.key == "gfx")
 			// @ATTR gfx|filename|Filename of an animation set to display when the item is equipped.
@@ -214,9 +214,13 @@ public:
 	};
 
 	static const bool DEFAULT_SELL_PRICE = true;
+	static const bool DEFER_SOUNDS = true;
 
-	ItemManager();
+	// the item files can be parsed on a loading thread by passing DEFER_SOUNDS
+	// loadSounds() then has to be called on the main thread before the items are used
+	explicit ItemManager(bool defer_sounds = false);
 	~ItemManager();
+	void loadSounds();
 	void playSound(int item, const Point& pos = Point(0,0));
 	TooltipData getTooltip(ItemStack stack, StatBlock *stats, int context);
 	TooltipData getShortTooltip(ItemStack item);
@@ -28,6 +28,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "AnimationManager.h"
 #include "AnimationSet.h"
 #include "Avatar.h"
+#include "Benchmark.h"
 #include "CommonIncludes.h"
 #include "CursorManager.h"
 #include "Enemy.h"
@@ -84,6 +85,8 @@ void LootManager::handleNewMap() {
 }
 
 void LootManager::logic() {
+	BENCHMARK_ZONE(Benchmark::ZONE_LOOT_LOGIC);
+
 	std::vector<Loot>::iterator it;
 	for (it = loot.begin(); it != loot.end(); ++it) {
 
@@ -36,6 +36,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 Map::Map()
 	: filename("")
 	, collision_layer(-1)
+	, layer_format(LAYER_FORMAT_DEC)
 	, layers()
 	, events()
 	, w(1)
@@ -133,10 +134,7 @@ int Map::load(const std::string& fname) {
 	if (std::find(layernames.begin(), layernames.end(), "collision") == layernames.end()) {
 		layernames.push_back("collision");
 		layers.resize(layers.size()+1);
-		layers.back().resize(w);
-		for (size_t i=0; i<layers.back().size(); ++i) {
-			layers.back()[i].resize(h, 0);
-		}
+		layers.back().init(w, h);
 		collision_layer = static_cast<int>(layers.size())-1;
 	}
 
@@ -200,47 +198,54 @@ void Map::loadLayer(FileParser &infile) {
 	if (infile.key == "type") {
 		// @ATTR layer.type|string|Map layer type.
 		layers.resize(layers.size()+1);
-		layers.back().resize(w);
-		for (size_t i=0; i<layers.back().size(); ++i) {
-			layers.back()[i].resize(h);
-		}
+		layers.back().init(w, h);
 		layernames.push_back(infile.val);
 		if (infile.val == "collision")
 			collision_layer = static_cast<int>(layernames.size())-1;
+		layer_format = LAYER_FORMAT_DEC;
 	}
 	else if (infile.key == "format") {
-		// @ATTR layer.format|string|Format for map layer, must be 'dec'
-		if (infile.val != "dec") {
-			infile.error("Map: The format of a layer must be 'dec'!");
-			Utils::logErrorDialog("Map: The format of a layer must be 'dec'!");
+		// @ATTR layer.format|["dec", "rle"]|Format for map layer data. Defaults to 'dec'.
+		if (infile.val == "dec") {
+			layer_format = LAYER_FORMAT_DEC;
+		}
+		else if (infile.val == "rle") {
+			layer_format = LAYER_FORMAT_RLE;
+		}
+		else {
+			infile.error("Map: The format of a layer must be 'dec' or 'rle'!");
+			Utils::logErrorDialog("Map: The format of a layer must be 'dec' or 'rle'!");
 			mods->resetModConfig();
 			Utils::Exit(1);
 		}
 	}
 	else if (infile.key == "data") {
-		// @ATTR layer.data|raw|Raw map layer data
+		// @ATTR layer.data|raw|Raw map layer data. For the 'rle' format, the data is on the same line as the key.
+		if (layers.empty()) {
+			infile.error("Map: Layer data found before the layer type.");
+			return;
+		}
+
+		if (layer_format == LAYER_FORMAT_RLE) {
+			if (!decodeLayerRLE(infile.val, layers.back(), w, h)) {
+				infile.error("Map: The layer data is not valid for a %dx%d map.", w, h);
+				mods->resetModConfig();
+				Utils::Exit(1);
+			}
+			return;
+		}
+
 		// layer map data handled as a special case
 		// The next h lines must contain layer data.
-		for (int j=0; j<h; j++) {
+		for (unsigned short j=0; j<h; j++) {
 			std::string val = infile.getRawLine();
 			infile.incrementLineNum();
-			if (!val.empty() && val[val.length()-1] != ',') {
-				val += ',';
-			}
 
-			// verify the width of this row
-			int comma_count = 0;
-			for (unsigned i=0; i<val.length(); ++i) {
-				if (val[i] == ',') comma_count++;
-			}
-			if (comma_count != w) {
+			if (!parseLayerRow(val, layers.back(), w, j)) {
 				infile.error("Map: A row of layer data has a width not equal to %d.", w);
 				mods->resetModConfig();
 				Utils::Exit(1);
 			}
-
-			for (int i=0; i<w; i++)
-				layers.back()[i][j] = static_cast<unsigned short>(Parse::popFirstInt(val));
 		}
 	}
 	else {
@@ -248,6 +253,109 @@ void Map::loadLayer(FileParser &infile) {
 	}
 }
 
+bool Map::parseLayerRow(std::string& val, Map_Layer& layer, unsigned short w, unsigned short row) {
+	if (!val.empty() && val[val.length()-1] != ',') {
+		val += ',';
+	}
+
+	// verify the width of this row
+	int comma_count = 0;
+	for (unsigned i=0; i<val.length(); ++i) {
+		if (val[i] == ',') comma_count++;
+	}
+	if (comma_count != w)
+		return false;
+
+	for (int i=0; i<w; i++)
+		layer(i, row) = static_cast<unsigned short>(Parse::popFirstInt(val));
+
+	return true;
+}
+
+/**
+ * The RLE layer format is a base64-encoded list of runs, in row-major order.
+ * Each run is a tile count followed by a tile ID, both stored as unsigned LEB128 varints.
+ */
+std::string Map::encodeLayerRLE(const Map_Layer& layer, unsigned short w, unsigned short h) {
+	std::vector<unsigned char> data;
+
+	if (layer.getWidth() != w || layer.getHeight() != h)
+		return "";
+
+	const unsigned short* tiles = layer.getRow(0);
+	const unsigned long tile_count = static_cast<unsigned long>(w) * h;
+	unsigned long run_length = 0;
+	unsigned short run_tile = 0;
+
+	for (unsigned long i = 0; i <= tile_count; ++i) {
+		bool at_end = (i == tile_count);
+		unsigned short tile = at_end ? 0 : tiles[i];
+
+		if (run_length > 0 && (at_end || tile != run_tile)) {
+			unsigned long vals[2] = {run_length, run_tile};
+			for (int j = 0; j < 2; ++j) {
+				unsigned long val = vals[j];
+				while (val >= 0x80) {
+					data.push_back(static_cast<unsigned char>((val & 0x7f) | 0x80));
+					val >>= 7;
+				}
+				data.push_back(static_cast<unsigned char>(val));
+			}
+			run_length = 0;
+		}
+
+		run_tile = tile;
+		run_length++;
+	}
+
+	return Utils::encodeBase64(data);
+}
+
+/**
+ * Writes the tiles straight into layer, which must already be sized to w by h.
+ * Returns false if the data is malformed or doesn't cover exactly w * h tiles.
+ */
+bool Map::decodeLayerRLE(const std::string& data, Map_Layer& layer, unsigned short w, unsigned short h) {
+	std::vector<unsigned char> bytes;
+	if (!Utils::decodeBase64(data, bytes))
+		return false;
+
+	if (layer.getWidth() != w || layer.getHeight() != h)
+		return false;
+
+	// layers are stored in row-major order, so runs can be written to the tiles in one pass
+	unsigned short* tiles = layer.getRow(0);
+	const unsigned long tile_count = static_cast<unsigned long>(w) * h;
+	unsigned long pos = 0;
+	size_t i = 0;
+
+	while (i < bytes.size()) {
+		unsigned long vals[2] = {0, 0};
+		for (int j = 0; j < 2; ++j) {
+			int shift = 0;
+			while (true) {
+				// varints longer than 4 bytes can't be valid here
+				if (i >= bytes.size() || shift > 21)
+					return false;
+				unsigned char byte = bytes[i++];
+				vals[j] |= static_cast<unsigned long>(byte & 0x7f) << shift;
+				if (!(byte & 0x80))
+					break;
+				shift += 7;
+			}
+		}
+
+		const unsigned long run_length = vals[0];
+		if (run_length == 0 || run_length > tile_count - pos || vals[1] > 0xffff)
+			return false;
+
+		std::fill(tiles + pos, tiles + pos + run_length, static_cast<unsigned short>(vals[1]));
+		pos += run_length;
+	}
+
+	return pos == tile_count;
+}
+
 void Map::loadEnemyGroup(FileParser &infile, Map_Group *group) {
 	if (infile.key == "type") {
 		// @ATTR enemygroup.type|string|(IGNORED BY ENGINE) The "type" field, as used by Tiled and other mapping tools.
@@ -135,7 +135,14 @@ protected:
 	std::string tileset;
 
 	int collision_layer;
+	int layer_format;
 public:
+	// map layer formats
+	enum {
+		LAYER_FORMAT_DEC = 0, // rows of comma-separated tile IDs, one row per line after "data="
+		LAYER_FORMAT_RLE = 1 // base64-encoded runs of tile IDs on the same line as "data="
+	};
+
 	Map();
 	~Map();
 	std::string getFilename() { return filename; }
@@ -145,6 +152,12 @@ public:
 
 	int load(const std::string& filename);
 
+	// returns false if the row doesn't contain exactly w tile IDs
+	static bool parseLayerRow(std::string& val, Map_Layer& layer, unsigned short w, unsigned short row);
+
+	static std::string encodeLayerRLE(const Map_Layer& layer, unsigned short w, unsigned short h);
+	static bool decodeLayerRLE(const std::string& data, Map_Layer& layer, unsigned short w, unsigned short h);
+
 	std::string music_filename;
 
 	std::vector<Map_Layer> layers; // visible layers in maprenderer
@@ -30,7 +30,6 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define NDEBUG
 #endif
 
-#include "AStarContainer.h"
 #include "AStarNode.h"
 #include "EngineSettings.h"
 #include "MapCollision.h"
@@ -46,23 +45,100 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 const float MapCollision::MIN_TILE_GAP = 0.001f;
 
 MapCollision::MapCollision()
-	: map_size(Point())
+	: flow_field_ticks(0)
+	, collision_version(0)
+	, changed_tiles_generation(0)
+	, copied(false)
+	, copied_generation(0)
+	, copied_changes(0)
+	, map_size(Point())
+	, path_nodes_expanded(0)
 {
-	colmap.resize(1);
-	colmap[0].resize(1);
+	colmap.init(1, 1);
 }
 
 void MapCollision::setMap(const Map_Layer& _colmap, unsigned short w, unsigned short h) {
-	colmap.resize(w);
-	for (unsigned i=0; i<w; ++i) {
-		colmap[i].resize(h);
+	if (_colmap.getWidth() == w && _colmap.getHeight() == h) {
+		colmap = _colmap;
 	}
-	for (unsigned i=0; i<w; i++)
+	else {
+		colmap.init(w, h);
 		for (unsigned j=0; j<h; j++)
-			colmap[i][j] = _colmap[i][j];
+			for (unsigned i=0; i<w; i++)
+				colmap(i, j) = _colmap.get(i, j);
+	}
 
 	map_size.x = w;
 	map_size.y = h;
+
+	astar.init(w, h, (w * h) / 10);
+
+	astar_hierarchy.init(w, h);
+	for (int i=0; i<w; i++)
+		for (int j=0; j<h; j++)
+			astar_hierarchy.setPassable(i, j, isStaticPassable(i, j, MOVE_NORMAL));
+	astar_hierarchy.update();
+
+	invalidateFlowFields();
+	collision_version++;
+
+	changed_tiles.clear();
+	changed_tiles_generation++;
+}
+
+/**
+ * Change a single collision tile (e.g. from a MAPMOD event) and patch the path hierarchy
+ */
+void MapCollision::setTile(const int& tile_x, const int& tile_y, unsigned short value) {
+	if (isTileOutsideMap(tile_x, tile_y)) return;
+
+	colmap(tile_x, tile_y) = value;
+	astar_hierarchy.setPassable(tile_x, tile_y, isStaticPassable(tile_x, tile_y, MOVE_NORMAL));
+	invalidateFlowFields();
+	collision_version++;
+	logTileChange(tile_x, tile_y);
+}
+
+void MapCollision::logTileChange(int tile_x, int tile_y) {
+	if (changed_tiles.size() >= MAX_CHANGED_TILES) {
+		changed_tiles.clear();
+		changed_tiles_generation++;
+	}
+	changed_tiles.push_back(Point(tile_x, tile_y));
+}
+
+/**
+ * Copy the collision layer from another map, such as for searching paths on a separate thread
+ * Only the tiles that changed since the last copy are copied, unless the other map's change log was reset.
+ * The path hierarchy is only rebuilt when the other map's static collision has changed
+ */
+void MapCollision::copyCollision(const MapCollision& other) {
+	if (map_size.x != other.map_size.x || map_size.y != other.map_size.y) {
+		setMap(other.colmap, static_cast<unsigned short>(other.map_size.x), static_cast<unsigned short>(other.map_size.y));
+		collision_version = other.collision_version;
+	}
+	else if (copied && copied_generation == other.changed_tiles_generation) {
+		for (size_t i = copied_changes; i < other.changed_tiles.size(); ++i) {
+			const Point& tile = other.changed_tiles[i];
+			colmap(tile.x, tile.y) = other.colmap(tile.x, tile.y);
+			astar_hierarchy.setPassable(tile.x, tile.y, isStaticPassable(tile.x, tile.y, MOVE_NORMAL));
+		}
+	}
+	else {
+		colmap = other.colmap;
+	}
+
+	copied = true;
+	copied_generation = other.changed_tiles_generation;
+	copied_changes = other.changed_tiles.size();
+
+	if (collision_version != other.collision_version) {
+		for (int i=0; i<map_size.x; i++)
+			for (int j=0; j<map_size.y; j++)
+				astar_hierarchy.setPassable(i, j, isStaticPassable(i, j, MOVE_NORMAL));
+		invalidateFlowFields();
+		collision_version = other.collision_version;
+	}
 }
 
 int sgn(float f) {
@@ -221,7 +297,7 @@ bool MapCollision::isEmpty(const float& x, const float& y) const {
 	if (isTileOutsideMap(tile_x, tile_y)) return false;
 
 	// collision type check
-	return (colmap[tile_x][tile_y] == BLOCKS_NONE || colmap[tile_x][tile_y] == MAP_ONLY || colmap[tile_x][tile_y] == MAP_ONLY_ALT);
+	return (colmap(tile_x, tile_y) == BLOCKS_NONE || colmap(tile_x, tile_y) == MAP_ONLY || colmap(tile_x, tile_y) == MAP_ONLY_ALT);
 }
 
 /**
@@ -235,7 +311,7 @@ bool MapCollision::isWall(const float& x, const float& y) const {
 	if (isTileOutsideMap(tile_x, tile_y)) return true;
 
 	// collision type check
-	return (colmap[tile_x][tile_y] == BLOCKS_ALL || colmap[tile_x][tile_y] == BLOCKS_ALL_HIDDEN);
+	return (colmap(tile_x, tile_y) == BLOCKS_ALL || colmap(tile_x, tile_y) == BLOCKS_ALL_HIDDEN);
 }
 
 /**
@@ -246,13 +322,13 @@ bool MapCollision::isValidTile(const int& tile_x, const int& tile_y, int movemen
 	if (isTileOutsideMap(tile_x,tile_y)) return false;
 
 	if (collide_type == COLLIDE_NORMAL) {
-		if (colmap[tile_x][tile_y] == BLOCKS_ENEMIES)
+		if (colmap(tile_x, tile_y) == BLOCKS_ENEMIES)
 			return false;
-		if (colmap[tile_x][tile_y] == BLOCKS_ENTITIES)
+		if (colmap(tile_x, tile_y) == BLOCKS_ENTITIES)
 			return false;
 	}
 	else if (collide_type == COLLIDE_HERO) {
-		if (colmap[tile_x][tile_y] == BLOCKS_ENEMIES && !eset->misc.enable_ally_collision)
+		if (colmap(tile_x, tile_y) == BLOCKS_ENEMIES && !eset->misc.enable_ally_collision)
 			return true;
 	}
 
@@ -262,14 +338,31 @@ bool MapCollision::isValidTile(const int& tile_x, const int& tile_y, int movemen
 
 	// flying creatures can't be in walls
 	if (movement_type == MOVE_FLYING) {
-		return (!(colmap[tile_x][tile_y] == BLOCKS_ALL || colmap[tile_x][tile_y] == BLOCKS_ALL_HIDDEN));
+		return (!(colmap(tile_x, tile_y) == BLOCKS_ALL || colmap(tile_x, tile_y) == BLOCKS_ALL_HIDDEN));
 	}
 
-	if (colmap[tile_x][tile_y] == MAP_ONLY || colmap[tile_x][tile_y] == MAP_ONLY_ALT)
+	if (colmap(tile_x, tile_y) == MAP_ONLY || colmap(tile_x, tile_y) == MAP_ONLY_ALT)
 		return true;
 
 	// normal creatures can only be in empty spaces
-	return (colmap[tile_x][tile_y] == BLOCKS_NONE);
+	return (colmap(tile_x, tile_y) == BLOCKS_NONE);
+}
+
+/**
+ * Can an entity with this movement type ever stand on this tile? Entities are ignored, since they move around.
+ * computePath() never expands into the first row or column, so those are treated as impassable.
+ */
+bool MapCollision::isStaticPassable(const int& tile_x, const int& tile_y, int movement_type) const {
+	if (tile_x < node_stride || tile_y < node_stride || isTileOutsideMap(tile_x, tile_y)) return false;
+
+	const unsigned short tile = colmap(tile_x, tile_y);
+
+	if (movement_type == MOVE_INTANGIBLE)
+		return true;
+	else if (movement_type == MOVE_FLYING)
+		return !(tile == BLOCKS_ALL || tile == BLOCKS_ALL_HIDDEN);
+
+	return (tile == BLOCKS_NONE || tile == MAP_ONLY || tile == MAP_ONLY_ALT || tile == BLOCKS_ENTITIES || tile == BLOCKS_ENEMIES);
 }
 
 /**
@@ -342,8 +435,8 @@ bool MapCollision::lineOfMovement(const float& x1, const float& y1, const float&
 	int tile_x = int(x2);
 	int tile_y = int(y2);
 	bool target_blocks = false;
-	int target_blocks_type = colmap[tile_x][tile_y];
-	if (colmap[tile_x][tile_y] == BLOCKS_ENTITIES || colmap[tile_x][tile_y] == BLOCKS_ENEMIES) {
+	int target_blocks_type = colmap(tile_x, tile_y);
+	if (colmap(tile_x, tile_y) == BLOCKS_ENTITIES || colmap(tile_x, tile_y) == BLOCKS_ENEMIES) {
 		target_blocks = true;
 		unblock(x2,y2);
 	}
@@ -393,6 +486,14 @@ bool MapCollision::computePath(const FPoint& start_pos, const FPoint& end_pos, s
 
 	if (isOutsideMap(end_pos.x, end_pos.y)) return false;
 
+	// long paths for normal movement are planned on the cluster graph first
+	if (limit == DEFAULT_PATH_LIMIT && movement_type == MOVE_NORMAL && astar_hierarchy.isLongDistance(Point(start_pos), Point(end_pos))) {
+		bool found = computeHierarchicalPath(Point(start_pos), Point(end_pos), path);
+		path_nodes_expanded += static_cast<unsigned>(astar_hierarchy.getNodesExpanded());
+		if (found)
+			return true;
+	}
+
 	// default limit set to 10% of the total map size
 	if (limit == 0)
 		limit = (map_size.x * map_size.y) / 10;
@@ -407,43 +508,38 @@ bool MapCollision::computePath(const FPoint& start_pos, const FPoint& end_pos, s
 
 	// if the target square has an entity, temporarily clear it to compute the path
 	bool target_blocks = false;
-	int target_blocks_type = colmap[end.x][end.y];
-	if (colmap[end.x][end.y] == BLOCKS_ENTITIES || colmap[end.x][end.y] == BLOCKS_ENEMIES) {
+	int target_blocks_type = colmap(end.x, end.y);
+	if (colmap(end.x, end.y) == BLOCKS_ENTITIES || colmap(end.x, end.y) == BLOCKS_ENEMIES) {
 		target_blocks = true;
 		unblock(end_pos.x, end_pos.y);
 	}
 
 	Point current = start;
-	AStarNode* node = new AStarNode(start);
-	node->setActualCost(0);
-	node->setEstimatedCost(Utils::calcDist(FPoint(start),FPoint(end)));
-	node->setParent(current);
+	AStarNode* node = NULL;
+	Point neighbours[node_max_neighbours];
 
-	AStarContainer open(map_size.x, map_size.y, limit);
-	AStarCloseContainer close(map_size.x, map_size.y, limit);
+	astar.reset(limit);
+	astar.addOpen(start, current, 0, Utils::calcDist(FPoint(start),FPoint(end)));
 
-	open.add(node);
-
-	while (!open.isEmpty() && static_cast<unsigned>(close.getSize()) < limit) {
-		node = open.get_shortest_f();
+	while (!astar.isOpenEmpty() && static_cast<unsigned>(astar.getCloseSize()) < limit) {
+		node = astar.get_shortest_f();
 
 		current.x = node->getX();
 		current.y = node->getY();
-		close.add(node);
-		open.remove(node);
+		astar.closeShortest();
 
 		if ( current.x == end.x && current.y == end.y)
 			break; //path found !
 
 		//limit evaluated nodes to the size of the map
-		std::list<Point> neighbours = node->getNeighbours(map_size.x, map_size.y);
+		int neighbour_count = node->getNeighbours(neighbours, map_size.x, map_size.y);
 
 		// for every neighbour of current node
-		for (std::list<Point>::iterator it=neighbours.begin(); it != neighbours.end(); ++it)	{
-			Point neighbour = *it;
+		for (int i = 0; i < neighbour_count; ++i) {
+			const Point& neighbour = neighbours[i];
 
 			// do not exceed the node limit when adding nodes
-			if (static_cast<unsigned>(open.getSize()) >= limit) {
+			if (static_cast<unsigned>(astar.getOpenSize()) >= limit) {
 				break;
 			}
 
@@ -451,25 +547,18 @@ bool MapCollision::computePath(const FPoint& start_pos, const FPoint& end_pos, s
 			if (!isValidTile(neighbour.x,neighbour.y,movement_type, MapCollision::COLLIDE_NORMAL))
 				continue;
 			// if nabour is already in close, skip it
-			if(close.exists(neighbour))
+			if(astar.isClosed(neighbour))
 				continue;
 
+			float actual_cost = node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour));
+
 			// if neighbour isn't inside open, add it as a new Node
-			if(!open.exists(neighbour)) {
-				AStarNode* newNode = new AStarNode(neighbour);
-				newNode->setActualCost(node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour)));
-				newNode->setParent(current);
-				newNode->setEstimatedCost(Utils::calcDist(FPoint(neighbour),FPoint(end)));
-				open.add(newNode);
+			if(!astar.isOpen(neighbour)) {
+				astar.addOpen(neighbour, current, actual_cost, Utils::calcDist(FPoint(neighbour),FPoint(end)));
 			}
 			// else, update it's cost if better
-			else {
-				AStarNode* i = open.get(neighbour.x, neighbour.y);
-				if (node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour)) < i->getActualCost()) {
-					Point pos(i->getX(), i->getY());
-					Point parent_pos(node->getX(), node->getY());
-					open.updateParent(pos, parent_pos, node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour)));
-				}
+			else if (actual_cost < astar.get(neighbour.x, neighbour.y)->getActualCost()) {
+				astar.updateParent(neighbour, current, actual_cost);
 			}
 		}
 	}
@@ -477,13 +566,15 @@ bool MapCollision::computePath(const FPoint& start_pos, const FPoint& end_pos, s
 	if (!(current.x == end.x && current.y == end.y)) {
 
 		//couldnt find the target so map a path to the closest node found
-		node = close.get_shortest_h();
-		current.x = node->getX();
-		current.y = node->getY();
-
-		while (!(current.x == start.x && current.y == start.y)) {
-			path.push_back(collisionToMap(current));
-			current = close.get(current.x, current.y)->getParent();
+		node = astar.get_shortest_h();
+		if (node) {
+			current.x = node->getX();
+			current.y = node->getY();
+
+			while (!(current.x == start.x && current.y == start.y)) {
+				path.push_back(collisionToMap(current));
+				current = astar.get(current.x, current.y)->getParent();
+			}
 		}
 	}
 	else {
@@ -491,24 +582,117 @@ bool MapCollision::computePath(const FPoint& start_pos, const FPoint& end_pos, s
 		path.push_back(collisionToMap(end));
 		while (!(current.x == start.x && current.y == start.y)) {
 			path.push_back(collisionToMap(current));
-			current = close.get(current.x, current.y)->getParent();
+			current = astar.get(current.x, current.y)->getParent();
 		}
 	}
+	path_nodes_expanded += static_cast<unsigned>(astar.getCloseSize());
+
 	// reblock target if needed
 	if (target_blocks) block(end_pos.x, end_pos.y, target_blocks_type == BLOCKS_ENEMIES);
 
 	return !path.empty();
 }
 
+/**
+ * Plan a path on the cluster graph, then refine each step between waypoints with regular A*
+ * The resulting path is stored from end to start, same as computePath()
+ * @return false if any part of the path can't be completed; the caller should fall back to regular A*
+ */
+bool MapCollision::computeHierarchicalPath(const Point& start, const Point& end, std::vector<FPoint> &path) {
+	if (!astar_hierarchy.findPath(start, end, hierarchy_waypoints))
+		return false;
+
+	// waypoints are adjacent or share a cluster, so a small limit is enough
+	const unsigned int segment_limit = AStarHierarchy::CLUSTER_SIZE * AStarHierarchy::CLUSTER_SIZE * 2;
+
+	path.clear();
+	for (int i = static_cast<int>(hierarchy_waypoints.size()) - 1; i >= 0; --i) {
+		const Point& to = hierarchy_waypoints[i];
+		const Point& from = (i > 0) ? hierarchy_waypoints[i-1] : start;
+
+		if (from.x == to.x && from.y == to.y)
+			continue;
+
+		computePath(collisionToMap(from), collisionToMap(to), hierarchy_segment, MOVE_NORMAL, segment_limit);
+
+		// the segment must reach its waypoint, otherwise the path would have a gap
+		if (hierarchy_segment.empty() || Point(hierarchy_segment.front()).x != to.x || Point(hierarchy_segment.front()).y != to.y) {
+			path.clear();
+			return false;
+		}
+
+		path.insert(path.end(), hierarchy_segment.begin(), hierarchy_segment.end());
+	}
+
+	return !path.empty();
+}
+
+/**
+ * Like computePath(), but follows a flow field that is shared with every other entity heading to the same tile
+ * Falls back to computePath() if flow fields are disabled for this movement type or the start is outside the field
+ */
+bool MapCollision::computeFlowPath(const FPoint& start_pos, const FPoint& end_pos, std::vector<FPoint> &path, int movement_type) {
+	if (!eset->misc.flow_field_pathing || (movement_type != MOVE_NORMAL && eset->misc.flow_field_normal_movement_only))
+		return computePath(start_pos, end_pos, path, movement_type, DEFAULT_PATH_LIMIT);
+
+	if (isOutsideMap(end_pos.x, end_pos.y)) return false;
+
+	Point start(start_pos);
+	Point end(end_pos);
+
+	flow_field_ticks++;
+
+	FlowField* field = NULL;
+	for (int i = 0; i < FLOW_FIELD_COUNT; ++i) {
+		if (flow_fields[i].matches(end, movement_type)) {
+			field = &flow_fields[i];
+			break;
+		}
+	}
+
+	if (!field) {
+		field = &flow_fields[0];
+		for (int i = 1; i < FLOW_FIELD_COUNT; ++i) {
+			if (!flow_fields[i].isValid() || (field->isValid() && flow_fields[i].last_used < field->last_used))
+				field = &flow_fields[i];
+		}
+		field->compute(this, end, movement_type);
+	}
+	field->last_used = flow_field_ticks;
+
+	path.clear();
+
+	// walk downhill to the target, then reverse so that the path is stored from end to start
+	Point current = start;
+	Point next;
+	while (field->getNextStep(current, next)) {
+		path.push_back(collisionToMap(next));
+		current = next;
+	}
+
+	if (path.empty() || current.x != end.x || current.y != end.y)
+		return computePath(start_pos, end_pos, path, movement_type, DEFAULT_PATH_LIMIT);
+
+	std::reverse(path.begin(), path.end());
+	return true;
+}
+
+void MapCollision::invalidateFlowFields() {
+	for (int i = 0; i < FLOW_FIELD_COUNT; ++i) {
+		flow_fields[i].invalidate();
+	}
+}
+
 void MapCollision::block(const float& map_x, const float& map_y, bool is_ally) {
 	const int tile_x = int(map_x);
 	const int tile_y = int(map_y);
 
-	if (colmap[tile_x][tile_y] == BLOCKS_NONE) {
+	if (colmap(tile_x, tile_y) == BLOCKS_NONE) {
 		if(is_ally)
-			colmap[tile_x][tile_y] = BLOCKS_ENEMIES;
+			colmap(tile_x, tile_y) = BLOCKS_ENEMIES;
 		else
-			colmap[tile_x][tile_y] = BLOCKS_ENTITIES;
+			colmap(tile_x, tile_y) = BLOCKS_ENTITIES;
+		logTileChange(tile_x, tile_y);
 	}
 
 }
@@ -517,10 +701,16 @@ void MapCollision::unblock(const float& map_x, const float& map_y) {
 	const int tile_x = int(map_x);
 	const int tile_y = int(map_y);
 
-	if (colmap[tile_x][tile_y] == BLOCKS_ENTITIES || colmap[tile_x][tile_y] == BLOCKS_ENEMIES ||
+	if (colmap(tile_x, tile_y) == BLOCKS_ENTITIES || colmap(tile_x, tile_y) == BLOCKS_ENEMIES ||
 		// TODO: check this logic
-		colmap[tile_x][tile_y] == BLOCKS_MOVEMENT_HIDDEN) {
-		colmap[tile_x][tile_y] = BLOCKS_NONE;
+		colmap(tile_x, tile_y) == BLOCKS_MOVEMENT_HIDDEN) {
+		if (colmap(tile_x, tile_y) == BLOCKS_MOVEMENT_HIDDEN) {
+			invalidateFlowFields();
+			collision_version++;
+		}
+		colmap(tile_x, tile_y) = BLOCKS_NONE;
+		astar_hierarchy.setPassable(tile_x, tile_y, isStaticPassable(tile_x, tile_y, MOVE_NORMAL));
+		logTileChange(tile_x, tile_y);
 	}
 
 }
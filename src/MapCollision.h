@@ -26,11 +26,13 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef MAP_COLLISION_H
 #define MAP_COLLISION_H
 
+#include "AStarContainer.h"
+#include "AStarHierarchy.h"
 #include "CommonIncludes.h"
+#include "FlowField.h"
+#include "MapLayer.h"
 #include "Utils.h"
 
-typedef std::vector< std::vector<unsigned short> > Map_Layer;
-
 class MapCollision {
 private:
 	static const float MIN_TILE_GAP;
@@ -56,6 +58,37 @@ private:
 
 	FPoint collisionToMap(const Point& p);
 
+	void invalidateFlowFields();
+	bool computeHierarchicalPath(const Point& start, const Point& end, std::vector<FPoint> &path);
+
+	// reusable pathfinding workspace, sized in setMap()
+	AStarContainer astar;
+
+	// cluster graph for long distance paths, built in setMap()
+	AStarHierarchy astar_hierarchy;
+	std::vector<Point> hierarchy_waypoints;
+	std::vector<FPoint> hierarchy_segment;
+
+	// fields shared by entities chasing the same target; the least recently used one is replaced
+	static const int FLOW_FIELD_COUNT = 4;
+	FlowField flow_fields[FLOW_FIELD_COUNT];
+	unsigned int flow_field_ticks;
+
+	// incremented whenever static collision changes, so copyCollision() knows when to rebuild
+	unsigned int collision_version;
+
+	// tiles that changed since the log was last reset, so that copyCollision() can patch a copy instead of copying the whole map
+	// the log is reset when the map is set, or when it grows past MAX_CHANGED_TILES
+	static const size_t MAX_CHANGED_TILES = 1024;
+	void logTileChange(int tile_x, int tile_y);
+	std::vector<Point> changed_tiles;
+	unsigned int changed_tiles_generation;
+
+	// how much of the other map's log has been applied to this copy
+	bool copied;
+	unsigned int copied_generation;
+	size_t copied_changes;
+
 public:
 	// const flags
 	static const bool IGNORE_BLOCKED = true;
@@ -95,6 +128,8 @@ public:
 	~MapCollision();
 
 	void setMap(const Map_Layer& _colmap, unsigned short w, unsigned short h);
+	void setTile(const int& tile_x, const int& tile_y, unsigned short value);
+	void copyCollision(const MapCollision& other);
 	bool move(float &x, float &y, float step_x, float step_y, int movement_type, int collide_type);
 
 	bool isOutsideMap(const float& tile_x, const float& tile_y) const;
@@ -102,6 +137,7 @@ public:
 	bool isWall(const float& x, const float& y) const;
 
 	bool isValidPosition(const float& x, const float& y, int movement_type, int collide_type) const;
+	bool isStaticPassable(const int& tile_x, const int& tile_y, int movement_type) const;
 
 	bool lineOfSight(const float& x1, const float& y1, const float& x2, const float& y2);
 	bool lineOfMovement(const float& x1, const float& y1, const float& x2, const float& y2, int movement_type);
@@ -109,6 +145,7 @@ public:
 	bool isFacing(const float& x1, const float& y1, char direction, const float& x2, const float& y2);
 
 	bool computePath(const FPoint& start, const FPoint& end, std::vector<FPoint> &path, int movement_type, unsigned int limit);
+	bool computeFlowPath(const FPoint& start, const FPoint& end, std::vector<FPoint> &path, int movement_type);
 
 	void block(const float& map_x, const float& map_y, bool is_ally);
 	void unblock(const float& map_x, const float& map_y);
@@ -121,6 +158,9 @@ public:
 
 	Map_Layer colmap;
 	Point map_size;
+
+	// nodes searched by computePath() calls since this was last reset
+	unsigned int path_nodes_expanded;
 };
 
 #endif
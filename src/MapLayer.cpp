@@ -0,0 +1,56 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "MapLayer.h"
+
+#include <algorithm>
+
+Map_Layer::Map_Layer()
+	: width(0)
+	, height(0)
+	, tiles() {
+}
+
+Map_Layer::Map_Layer(unsigned short _width, unsigned short _height, unsigned short val)
+	: width(0)
+	, height(0)
+	, tiles() {
+	init(_width, _height, val);
+}
+
+Map_Layer::~Map_Layer() {
+}
+
+void Map_Layer::init(unsigned short _width, unsigned short _height, unsigned short val) {
+	width = _width;
+	height = _height;
+	tiles.assign(static_cast<size_t>(width) * height, val);
+}
+
+void Map_Layer::fill(unsigned short val) {
+	std::fill(tiles.begin(), tiles.end(), val);
+}
+
+void Map_Layer::clear() {
+	width = 0;
+	height = 0;
+	std::vector<unsigned short>().swap(tiles);
+}
+
+bool Map_Layer::operator==(const Map_Layer& other) const {
+	return width == other.width && height == other.height && tiles == other.tiles;
+}
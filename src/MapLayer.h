@@ -0,0 +1,106 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class Map_Layer
+ *
+ * A grid of tile IDs stored in a single allocation, in row-major order.
+ * The flat index of a tile is x + y * width, the same as the tile indices used by the A* classes.
+ *
+ * operator() and operator[] don't check their arguments. layer[x][y] is kept so that code
+ * written for the old nested vector layout still works. get() and set() ignore tiles outside the grid.
+ */
+
+#ifndef MAP_LAYER_H
+#define MAP_LAYER_H
+
+#include <stddef.h>
+#include <vector>
+
+class Map_Layer {
+public:
+	// a single column of the grid, returned by operator[]
+	class Column {
+	public:
+		Column(unsigned short* _tiles, size_t _stride) : tiles(_tiles), stride(_stride) {}
+		unsigned short& operator[](size_t y) const { return tiles[y * stride]; }
+	private:
+		unsigned short* tiles;
+		size_t stride;
+	};
+
+	class ConstColumn {
+	public:
+		ConstColumn(const unsigned short* _tiles, size_t _stride) : tiles(_tiles), stride(_stride) {}
+		const unsigned short& operator[](size_t y) const { return tiles[y * stride]; }
+	private:
+		const unsigned short* tiles;
+		size_t stride;
+	};
+
+	Map_Layer();
+	Map_Layer(unsigned short _width, unsigned short _height, unsigned short val = 0);
+	~Map_Layer();
+
+	// discards the current contents
+	void init(unsigned short _width, unsigned short _height, unsigned short val = 0);
+	void fill(unsigned short val);
+	void clear();
+
+	unsigned short getWidth() const { return width; }
+	unsigned short getHeight() const { return height; }
+	bool empty() const { return tiles.empty(); }
+
+	bool isValid(int x, int y) const {
+		return x >= 0 && y >= 0 && x < width && y < height;
+	}
+	size_t getIndex(size_t x, size_t y) const {
+		return x + y * width;
+	}
+
+	unsigned short& operator()(size_t x, size_t y) { return tiles[getIndex(x, y)]; }
+	const unsigned short& operator()(size_t x, size_t y) const { return tiles[getIndex(x, y)]; }
+
+	Column operator[](size_t x) { return Column(&tiles[x], width); }
+	ConstColumn operator[](size_t x) const { return ConstColumn(&tiles[x], width); }
+
+	// returns 0 for tiles outside the grid
+	unsigned short get(int x, int y) const {
+		return isValid(x, y) ? tiles[getIndex(x, y)] : 0;
+	}
+	// returns false if the tile is outside the grid
+	bool set(int x, int y, unsigned short val) {
+		if (!isValid(x, y))
+			return false;
+		tiles[getIndex(x, y)] = val;
+		return true;
+	}
+
+	// the first tile of a row; the rest of the row follows it in memory
+	unsigned short* getRow(size_t y) { return &tiles[getIndex(0, y)]; }
+	const unsigned short* getRow(size_t y) const { return &tiles[getIndex(0, y)]; }
+
+	bool operator==(const Map_Layer& other) const;
+	bool operator!=(const Map_Layer& other) const { return !(*this == other); }
+
+private:
+	unsigned short width;
+	unsigned short height;
+	std::vector<unsigned short> tiles;
+};
+
+#endif // MAP_LAYER_H
@@ -100,6 +100,22 @@ void MapParallax::setMapCenter(int x, int y) {
 	map_center.y = static_cast<float>(y) + 0.5f;
 }
 
+/**
+ * Returns true if render() would draw anything for the given map layer
+ */
+bool MapParallax::hasLayer(const std::string& map_layer) {
+	if (!settings->parallax_layers)
+		return false;
+	else if (!loaded)
+		load(current_filename);
+
+	for (size_t i = 0; i < layers.size(); ++i) {
+		if (layers[i].map_layer == map_layer)
+			return true;
+	}
+	return false;
+}
+
 void MapParallax::render(const FPoint& cam, const std::string& map_layer) {
 	if (!settings->parallax_layers) {
 		if (loaded)
@@ -0,0 +1,510 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include <SDL_image.h>
+
+#include "EventManager.h"
+#include "MapPreloader.h"
+#include "ModManager.h"
+#include "RenderDevice.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "Utils.h"
+#include "UtilsParsing.h"
+
+#include <set>
+
+MapPreloader::MapPreloader()
+	: memory_used(0)
+	, applied(false)
+	, use_thread(false)
+	, thread(NULL)
+	, lock(NULL)
+	, wake(NULL)
+	, batch_done(NULL)
+	, batch_state(BATCH_NONE)
+	, quit(false)
+{
+}
+
+MapPreloader::~MapPreloader() {
+	stopWorker();
+	clear();
+}
+
+void MapPreloader::startWorker() {
+#ifndef __EMSCRIPTEN__
+	if (thread)
+		return;
+
+	lock = SDL_CreateMutex();
+	wake = SDL_CreateCond();
+	batch_done = SDL_CreateCond();
+	quit = false;
+
+	if (lock && wake && batch_done)
+		thread = SDL_CreateThread(runWorker, "map_preloader", this);
+
+	if (!thread) {
+		Utils::logError("MapPreloader: Unable to create worker thread, maps will not be preloaded: %s", SDL_GetError());
+		if (batch_done) SDL_DestroyCond(batch_done);
+		if (wake) SDL_DestroyCond(wake);
+		if (lock) SDL_DestroyMutex(lock);
+		batch_done = NULL;
+		wake = NULL;
+		lock = NULL;
+	}
+
+	use_thread = (thread != NULL);
+#endif
+}
+
+void MapPreloader::stopWorker() {
+	if (!thread)
+		return;
+
+	SDL_LockMutex(lock);
+	quit = true;
+	SDL_CondSignal(wake);
+	SDL_UnlockMutex(lock);
+
+	SDL_WaitThread(thread, NULL);
+	SDL_DestroyCond(batch_done);
+	SDL_DestroyCond(wake);
+	SDL_DestroyMutex(lock);
+
+	thread = NULL;
+	batch_done = NULL;
+	wake = NULL;
+	lock = NULL;
+	use_thread = false;
+
+	// the worker finished its last batch before exiting
+	if (batch_state != BATCH_NONE) {
+		batch_state = BATCH_NONE;
+		collectBatch();
+	}
+}
+
+int MapPreloader::runWorker(void* data) {
+	MapPreloader* preloader = static_cast<MapPreloader*>(data);
+
+	while (true) {
+		SDL_LockMutex(preloader->lock);
+		while (preloader->batch_state != BATCH_WORKING && !preloader->quit)
+			SDL_CondWait(preloader->wake, preloader->lock);
+		bool quit_now = preloader->quit && preloader->batch_state != BATCH_WORKING;
+		SDL_UnlockMutex(preloader->lock);
+
+		if (quit_now)
+			break;
+
+		preloader->processBatch();
+
+		SDL_LockMutex(preloader->lock);
+		preloader->batch_state = BATCH_DONE;
+		SDL_CondSignal(preloader->batch_done);
+		SDL_UnlockMutex(preloader->lock);
+	}
+
+	return 0;
+}
+
+/**
+ * Blocks until the worker has finished its current batch, then collects it
+ */
+void MapPreloader::waitForWorker() {
+	if (!use_thread)
+		return;
+
+	SDL_LockMutex(lock);
+	while (batch_state == BATCH_WORKING)
+		SDL_CondWait(batch_done, lock);
+	int state = batch_state;
+	batch_state = BATCH_NONE;
+	SDL_UnlockMutex(lock);
+
+	if (state == BATCH_DONE)
+		collectBatch();
+}
+
+void MapPreloader::preload(const std::string& current_map, const std::vector<Event>& events) {
+	if (!settings->map_preload) {
+		clear();
+		return;
+	}
+
+	startWorker();
+	if (!use_thread)
+		return;
+
+	std::set<std::string> maps;
+	std::set<std::string> map_lists;
+
+	for (size_t i = 0; i < events.size(); ++i) {
+		for (size_t j = 0; j < events[i].components.size(); ++j) {
+			const EventComponent& ec = events[i].components[j];
+			if (ec.type != EventComponent::INTERMAP || ec.s.empty())
+				continue;
+
+			// intermap_random events point to a list of maps
+			if (ec.z == 1)
+				map_lists.insert(ec.s);
+			else if (ec.s != current_map)
+				maps.insert(ec.s);
+		}
+	}
+
+	// the maps in a list that was already read are targets too
+	std::set<std::string> wanted(maps);
+	wanted.insert(map_lists.begin(), map_lists.end());
+	for (std::set<std::string>::iterator it = map_lists.begin(); it != map_lists.end(); ++it) {
+		std::map<std::string, PreloadFile>::iterator list_it = files.find(*it);
+		if (list_it == files.end() || !list_it->second.loaded)
+			continue;
+
+		for (size_t i = 0; i < list_it->second.refs.size(); ++i) {
+			if (list_it->second.refs[i].second != current_map)
+				wanted.insert(list_it->second.refs[i].second);
+		}
+	}
+
+	// drop the files that none of the wanted maps need
+	std::map<std::string, PreloadFile>::iterator it = files.begin();
+	while (it != files.end()) {
+		std::vector<std::string>& roots = it->second.roots;
+		for (size_t i = roots.size(); i > 0; --i) {
+			if (wanted.find(roots[i-1]) == wanted.end())
+				roots.erase(roots.begin() + (i-1));
+		}
+
+		std::map<std::string, PreloadFile>::iterator next = it;
+		++next;
+		if (roots.empty())
+			removeFile(it);
+		it = next;
+	}
+
+	for (std::set<std::string>::iterator map_it = map_lists.begin(); map_it != map_lists.end(); ++map_it) {
+		addFile(FILE_MAP_LIST, *map_it, std::vector<std::string>(1, *map_it));
+	}
+	for (std::set<std::string>::iterator map_it = wanted.begin(); map_it != wanted.end(); ++map_it) {
+		if (map_lists.find(*map_it) == map_lists.end())
+			addFile(FILE_MAP, *map_it, std::vector<std::string>(1, *map_it));
+	}
+}
+
+void MapPreloader::apply(const std::string& map_filename) {
+	releaseApplied();
+	waitForWorker();
+
+	size_t text_count = 0;
+	size_t image_count = 0;
+
+	std::map<std::string, PreloadFile>::iterator it = files.begin();
+	while (it != files.end()) {
+		PreloadFile& file = it->second;
+		std::map<std::string, PreloadFile>::iterator next = it;
+		++next;
+
+		if (file.loaded && std::find(file.roots.begin(), file.roots.end(), map_filename) != file.roots.end()) {
+			if (file.surface) {
+				render_device->addPreloadedImage(it->first, file.surface);
+				file.surface = NULL;
+				image_count++;
+			}
+			else if (file.type != FILE_MAP_LIST) {
+				// a deque doesn't move its elements when it grows, so the pointer stays valid
+				applied_text.push_back(std::string());
+				applied_text.back().swap(file.text);
+				mods->addMemoryFile(file.path, applied_text.back().data(), applied_text.back().length());
+				text_count++;
+			}
+
+			// files that other maps also need are only handed over once
+			// the images will usually still be in the render device's cache when they are needed again
+			removeFile(it);
+		}
+
+		it = next;
+	}
+
+	applied = true;
+
+	if (text_count > 0 || image_count > 0)
+		Utils::logInfo("MapPreloader: Using %u preloaded files and %u preloaded images for '%s'.", static_cast<unsigned>(text_count), static_cast<unsigned>(image_count), map_filename.c_str());
+}
+
+/**
+ * The preloaded data is needed until the map's NPCs and enemies have been created, so it is released on the next frame
+ */
+void MapPreloader::releaseApplied() {
+	if (!applied)
+		return;
+
+	mods->clearMemoryFiles();
+	render_device->clearPreloadedImages();
+	applied_text.clear();
+	applied = false;
+}
+
+void MapPreloader::logic() {
+	releaseApplied();
+
+	if (!use_thread)
+		return;
+
+	SDL_LockMutex(lock);
+	int state = batch_state;
+	SDL_UnlockMutex(lock);
+
+	if (state == BATCH_WORKING)
+		return;
+
+	if (state == BATCH_DONE) {
+		collectBatch();
+		SDL_LockMutex(lock);
+		batch_state = BATCH_NONE;
+		SDL_UnlockMutex(lock);
+	}
+
+	const size_t memory_limit = static_cast<size_t>(std::max(settings->map_preload_memory, 0)) * 1024 * 1024;
+
+	while (!pending.empty() && batch.size() < BATCH_SIZE && memory_used < memory_limit) {
+		std::map<std::string, PreloadFile>::iterator it = files.find(pending.front());
+		pending.pop_front();
+
+		// the file was dropped or was already loaded
+		if (it == files.end() || it->second.loaded || it->second.in_batch)
+			continue;
+
+		PreloadFile& file = it->second;
+		file.path = mods->locate(it->first);
+		if (!file.path.empty())
+			file.rw = mods->openRW(file.path);
+
+		if (!file.rw) {
+			removeFile(it);
+			continue;
+		}
+
+		file.in_batch = true;
+		batch.push_back(&file);
+		batch_names.push_back(it->first);
+	}
+
+	if (batch.empty())
+		return;
+
+	SDL_LockMutex(lock);
+	batch_state = BATCH_WORKING;
+	SDL_CondSignal(wake);
+	SDL_UnlockMutex(lock);
+}
+
+void MapPreloader::clear() {
+	releaseApplied();
+	waitForWorker();
+
+	while (!files.empty()) {
+		removeFile(files.begin());
+	}
+	pending.clear();
+	memory_used = 0;
+}
+
+/**
+ * Called from the worker thread
+ */
+void MapPreloader::processBatch() {
+	for (size_t i = 0; i < batch.size(); ++i) {
+		loadFile(*batch[i]);
+	}
+}
+
+/**
+ * Queues the files that the finished files refer to
+ * Files that were dropped while the worker was busy are removed now
+ */
+void MapPreloader::collectBatch() {
+	for (size_t i = 0; i < batch.size(); ++i) {
+		std::map<std::string, PreloadFile>::iterator it = files.find(batch_names[i]);
+		if (it == files.end())
+			continue;
+
+		PreloadFile& file = it->second;
+		file.in_batch = false;
+
+		if (!file.loaded || file.roots.empty()) {
+			removeFile(it);
+			continue;
+		}
+
+		memory_used += file.bytes;
+
+		for (size_t j = 0; j < file.refs.size(); ++j) {
+			const int ref_type = file.refs[j].first;
+			const std::string& ref_name = file.refs[j].second;
+
+			// each map in a map list is a target of its own
+			if (ref_type == FILE_MAP)
+				addFile(ref_type, ref_name, std::vector<std::string>(1, ref_name));
+			else
+				addFile(ref_type, ref_name, file.roots);
+		}
+
+		// map lists are only read to find their maps
+		if (file.type == FILE_MAP_LIST) {
+			memory_used -= std::min(memory_used, file.text.length());
+			file.bytes -= std::min(file.bytes, file.text.length());
+			std::string().swap(file.text);
+		}
+	}
+
+	batch.clear();
+	batch_names.clear();
+}
+
+void MapPreloader::addFile(int type, const std::string& filename, const std::vector<std::string>& roots) {
+	if (filename.empty())
+		return;
+
+	std::map<std::string, PreloadFile>::iterator it = files.find(filename);
+	if (it != files.end()) {
+		for (size_t i = 0; i < roots.size(); ++i) {
+			if (std::find(it->second.roots.begin(), it->second.roots.end(), roots[i]) == it->second.roots.end())
+				it->second.roots.push_back(roots[i]);
+		}
+		return;
+	}
+
+	PreloadFile& file = files[filename];
+	file.type = type;
+	file.roots = roots;
+	pending.push_back(filename);
+}
+
+/**
+ * Files in the worker's batch are only marked, and get removed by collectBatch()
+ */
+void MapPreloader::removeFile(std::map<std::string, PreloadFile>::iterator it) {
+	PreloadFile& file = it->second;
+
+	if (file.in_batch) {
+		file.roots.clear();
+		return;
+	}
+
+	if (file.rw)
+		SDL_RWclose(file.rw);
+	if (file.surface)
+		SDL_FreeSurface(file.surface);
+	if (file.loaded)
+		memory_used -= std::min(memory_used, file.bytes);
+
+	files.erase(it);
+}
+
+/**
+ * Called from the worker thread, so it must not use anything but the file itself
+ */
+void MapPreloader::loadFile(PreloadFile& file) {
+	if (file.type == FILE_IMAGE) {
+		file.surface = IMG_Load_RW(file.rw, 1);
+		file.rw = NULL;
+
+		if (file.surface) {
+			file.bytes = static_cast<size_t>(file.surface->pitch) * static_cast<size_t>(file.surface->h);
+			file.loaded = true;
+		}
+		return;
+	}
+
+	char buf[4096];
+	size_t count;
+	while ((count = SDL_RWread(file.rw, buf, 1, sizeof(buf))) > 0) {
+		file.text.append(buf, count);
+	}
+	SDL_RWclose(file.rw);
+	file.rw = NULL;
+
+	file.bytes = file.text.length();
+	file.loaded = true;
+
+	findReferences(file);
+}
+
+/**
+ * Scans the text of a file for the names of the files it uses
+ * This doesn't handle INCLUDE or APPEND, so a few files might not be found
+ */
+void MapPreloader::findReferences(PreloadFile& file) {
+	// the keys that lead from one kind of file to the next; an empty section matches any section
+	class Rule {
+	public:
+		int type;
+		const char* section;
+		const char* key;
+		int ref_type;
+	};
+
+	static const Rule rules[] = {
+		{FILE_MAP, "header", "tileset", FILE_TILESET},
+		{FILE_MAP, "header", "parallax_layers", FILE_PARALLAX},
+		{FILE_MAP, "npc", "filename", FILE_NPC},
+		{FILE_MAP_LIST, "", "map", FILE_MAP},
+		{FILE_TILESET, "", "img", FILE_IMAGE},
+		{FILE_PARALLAX, "layer", "image", FILE_IMAGE},
+		{FILE_NPC, "", "animations", FILE_ANIMATION},
+		{FILE_NPC, "", "gfx", FILE_ANIMATION},
+		{FILE_NPC, "", "portrait", FILE_IMAGE},
+		{FILE_ANIMATION, "", "image", FILE_IMAGE}
+	};
+	static const size_t rule_count = sizeof(rules) / sizeof(rules[0]);
+
+	std::stringstream stream(file.text);
+	std::string section;
+	std::string key;
+	std::string val;
+
+	while (stream.good()) {
+		std::string line = Parse::trim(Parse::getLine(stream));
+
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		if (line[0] == '[') {
+			section = Parse::getSectionTitle(line);
+			continue;
+		}
+
+		Parse::getKeyPair(line, key, val);
+
+		for (size_t i = 0; i < rule_count; ++i) {
+			const Rule& rule = rules[i];
+			if (rule.type != file.type || key != rule.key)
+				continue;
+			if (rule.section[0] != '\0' && section != rule.section)
+				continue;
+
+			std::string ref_name = Parse::popFirstString(val);
+			if (!ref_name.empty())
+				file.refs.push_back(std::pair<int, std::string>(rule.ref_type, ref_name));
+			break;
+		}
+	}
+}
@@ -0,0 +1,147 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MapPreloader
+ *
+ * Reads the maps that the current map can teleport to on a worker thread, so that entering one of them
+ * doesn't have to wait on the disk or on image decoding.
+ *
+ * The worker reads the text of each target map and scans it for the tileset, parallax layers and NPCs it uses.
+ * Those files are read in turn, down to the images they reference, which are decoded into surfaces.
+ * Parsing the text still happens on the main thread when the map is loaded, because it has side effects
+ * on the game state. The preloaded text is read from memory at that point, and the surfaces are turned into
+ * images by the render device.
+ *
+ * File names are resolved and opened on the main thread; the worker only reads and decodes.
+ * The total size of the preloaded files is limited by the map_preload_memory setting.
+ */
+
+#ifndef MAP_PRELOADER_H
+#define MAP_PRELOADER_H
+
+#include "CommonIncludes.h"
+
+#include <deque>
+
+class Event;
+
+class MapPreloader {
+public:
+	MapPreloader();
+	~MapPreloader();
+
+	// starts preloading the maps that the events of current_map lead to
+	// preloaded maps that aren't reachable from current_map are dropped
+	void preload(const std::string& current_map, const std::vector<Event>& events);
+
+	// hands any preloaded files for this map to the mod manager and render device
+	// called right before the map is loaded
+	void apply(const std::string& map_filename);
+
+	// called once per frame; collects finished files and starts the next batch
+	void logic();
+
+	// drops all preloaded files
+	void clear();
+
+private:
+	MapPreloader(const MapPreloader&); // not implemented
+
+	enum {
+		FILE_MAP = 0,
+		FILE_MAP_LIST = 1,
+		FILE_TILESET = 2,
+		FILE_PARALLAX = 3,
+		FILE_NPC = 4,
+		FILE_ANIMATION = 5,
+		FILE_IMAGE = 6
+	};
+
+	enum {
+		BATCH_NONE = 0,
+		BATCH_WORKING = 1,
+		BATCH_DONE = 2
+	};
+
+	// files are handed to the worker in small batches, so that apply() doesn't wait long for the worker
+	static const size_t BATCH_SIZE = 4;
+
+	class PreloadFile {
+	public:
+		int type;
+		std::string path;
+		std::vector<std::string> roots; // the target maps that need this file
+
+		// only touched by the worker while the file is in a batch
+		SDL_RWops* rw;
+		std::string text;
+		SDL_Surface* surface;
+		std::vector<std::pair<int, std::string> > refs;
+		size_t bytes;
+		bool loaded;
+
+		bool in_batch;
+
+		PreloadFile()
+			: type(FILE_MAP)
+			, rw(NULL)
+			, surface(NULL)
+			, bytes(0)
+			, loaded(false)
+			, in_batch(false) {
+		}
+	};
+
+	static int runWorker(void* data);
+	void startWorker();
+	void stopWorker();
+	void waitForWorker();
+	void processBatch();
+	void collectBatch();
+	void releaseApplied();
+
+	void addFile(int type, const std::string& filename, const std::vector<std::string>& roots);
+	void removeFile(std::map<std::string, PreloadFile>::iterator it);
+
+	static void loadFile(PreloadFile& file);
+	static void findReferences(PreloadFile& file);
+
+	// generic filename -> file
+	std::map<std::string, PreloadFile> files;
+	std::deque<std::string> pending;
+	size_t memory_used;
+
+	// text handed over by apply(); it must stay in memory until the map and its entities are loaded
+	std::deque<std::string> applied_text;
+	bool applied;
+
+	// only touched by the worker while batch_state is BATCH_WORKING
+	std::vector<PreloadFile*> batch;
+	std::vector<std::string> batch_names;
+
+	bool use_thread;
+
+	SDL_Thread* thread;
+	SDL_mutex* lock;
+	SDL_cond* wake;
+	SDL_cond* batch_done;
+	int batch_state;
+	bool quit;
+};
+
+#endif // MAP_PRELOADER_H
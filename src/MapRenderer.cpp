@@ -36,6 +36,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MenuDevConsole.h"
 #include "MenuManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
@@ -59,6 +60,8 @@ MapRenderer::MapRenderer()
 	, shakycam()
 	, entity_hidden_normal(NULL)
 	, entity_hidden_enemy(NULL)
+	, chunk_layer_count(0)
+	, chunk_frame(0)
 	, cam()
 	, map_change(false)
 	, teleportation(false)
@@ -195,24 +198,32 @@ int MapRenderer::load(const std::string& fname) {
 	// clear combat text
 	comb->clear();
 
+	// paths from the previous map are no longer useful
+	path_queue.clear();
+
+	clearChunks();
+
 	show_tooltip = false;
 
 	parallax_filename = "";
 
 	background_color = Color(0,0,0,0);
 
+	// use the files that were read while the previous map was active
+	preloader.apply(fname);
+
 	Map::load(fname);
 
 	loadMusic();
 
 	for (unsigned i = 0; i < layers.size(); ++i) {
 		if (layernames[i] == "collision") {
-			short width = static_cast<short>(layers[i].size());
+			unsigned short width = layers[i].getWidth();
 			if (width == 0) {
 				Utils::logError("MapRenderer: Map width is 0. Can't set collision layer.");
 				break;
 			}
-			short height = static_cast<short>(layers[i][0].size());
+			unsigned short height = layers[i].getHeight();
 			collider.setMap(layers[i], width, height);
 			removeLayer(i);
 		}
@@ -230,14 +241,14 @@ int MapRenderer::load(const std::string& fname) {
 
 	std::vector<unsigned> corrupted;
 	for (unsigned i = 0; i < layers.size(); ++i) {
-		for (unsigned x = 0; x < layers[i].size(); ++x) {
-			for (unsigned y = 0; y < layers[i][x].size(); ++y) {
-				const unsigned tile_id = layers[i][x][y];
+		for (unsigned y = 0; y < layers[i].getHeight(); ++y) {
+			for (unsigned x = 0; x < layers[i].getWidth(); ++x) {
+				const unsigned tile_id = layers[i](x, y);
 				if (tile_id > 0 && (tile_id >= tset.tiles.size() || tset.tiles[tile_id].tile == NULL)) {
 					if (std::find(corrupted.begin(), corrupted.end(), tile_id) == corrupted.end()) {
 						corrupted.push_back(tile_id);
 					}
-					layers[i][x][y] = 0;
+					layers[i](x, y) = 0;
 				}
 			}
 		}
@@ -256,6 +267,8 @@ int MapRenderer::load(const std::string& fname) {
 
 	render_device->setBackgroundColor(background_color);
 
+	preloader.preload(fname, events);
+
 	return 0;
 }
 
@@ -272,15 +285,44 @@ void MapRenderer::loadMusic() {
 }
 
 void MapRenderer::logic(bool paused) {
+	PROFILER_ZONE("MapRenderer::logic");
+
+	preloader.logic();
 
 	// handle tile set logic e.g. animations
 	tset.logic();
 
+	// redraw chunks that contain a tile that just changed animation frame
+	if (!tset.updated_tiles.empty()) {
+		std::map<std::pair<int, int>, MapChunk>::iterator it;
+		for (it = chunks.begin(); it != chunks.end(); ++it) {
+			MapChunk& chunk = it->second;
+			if (chunk.dirty || chunk.anim_tiles.empty())
+				continue;
+
+			std::vector<unsigned short>::const_iterator a = chunk.anim_tiles.begin();
+			std::vector<unsigned short>::const_iterator b = tset.updated_tiles.begin();
+			while (a != chunk.anim_tiles.end() && b != tset.updated_tiles.end()) {
+				if (*a < *b)
+					++a;
+				else if (*b < *a)
+					++b;
+				else {
+					chunk.dirty = true;
+					break;
+				}
+			}
+		}
+	}
+
 	// TODO there's a bit too much "logic" here for a class that's supposed to be dedicated to rendering
 	// some of these timers should be moved out at some point
 	if (paused)
 		return;
 
+	// hand this frame's path requests to the pathfinding worker
+	path_queue.logic(collider);
+
 	// handle camera shaking timer
 	shaky_cam_timer.tick();
 
@@ -349,6 +391,7 @@ void calculatePriosOrtho(std::vector<Renderable> &r) {
 }
 
 void MapRenderer::render(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
+	PROFILER_ZONE("MapRenderer::render");
 
 	map_parallax.render(shakycam, "");
 
@@ -381,6 +424,8 @@ void MapRenderer::drawRenderable(std::vector<Renderable>::iterator r_cursor) {
 }
 
 void MapRenderer::renderIsoLayer(const Map_Layer& layerdata) {
+	PROFILER_ZONE("MapRenderer::renderLayer");
+
 	int_fast16_t i; // first index of the map array
 	int_fast16_t j; // second index of the map array
 	Point dest;
@@ -423,7 +468,7 @@ void MapRenderer::renderIsoLayer(const Map_Layer& layerdata) {
 			++tiles_width;
 			p.x += eset->tileset.tile_w;
 
-			if (const uint_fast16_t current_tile = layerdata[i][j]) {
+			if (const uint_fast16_t current_tile = layerdata(i, j)) {
 				const Tile_Def &tile = tset.tiles[current_tile];
 				dest.x = p.x - tile.offset.x;
 				dest.y = p.y - tile.offset.y;
@@ -443,13 +488,233 @@ void MapRenderer::renderIsoLayer(const Map_Layer& layerdata) {
 	}
 }
 
+/**
+ * Background layers can be drawn from chunks as long as nothing else is drawn between them.
+ * Returns how many layers, starting from the bottom, can be cached.
+ */
+size_t MapRenderer::getChunkLayerCount() {
+	// parallax layers below the map would show through the chunks
+	if (map_parallax.hasLayer(""))
+		return 0;
+
+	size_t count = 0;
+	while (count < index_objectlayer && count < layers.size()) {
+		count++;
+
+		// the parallax layer is drawn on top of the chunks, but the following layers are drawn on top of it
+		if (map_parallax.hasLayer(layernames[count-1]))
+			break;
+	}
+	return count;
+}
+
+/**
+ * Draws the visible chunks, redrawing the ones that changed.
+ * Returns the number of layers that were drawn, which is 0 if chunks can't be used.
+ */
+size_t MapRenderer::renderChunkLayers() {
+	PROFILER_ZONE("MapRenderer::renderChunkLayers");
+
+	if (inpt->window_resized)
+		clearChunks();
+
+	const size_t layer_count = getChunkLayerCount();
+	if (layer_count != chunk_layer_count) {
+		clearChunks();
+		chunk_layer_count = layer_count;
+	}
+
+	if (chunk_layer_count == 0)
+		return 0;
+
+	chunk_frame++;
+
+	// the chunk grid is fixed to the position of tile (0,0)
+	const Point origin = Utils::mapToScreen(0, 0, shakycam.x, shakycam.y);
+	const int chunk_x0 = static_cast<int>(floorf(static_cast<float>(-origin.x) / CHUNK_SIZE));
+	const int chunk_y0 = static_cast<int>(floorf(static_cast<float>(-origin.y) / CHUNK_SIZE));
+	const int chunk_x1 = static_cast<int>(floorf(static_cast<float>(settings->view_w - 1 - origin.x) / CHUNK_SIZE));
+	const int chunk_y1 = static_cast<int>(floorf(static_cast<float>(settings->view_h - 1 - origin.y) / CHUNK_SIZE));
+
+	for (int cy = chunk_y0; cy <= chunk_y1; ++cy) {
+		for (int cx = chunk_x0; cx <= chunk_x1; ++cx) {
+			MapChunk& chunk = chunks[std::make_pair(cx, cy)];
+
+			if (!chunk.sprite) {
+				Image *graphics = render_device->createImage(CHUNK_SIZE, CHUNK_SIZE);
+				if (!graphics) {
+					// fall back to drawing the layers tile by tile
+					clearChunks();
+					return 0;
+				}
+				chunk.sprite = graphics->createSprite();
+				graphics->unref();
+			}
+
+			const Point chunk_pos(cx * CHUNK_SIZE, cy * CHUNK_SIZE);
+			if (chunk.dirty)
+				renderChunk(chunk, chunk_pos);
+
+			chunk.sprite->setDest(chunk_pos.x + origin.x, chunk_pos.y + origin.y);
+			render_device->render(chunk.sprite);
+			chunk.frame = chunk_frame;
+		}
+	}
+
+	// free the chunks that went off screen
+	if (chunks.size() > CHUNK_CACHE_MAX) {
+		std::map<std::pair<int, int>, MapChunk>::iterator it = chunks.begin();
+		while (it != chunks.end()) {
+			if (it->second.frame != chunk_frame) {
+				delete it->second.sprite;
+				chunks.erase(it++);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < chunk_layer_count; ++i) {
+		map_parallax.render(shakycam, layernames[i]);
+	}
+
+	return chunk_layer_count;
+}
+
+/**
+ * Draws the cached layers into the chunk, in the same order that renderIsoLayer() and renderOrthoLayer() would
+ */
+void MapRenderer::renderChunk(MapChunk& chunk, const Point& chunk_pos) {
+	Image *graphics = chunk.sprite->getGraphics();
+
+	// the chunks are opaque so that tiles are blended the same way as when drawn onto the screen
+	graphics->fillWithColor(Color(background_color.r, background_color.g, background_color.b, 255));
+
+	chunk.anim_tiles.clear();
+	chunk.dirty = false;
+
+	// find the range of tiles that might overlap this chunk
+	const Point base = Utils::mapToScreen(0, 0, 0, 0);
+	int min_x = w;
+	int min_y = h;
+	int max_x = -1;
+	int max_y = -1;
+	for (int corner = 0; corner < 4; ++corner) {
+		const int px = chunk_pos.x + (corner % 2) * CHUNK_SIZE + base.x;
+		const int py = chunk_pos.y + (corner / 2) * CHUNK_SIZE + base.y;
+		const FPoint map_pos = Utils::screenToMap(px, py, 0, 0);
+		min_x = std::min(min_x, static_cast<int>(floorf(map_pos.x)));
+		min_y = std::min(min_y, static_cast<int>(floorf(map_pos.y)));
+		max_x = std::max(max_x, static_cast<int>(floorf(map_pos.x)));
+		max_y = std::max(max_y, static_cast<int>(floorf(map_pos.y)));
+	}
+	const int margin = tset.max_size_x + tset.max_size_y + 2;
+	min_x = std::max(0, min_x - margin);
+	min_y = std::max(0, min_y - margin);
+	max_x = std::min(w - 1, max_x + margin);
+	max_y = std::min(h - 1, max_y + margin);
+
+	if (min_x > max_x || min_y > max_y)
+		return;
+
+	const bool is_iso = (eset->tileset.orientation != eset->tileset.TILESET_ORTHOGONAL);
+
+	for (size_t index = 0; index < chunk_layer_count; ++index) {
+		const Map_Layer& layerdata = layers[index];
+
+		// isometric layers are drawn in diagonal rows (i+j), orthogonal layers in rows of j
+		const int row_start = is_iso ? min_x + min_y : min_y;
+		const int row_end = is_iso ? max_x + max_y : max_y;
+
+		for (int row = row_start; row <= row_end; ++row) {
+			const int i_start = is_iso ? std::max(min_x, row - max_y) : min_x;
+			const int i_end = is_iso ? std::min(max_x, row - min_y) : max_x;
+
+			for (int i = i_start; i <= i_end; ++i) {
+				const int j = is_iso ? row - i : row;
+
+				const unsigned short current_tile = layerdata(i, j);
+				if (!current_tile)
+					continue;
+
+				const Tile_Def &tile = tset.tiles[current_tile];
+				Rect src = tile.tile->getClip();
+				const Point p = getTilePixelPos(static_cast<int_fast16_t>(i), static_cast<int_fast16_t>(j));
+
+				Rect dest;
+				dest.x = p.x - tile.offset.x - chunk_pos.x;
+				dest.y = p.y - tile.offset.y - chunk_pos.y;
+				dest.w = src.w;
+				dest.h = src.h;
+
+				if (dest.x >= CHUNK_SIZE || dest.y >= CHUNK_SIZE || dest.x + dest.w <= 0 || dest.y + dest.h <= 0)
+					continue;
+
+				render_device->renderToImage(tile.tile->getGraphics(), src, graphics, dest);
+
+				if (tset.isAnimated(current_tile))
+					chunk.anim_tiles.push_back(current_tile);
+			}
+		}
+	}
+
+	std::sort(chunk.anim_tiles.begin(), chunk.anim_tiles.end());
+	chunk.anim_tiles.erase(std::unique(chunk.anim_tiles.begin(), chunk.anim_tiles.end()), chunk.anim_tiles.end());
+}
+
+/**
+ * The center of a tile in pixels, relative to tile (0,0)
+ */
+Point MapRenderer::getTilePixelPos(int_fast16_t x, int_fast16_t y) {
+	const Point base = Utils::mapToScreen(0, 0, 0, 0);
+	Point p = centerTile(Utils::mapToScreen(float(x), float(y), 0, 0));
+	p.x -= base.x;
+	p.y -= base.y;
+	return p;
+}
+
+void MapRenderer::clearChunks() {
+	std::map<std::pair<int, int>, MapChunk>::iterator it;
+	for (it = chunks.begin(); it != chunks.end(); ++it) {
+		delete it->second.sprite;
+	}
+	chunks.clear();
+}
+
+void MapRenderer::invalidateTile(int x, int y) {
+	if (chunks.empty())
+		return;
+
+	// the old and new tiles can be as large as the largest tile in the tileset
+	const Point p = getTilePixelPos(static_cast<int_fast16_t>(x), static_cast<int_fast16_t>(y));
+	const int extent_x = (tset.max_size_x + 1) * eset->tileset.tile_w;
+	const int extent_y = (tset.max_size_y + 1) * eset->tileset.tile_h;
+
+	const int chunk_x0 = static_cast<int>(floorf(static_cast<float>(p.x - extent_x) / CHUNK_SIZE));
+	const int chunk_y0 = static_cast<int>(floorf(static_cast<float>(p.y - extent_y) / CHUNK_SIZE));
+	const int chunk_x1 = static_cast<int>(floorf(static_cast<float>(p.x + extent_x) / CHUNK_SIZE));
+	const int chunk_y1 = static_cast<int>(floorf(static_cast<float>(p.y + extent_y) / CHUNK_SIZE));
+
+	std::map<std::pair<int, int>, MapChunk>::iterator it;
+	for (it = chunks.begin(); it != chunks.end(); ++it) {
+		const std::pair<int, int>& pos = it->first;
+		if (pos.first >= chunk_x0 && pos.first <= chunk_x1 && pos.second >= chunk_y0 && pos.second <= chunk_y1)
+			it->second.dirty = true;
+	}
+}
+
 void MapRenderer::renderIsoBackObjects(std::vector<Renderable> &r) {
+	PROFILER_ZONE("MapRenderer::renderBackObjects");
+
 	std::vector<Renderable>::iterator it;
 	for (it = r.begin(); it != r.end(); ++it)
 		drawRenderable(it);
 }
 
 void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
+	PROFILER_ZONE("MapRenderer::renderFrontObjects");
+
 	Point dest;
 
 	const Point upperleft(Utils::screenToMap(0, 0, shakycam.x, shakycam.y));
@@ -473,7 +738,7 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 	std::queue<std::vector<Renderable>::iterator> render_behind_NE;
 	std::queue<std::vector<Renderable>::iterator> render_behind_none;
 
-	Map_Layer drawn_tiles(w, std::vector<unsigned short>(h, 0));
+	Map_Layer drawn_tiles(w, h);
 
 	for (uint_fast16_t y = max_tiles_height ; y; --y) {
 		int_fast16_t tiles_width = 0;
@@ -520,15 +785,15 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 				++r_pre_cursor;
 			}
 
-			if (draw_tile && !drawn_tiles[i][j]) {
-				if (const uint_fast16_t current_tile = current_layer[i][j]) {
+			if (draw_tile && !drawn_tiles(i, j)) {
+				if (const uint_fast16_t current_tile = current_layer(i, j)) {
 					const Tile_Def &tile = tset.tiles[current_tile];
 					dest.x = p.x - tile.offset.x;
 					dest.y = p.y - tile.offset.y;
 					tile.tile->setDestFromPoint(dest);
 					checkHiddenEntities(i, j, current_layer, r);
 					render_device->render(tile.tile);
-					drawn_tiles[i][j] = 1;
+					drawn_tiles(i, j) = 1;
 				}
 			}
 
@@ -602,15 +867,15 @@ do_last_NE_tile:
 			}
 
 			// draw the south-west tile
-			if (draw_SW_tile && i-2 >= 0 && j+2 < h && !drawn_tiles[i-2][j+2]) {
-				if (const uint_fast16_t current_tile = current_layer[i-2][j+2]) {
+			if (draw_SW_tile && i-2 >= 0 && j+2 < h && !drawn_tiles(i-2, j+2)) {
+				if (const uint_fast16_t current_tile = current_layer(i-2, j+2)) {
 					const Tile_Def &tile = tset.tiles[current_tile];
 					dest.x = tile_SW_center.x - tile.offset.x;
 					dest.y = tile_SW_center.y - tile.offset.y;
 					tile.tile->setDestFromPoint(dest);
 					checkHiddenEntities(i, j, current_layer, r);
 					render_device->render(tile.tile);
-					drawn_tiles[i-2][j+2] = 1;
+					drawn_tiles(i-2, j+2) = 1;
 				}
 			}
 
@@ -620,15 +885,15 @@ do_last_NE_tile:
 			}
 
 			// draw the north-east tile
-			if (draw_NE_tile && !draw_tile && !drawn_tiles[i][j]) {
-				if (const uint_fast16_t current_tile = current_layer[i][j]) {
+			if (draw_NE_tile && !draw_tile && !drawn_tiles(i, j)) {
+				if (const uint_fast16_t current_tile = current_layer(i, j)) {
 					const Tile_Def &tile = tset.tiles[current_tile];
 					dest.x = tile_NE_center.x - tile.offset.x;
 					dest.y = tile_NE_center.y - tile.offset.y;
 					tile.tile->setDestFromPoint(dest);
 					checkHiddenEntities(i, j, current_layer, r);
 					render_device->render(tile.tile);
-					drawn_tiles[i][j] = 1;
+					drawn_tiles(i, j) = 1;
 				}
 			}
 
@@ -665,7 +930,7 @@ do_last_NE_tile:
 }
 
 void MapRenderer::renderIso(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
-	size_t index = 0;
+	size_t index = renderChunkLayers();
 	while (index < index_objectlayer) {
 		renderIsoLayer(layers[index]);
 		map_parallax.render(shakycam, layernames[index]);
@@ -690,6 +955,7 @@ void MapRenderer::renderIso(std::vector<Renderable> &r, std::vector<Renderable>
 }
 
 void MapRenderer::renderOrthoLayer(const Map_Layer& layerdata) {
+	PROFILER_ZONE("MapRenderer::renderLayer");
 
 	Point dest;
 	const Point upperleft(Utils::screenToMap(0, 0, shakycam.x, shakycam.y));
@@ -707,7 +973,7 @@ void MapRenderer::renderOrthoLayer(const Map_Layer& layerdata) {
 		p = centerTile(p);
 		for (i = starti; i < max_tiles_width; i++) {
 
-			if (const unsigned short current_tile = layerdata[i][j]) {
+			if (const unsigned short current_tile = layerdata(i, j)) {
 				const Tile_Def &tile = tset.tiles[current_tile];
 				dest.x = p.x - tile.offset.x;
 				dest.y = p.y - tile.offset.y;
@@ -720,6 +986,8 @@ void MapRenderer::renderOrthoLayer(const Map_Layer& layerdata) {
 }
 
 void MapRenderer::renderOrthoBackObjects(std::vector<Renderable> &r) {
+	PROFILER_ZONE("MapRenderer::renderBackObjects");
+
 	// some renderables are drawn above the background and below the objects
 	std::vector<Renderable>::iterator it;
 	for (it = r.begin(); it != r.end(); ++it)
@@ -727,6 +995,7 @@ void MapRenderer::renderOrthoBackObjects(std::vector<Renderable> &r) {
 }
 
 void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
+	PROFILER_ZONE("MapRenderer::renderFrontObjects");
 
 	short int i;
 	short int j;
@@ -752,7 +1021,7 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 		p = centerTile(p);
 		for (i = starti; i<max_tiles_width; i++) {
 
-			if (const unsigned short current_tile = layers[index_objectlayer][i][j]) {
+			if (const unsigned short current_tile = layers[index_objectlayer](i, j)) {
 				const Tile_Def &tile = tset.tiles[current_tile];
 				dest.x = p.x - tile.offset.x;
 				dest.y = p.y - tile.offset.y;
@@ -775,7 +1044,7 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 }
 
 void MapRenderer::renderOrtho(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
-	unsigned index = 0;
+	size_t index = renderChunkLayers();
 	while (index < index_objectlayer) {
 		renderOrthoLayer(layers[index]);
 		map_parallax.render(shakycam, layernames[index]);
@@ -952,7 +1221,7 @@ void MapRenderer::checkHotspots() {
 						Point p = Utils::mapToScreen(float(x), float(y), shakycam.x, shakycam.y);
 						p = centerTile(p);
 
-						if (const short current_tile = layers[index][x][y]) {
+						if (const short current_tile = layers[index](x, y)) {
 							// first check if mouse pointer is in rectangle of that tile:
 							const Tile_Def &tile = tset.tiles[current_tile];
 							Rect dest;
@@ -1125,7 +1394,7 @@ Point MapRenderer::centerTile(const Point& p) {
 
 void MapRenderer::getTileBounds(const int_fast16_t x, const int_fast16_t y, const Map_Layer& layerdata, Rect& bounds, Point& center) {
 	if (x >= 0 && x < w && y >= 0 && y < h) {
-		if (const uint_fast16_t tile_index = layerdata[x][y]) {
+		if (const uint_fast16_t tile_index = layerdata(x, y)) {
 			const Tile_Def &tile = tset.tiles[tile_index];
 			if (!tile.tile)
 				return;
@@ -1352,5 +1621,7 @@ MapRenderer::~MapRenderer() {
 
 	delete entity_hidden_normal;
 	delete entity_hidden_enemy;
+
+	clearChunks();
 }
 
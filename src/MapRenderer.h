@@ -32,6 +32,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Map.h"
 #include "MapCollision.h"
 #include "MapParallax.h"
+#include "MapPreloader.h"
+#include "PathRequestQueue.h"
 #include "TileSet.h"
 #include "TooltipData.h"
 #include "Utils.h"
@@ -42,6 +44,25 @@ class WidgetTooltip;
 
 class MapRenderer : public Map {
 private:
+	// a pre-rendered region of the background layers
+	class MapChunk {
+	public:
+		Sprite* sprite;
+		std::vector<unsigned short> anim_tiles; // animated tiles drawn in this chunk, sorted
+		bool dirty;
+		unsigned frame; // the last frame this chunk was on screen
+
+		MapChunk()
+			: sprite(NULL)
+			, dirty(true)
+			, frame(0) {
+		}
+	};
+
+	// chunk width & height in pixels
+	static const int CHUNK_SIZE = 256;
+	// chunks that aren't on screen are freed once there are more than this many
+	static const size_t CHUNK_CACHE_MAX = 96;
 
 	WidgetTooltip *tip;
 	TooltipData tip_buf;
@@ -71,6 +92,12 @@ private:
 
 	void clearLayers();
 
+	size_t getChunkLayerCount();
+	size_t renderChunkLayers();
+	void renderChunk(MapChunk& chunk, const Point& chunk_pos);
+	Point getTilePixelPos(int_fast16_t x, int_fast16_t y);
+	void clearChunks();
+
 	void createTooltip(EventComponent *ec);
 
 	void getTileBounds(const int_fast16_t x, const int_fast16_t y, const Map_Layer& layerdata, Rect& bounds, Point& center);
@@ -92,6 +119,11 @@ private:
 
 	std::vector<std::vector<Renderable>::iterator> hidden_entities;
 
+	// background layers that are drawn from chunks, keyed by chunk position
+	std::map<std::pair<int, int>, MapChunk> chunks;
+	size_t chunk_layer_count;
+	unsigned chunk_frame;
+
 public:
 	// functions
 	MapRenderer();
@@ -118,6 +150,10 @@ public:
 	void activatePower(int power_index, unsigned statblock_index, FPoint &target);
 
 	bool isValidTile(const unsigned &tile);
+
+	// must be called after changing a tile in one of the layers, such as from a MAPMOD event
+	void invalidateTile(int x, int y);
+
 	Point centerTile(const Point& p);
 
 	// cam(x,y) is where on the map the camera is pointing
@@ -129,6 +165,12 @@ public:
 
 	MapCollision collider;
 
+	// enemy path searches that run in the background
+	PathRequestQueue path_queue;
+
+	// reads the maps that this map leads to in the background
+	MapPreloader preloader;
+
 	// event-created loot or items
 	std::vector<EventComponent> loot;
 	Point loot_count;
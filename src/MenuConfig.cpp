@@ -1408,6 +1408,7 @@ bool MenuConfig::setMods() {
 
 	if (mods->mod_list != temp_list) {
 		mods->saveMods();
+		mods->rebuildIndex();
 		return true;
 	}
 	else {
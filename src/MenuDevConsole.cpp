@@ -34,6 +34,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MessageEngine.h"
 #include "ModManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
+#include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
@@ -248,16 +250,16 @@ void MenuDevConsole::getTileInfo() {
 
 	std::stringstream ss;
 	for (size_t i = 0; i < mapr->layers.size(); ++i) {
-		if (mapr->layers[i][tile.x][tile.y] == 0)
+		if (mapr->layers[i](tile.x, tile.y) == 0)
 			continue;
 		ss.str("");
-		ss << "    " << mapr->layernames[i] << "=" << mapr->layers[i][tile.x][tile.y];
+		ss << "    " << mapr->layernames[i] << "=" << mapr->layers[i](tile.x, tile.y);
 		log_history->add(ss.str(), WidgetLog::MSG_NORMAL);
 	}
 
 	ss.str("");
-	ss << "    " << "collision=" << mapr->collider.colmap[tile.x][tile.y] << " (";
-	switch(mapr->collider.colmap[tile.x][tile.y]) {
+	ss << "    " << "collision=" << mapr->collider.colmap(tile.x, tile.y) << " (";
+	switch(mapr->collider.colmap(tile.x, tile.y)) {
 		case MapCollision::BLOCKS_NONE: ss << msg->get("none"); break;
 		case MapCollision::BLOCKS_ALL: ss << msg->get("wall"); break;
 		case MapCollision::BLOCKS_MOVEMENT: ss << msg->get("short wall / pit"); break;
@@ -366,6 +368,11 @@ void MenuDevConsole::execute() {
 		log_history->add("list_status - " + msg->get("Prints out the active campaign statuses that match a search term. No search term will list all active statuses"), WidgetLog::MSG_UNIQUE);
 		log_history->add("list_items - " + msg->get("Prints a list of items that match a search term. No search term will list all items"), WidgetLog::MSG_UNIQUE);
 		log_history->add("exec - " + msg->get("parses a series of event components and executes them as a single event"), WidgetLog::MSG_UNIQUE);
+		log_history->add("rebuild_mod_index - " + msg->get("rescans the mod folders for added or removed files"), WidgetLog::MSG_UNIQUE);
+		log_history->add("map_layer_benchmark - " + msg->get("compares the load times of the map layer formats on a synthetic map"), WidgetLog::MSG_UNIQUE);
+		log_history->add("image_cache - " + msg->get("prints the image cache counters and memory use"), WidgetLog::MSG_UNIQUE);
+		log_history->add("toggle_profiler - " + msg->get("turns on/off the frame time graph"), WidgetLog::MSG_UNIQUE);
+		log_history->add("profiler_trace - " + msg->get("writes the frames of the last few seconds as a Chrome trace. The default is 5 seconds"), WidgetLog::MSG_UNIQUE);
 		log_history->add("clear - " + msg->get("clears the command history"), WidgetLog::MSG_UNIQUE);
 		log_history->add("help - " + msg->get("displays this text"), WidgetLog::MSG_UNIQUE);
 	}
@@ -490,6 +497,110 @@ void MenuDevConsole::execute() {
 			log_history->setMaxMessages(WidgetLog::MAX_MESSAGES); // reset
 		}
 	}
+	else if (args[0] == "rebuild_mod_index") {
+		mods->rebuildIndex();
+
+		std::stringstream ss;
+		ss << msg->get("File system calls made by the mod index:") << ' ' << mods->index_fs_calls;
+		log_history->add(ss.str(), WidgetLog::MSG_UNIQUE);
+
+		ss.str("");
+		ss << msg->get("File system calls saved by the mod index:") << ' ' << mods->index_fs_calls_saved;
+		log_history->add(ss.str(), WidgetLog::MSG_UNIQUE);
+
+		log_history->add(msg->get("Rebuilt the mod index"), WidgetLog::MSG_UNIQUE);
+	}
+	else if (args[0] == "map_layer_benchmark") {
+		int size = (args.size() > 1) ? Parse::toInt(args[1]) : 512;
+		size = std::max(1, std::min(size, 4096));
+		const unsigned short w = static_cast<unsigned short>(size);
+		const unsigned short h = static_cast<unsigned short>(size);
+
+		// a repeating floor pattern with scattered objects, similar to a typical map layer
+		Map_Layer layer(w, h);
+		for (unsigned short y = 0; y < h; ++y) {
+			for (unsigned short x = 0; x < w; ++x) {
+				layer(x, y) = (rand() % 20 == 0) ? static_cast<unsigned short>(rand() % 300) : static_cast<unsigned short>(16 + (x/8 + y/8) % 4);
+			}
+		}
+
+		std::vector<std::string> dec_rows(h);
+		size_t dec_size = 0;
+		for (unsigned short y = 0; y < h; ++y) {
+			std::stringstream row;
+			for (unsigned short x = 0; x < w; ++x) {
+				row << layer(x, y) << ",";
+			}
+			dec_rows[y] = row.str();
+			dec_size += dec_rows[y].length() + 1;
+		}
+		std::string rle_data = Map::encodeLayerRLE(layer, w, h);
+
+		Map_Layer result(w, h);
+		bool valid = true;
+
+		uint64_t start = SDL_GetPerformanceCounter();
+		for (unsigned short y = 0; y < h; ++y) {
+			std::string row = dec_rows[y];
+			valid = Map::parseLayerRow(row, result, w, y) && valid;
+		}
+		uint64_t dec_ticks = SDL_GetPerformanceCounter() - start;
+		valid = valid && result == layer;
+
+		start = SDL_GetPerformanceCounter();
+		valid = Map::decodeLayerRLE(rle_data, result, w, h) && valid;
+		uint64_t rle_ticks = SDL_GetPerformanceCounter() - start;
+		valid = valid && result == layer;
+
+		const double ms_per_tick = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+		std::stringstream ss;
+		ss << w << "x" << h << " dec: " << dec_size << " bytes, " << static_cast<double>(dec_ticks) * ms_per_tick << " ms";
+		log_history->add(ss.str(), WidgetLog::MSG_UNIQUE);
+
+		ss.str("");
+		ss << w << "x" << h << " rle: " << rle_data.length() << " bytes, " << static_cast<double>(rle_ticks) * ms_per_tick << " ms";
+		log_history->add(ss.str(), WidgetLog::MSG_UNIQUE);
+
+		if (!valid) {
+			log_history->setNextColor(font->getColor(FontEngine::COLOR_MENU_PENALTY));
+			log_history->add(msg->get("ERROR: The decoded layers do not match"), WidgetLog::MSG_UNIQUE);
+		}
+	}
+	else if (args[0] == "image_cache") {
+		RenderDevice::ImageCacheStats stats = render_device->getImageCacheStats();
+		const float mb = 1024.f * 1024.f;
+
+		std::stringstream ss;
+		ss << "hits: " << stats.hits << ", misses: " << stats.misses << ", evictions: " << stats.evictions;
+		log_history->add(ss.str(), WidgetLog::MSG_UNIQUE);
+
+		ss.str("");
+		ss << "cached: " << stats.images << " images, " << static_cast<float>(stats.bytes) / mb << " MB";
+		log_history->add(ss.str(), WidgetLog::MSG_UNIQUE);
+
+		ss.str("");
+		ss << "retained: " << stats.retained_images << " images, " << static_cast<float>(stats.retained_bytes) / mb << " MB / " << settings->image_cache_memory << " MB";
+		log_history->add(ss.str(), WidgetLog::MSG_UNIQUE);
+	}
+	else if (args[0] == "toggle_profiler") {
+		Profiler::show_graph = !Profiler::show_graph;
+		log_history->add(msg->get("Toggled the frame time graph"), WidgetLog::MSG_UNIQUE);
+	}
+	else if (args[0] == "profiler_trace") {
+		float seconds = (args.size() > 1) ? Parse::toFloat(args[1]) : 5.f;
+		seconds = std::max(0.f, std::min(seconds, Profiler::getRecordedSeconds()));
+
+		std::string filename = settings->path_user + "profiler_trace.json";
+		if (Profiler::writeTrace(filename, seconds)) {
+			log_history->add(msg->get("Wrote the profiler trace to:") + ' ' + filename, WidgetLog::MSG_UNIQUE);
+			if (!Profiler::hasZones())
+				log_history->add(msg->get("Profiler zones are disabled in this build, so the trace only contains frame times."), WidgetLog::MSG_UNIQUE);
+		}
+		else {
+			log_history->setNextColor(font->getColor(FontEngine::COLOR_MENU_PENALTY));
+			log_history->add(msg->get("ERROR: Unable to write the profiler trace"), WidgetLog::MSG_UNIQUE);
+		}
+	}
 	else if (args[0] == "list_powers") {
 		std::stringstream ss;
 
@@ -52,6 +52,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "ModManager.h"
 #include "NPC.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
@@ -281,6 +282,8 @@ void MenuManager::handleKeyboardNavigation() {
 }
 
 void MenuManager::logic() {
+	PROFILER_ZONE("MenuManager::logic");
+
 	ItemStack stack;
 
 	subtitles->logic(snd->getLastPlayedSID());
@@ -1209,6 +1212,8 @@ void MenuManager::resetDrag() {
 }
 
 void MenuManager::render() {
+	PROFILER_ZONE("MenuManager::render");
+
 	if (!settings->show_hud) {
 		// if the hud is disabled, only show a few necessary menus
 
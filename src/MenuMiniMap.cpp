@@ -256,10 +256,10 @@ void MenuMiniMap::prerenderOrtho(MapCollision *collider, Sprite** target_surface
 
 	target_img->beginPixelBatch();
 
-	for (int i=0; i<std::min(target_w, map_size.x); i++) {
-		for (int j=0; j<std::min(target_h, map_size.y); j++) {
+	for (int j=0; j<std::min(target_h, map_size.y); j++) {
+		for (int i=0; i<std::min(target_w, map_size.x); i++) {
 			bool draw_tile = true;
-			int tile_type = collider->colmap[i][j];
+			int tile_type = collider->colmap(i, j);
 
 			if (tile_type == 1 || tile_type == 5) draw_color = color_wall;
 			else if (tile_type == 2 || tile_type == 6) draw_color = color_obst;
@@ -310,7 +310,7 @@ void MenuMiniMap::prerenderIso(MapCollision *collider, Sprite** target_surface,
 			// if this tile is the max map size
 			if (tile_cursor.x >= 0 && tile_cursor.y >= 0 && tile_cursor.x < map_size.x && tile_cursor.y < map_size.y) {
 
-				tile_type = collider->colmap[tile_cursor.x][tile_cursor.y];
+				tile_type = collider->colmap(tile_cursor.x, tile_cursor.y);
 				bool draw_tile = true;
 
 				// walls and low obstacles show as different colors
@@ -803,7 +803,7 @@ void MenuPowers::createTooltip(TooltipData* tip_data, MenuPowersCell* pcell, boo
 
 	for (size_t i=0; i<pwr.post_effects.size(); ++i) {
 		std::stringstream ss;
-		EffectDef* effect_ptr = powers->getEffectDef(pwr.post_effects[i].id);
+		EffectDef* effect_ptr = powers->getEffectDef(pwr.post_effects[i].id_index);
 
 		// base stats
 		if (effect_ptr == NULL) {
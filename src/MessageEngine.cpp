@@ -73,30 +73,26 @@ MessageEngine::MessageEngine() {
  * They differ only on which variables they replace in the string - strings replace %s, integers replace %d
  */
 std::string MessageEngine::get(const std::string& key) {
-	std::string message = messages[key];
-	if (message == "") message = key;
+	std::string message = lookup(key);
 	return unescape(message);
 }
 
 std::string MessageEngine::get(const std::string& key, int i) {
-	std::string message = messages[key];
-	if (message == "") message = key;
+	std::string message = lookup(key);
 	size_t index = message.find("%d");
 	if (index != std::string::npos) message = message.replace(index, 2, str(i));
 	return unescape(message);
 }
 
 std::string MessageEngine::get(const std::string& key, const std::string& s) {
-	std::string message = messages[key];
-	if (message == "") message = key;
+	std::string message = lookup(key);
 	size_t index = message.find("%s");
 	if (index != std::string::npos) message = message.replace(index, 2, s);
 	return unescape(message);
 }
 
 std::string MessageEngine::get(const std::string& key, int i, const std::string& s) {
-	std::string message = messages[key];
-	if (message == "") message = key;
+	std::string message = lookup(key);
 	size_t index = message.find("%d");
 	if (index != std::string::npos) message = message.replace(index, 2, str(i));
 	index = message.find("%s");
@@ -109,8 +105,7 @@ std::string MessageEngine::get(const std::string& key, const std::string& s, int
 }
 
 std::string MessageEngine::get(const std::string& key, int i, int j) {
-	std::string message = messages[key];
-	if (message == "") message = key;
+	std::string message = lookup(key);
 	size_t index = message.find("%d");
 	if (index != std::string::npos) message = message.replace(index, 2, str(i));
 	index = message.find("%d");
@@ -119,16 +114,14 @@ std::string MessageEngine::get(const std::string& key, int i, int j) {
 }
 
 std::string MessageEngine::get(const std::string& key, unsigned long i) {
-	std::string message = messages[key];
-	if (message == "") message = key;
+	std::string message = lookup(key);
 	size_t index = message.find("%d");
 	if (index != std::string::npos) message = message.replace(index, 2, str(i));
 	return unescape(message);
 }
 
 std::string MessageEngine::get(const std::string& key, unsigned long i, unsigned long j) {
-	std::string message = messages[key];
-	if (message == "") message = key;
+	std::string message = lookup(key);
 	size_t index = message.find("%d");
 	if (index != std::string::npos) message = message.replace(index, 2, str(i));
 	index = message.find("%d");
@@ -150,6 +143,17 @@ std::string MessageEngine::str(unsigned long i) {
 	return ss.str();
 }
 
+/**
+ * Returns the translation of key, or key itself if it has none
+ * messages[key] isn't used, because it would add the missing key to the map while get() is called from loading threads
+ */
+std::string MessageEngine::lookup(const std::string& key) {
+	std::map<std::string, std::string>::const_iterator it = messages.find(key);
+	if (it == messages.end() || it->second == "")
+		return key;
+	return it->second;
+}
+
 // unescape c formatted string
 std::string MessageEngine::unescape(const std::string& _val) {
 	std::string val = _val;
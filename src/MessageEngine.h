@@ -39,6 +39,7 @@ private:
 	std::string str(int i);
 	std::string str(unsigned long i);
 	std::string unescape(const std::string& _val);
+	std::string lookup(const std::string& key);
 public:
 	MessageEngine();
 	std::string get(const std::string& key);
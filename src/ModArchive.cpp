@@ -0,0 +1,425 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "ModArchive.h"
+#include "ModManager.h"
+#include "SharedResources.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+
+#include <string.h>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define MOD_ARCHIVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char ARCHIVE_MAGIC[] = "FLAREPAK";
+static const size_t ARCHIVE_MAGIC_LENGTH = 8;
+
+const std::string ModArchive::EXTENSION = ".pak";
+
+ModArchive::ModArchive()
+	: data(NULL)
+	, data_size(0)
+	, is_mapped(false)
+	, modified_time(0)
+{
+}
+
+ModArchive::~ModArchive() {
+	close();
+}
+
+bool ModArchive::open(const std::string& _path) {
+	close();
+	path = _path;
+
+#ifdef MOD_ARCHIVE_MMAP
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd != -1) {
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0) {
+			void* addr = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (addr != MAP_FAILED) {
+				data = static_cast<const char*>(addr);
+				data_size = static_cast<size_t>(st.st_size);
+				is_mapped = true;
+			}
+		}
+		// the mapping stays valid after closing the file
+		::close(fd);
+	}
+#endif
+
+	if (!data) {
+		std::ifstream infile(path.c_str(), std::ios::in | std::ios::binary);
+		if (!infile.is_open())
+			return false;
+
+		infile.seekg(0, std::ios::end);
+		std::streamoff length = infile.tellg();
+		infile.seekg(0, std::ios::beg);
+
+		if (length > 0) {
+			buffer.resize(static_cast<size_t>(length));
+			infile.read(&buffer[0], length);
+		}
+		infile.close();
+
+		if (buffer.empty() || infile.gcount() != length) {
+			Utils::logError("ModArchive: Could not read '%s'.", path.c_str());
+			close();
+			return false;
+		}
+
+		data = &buffer[0];
+		data_size = buffer.size();
+	}
+
+	modified_time = Filesystem::getFileModifiedTime(path);
+
+	if (!readTOC()) {
+		Utils::logError("ModArchive: '%s' is not a valid mod archive.", path.c_str());
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void ModArchive::close() {
+#ifdef MOD_ARCHIVE_MMAP
+	if (is_mapped)
+		munmap(const_cast<char*>(data), data_size);
+#endif
+
+	data = NULL;
+	data_size = 0;
+	is_mapped = false;
+	std::vector<char>().swap(buffer);
+	entries.clear();
+	modified_time = 0;
+}
+
+bool ModArchive::readTOC() {
+	if (data_size < HEADER_SIZE || memcmp(data, ARCHIVE_MAGIC, ARCHIVE_MAGIC_LENGTH) != 0)
+		return false;
+
+	if (readUint32(data + 8) != VERSION)
+		return false;
+
+	const Uint32 entry_count = readUint32(data + 12);
+	const Uint32 toc_offset = readUint32(data + 16);
+	const Uint32 toc_size = readUint32(data + 20);
+
+	if (toc_offset > data_size || toc_size > data_size - toc_offset)
+		return false;
+
+	// each entry takes at least ENTRY_HEADER_SIZE bytes, so a bad count can't cause a huge allocation
+	if (entry_count > toc_size / ENTRY_HEADER_SIZE)
+		return false;
+
+	entries.reserve(entry_count);
+
+	size_t pos = toc_offset;
+	const size_t toc_end = toc_offset + toc_size;
+
+	for (Uint32 i = 0; i < entry_count; ++i) {
+		if (toc_end - pos < ENTRY_HEADER_SIZE)
+			return false;
+
+		Entry entry;
+		entry.offset = readUint32(data + pos);
+		entry.size = readUint32(data + pos + 4);
+		const Uint32 flags = readUint32(data + pos + 8);
+		const Uint32 name_length = readUint32(data + pos + 12);
+		pos += ENTRY_HEADER_SIZE;
+
+		if (name_length == 0 || name_length > toc_end - pos)
+			return false;
+
+		entry.name.assign(data + pos, name_length);
+		pos += name_length;
+
+		if (entry.offset > data_size || entry.size > data_size - entry.offset)
+			return false;
+
+		// lookups use a binary search
+		if (!entries.empty() && !(entries.back() < entry))
+			return false;
+
+		if (flags != FLAG_NONE) {
+			Utils::logError("ModArchive: '%s' uses an unsupported format for '%s', skipping.", path.c_str(), entry.name.c_str());
+			continue;
+		}
+
+		entries.push_back(entry);
+	}
+
+	return true;
+}
+
+bool ModArchive::getEntry(const std::string& name, const char** entry_data, size_t* entry_size) const {
+	Entry key;
+	key.name = name;
+
+	std::vector<Entry>::const_iterator it = std::lower_bound(entries.begin(), entries.end(), key);
+	if (it == entries.end() || it->name != name)
+		return false;
+
+	*entry_data = data + it->offset;
+	*entry_size = it->size;
+	return true;
+}
+
+size_t ModArchive::getEntryCount() const {
+	return entries.size();
+}
+
+const std::string& ModArchive::getEntryName(size_t index) const {
+	return entries[index].name;
+}
+
+const std::string& ModArchive::getPath() const {
+	return path;
+}
+
+long ModArchive::getModifiedTime() const {
+	return modified_time;
+}
+
+Uint32 ModArchive::readUint32(const char* src) {
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(src);
+	return static_cast<Uint32>(p[0]) | (static_cast<Uint32>(p[1]) << 8) | (static_cast<Uint32>(p[2]) << 16) | (static_cast<Uint32>(p[3]) << 24);
+}
+
+void ModArchive::writeUint32(std::string& dest, Uint32 val) {
+	dest += static_cast<char>(val & 0xff);
+	dest += static_cast<char>((val >> 8) & 0xff);
+	dest += static_cast<char>((val >> 16) & 0xff);
+	dest += static_cast<char>((val >> 24) & 0xff);
+}
+
+void ModArchive::listFiles(const std::string& dir, const std::string& rel_dir, std::vector<std::string>& files, int depth) {
+	std::vector<std::string> dir_files;
+	std::vector<std::string> dirs;
+
+	if (Filesystem::getDirEntries(dir, dir_files, dirs) != 0)
+		return;
+
+	for (size_t i = 0; i < dir_files.size(); ++i) {
+		files.push_back(rel_dir + dir_files[i]);
+	}
+
+	if (depth >= ModManager::INDEX_MAX_DEPTH)
+		return;
+
+	for (size_t i = 0; i < dirs.size(); ++i) {
+		listFiles(dir + dirs[i] + "/", rel_dir + dirs[i] + "/", files, depth + 1);
+	}
+}
+
+bool ModArchive::pack(const std::string& mod_dir, const std::string& archive_path) {
+	const std::string dir = Filesystem::removeTrailingSlash(mod_dir) + "/";
+
+	if (!Filesystem::isDirectory(dir, false)) {
+		Utils::logError("ModArchive: '%s' is not a directory.", mod_dir.c_str());
+		return false;
+	}
+
+	std::vector<std::string> files;
+	listFiles(dir, "", files, 0);
+	std::sort(files.begin(), files.end());
+
+	std::vector<Uint32> sizes;
+	Uint32 toc_size = 0;
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		std::ifstream infile((dir + files[i]).c_str(), std::ios::in | std::ios::binary);
+		if (!infile.is_open()) {
+			Utils::logError("ModArchive: Could not read '%s'.", (dir + files[i]).c_str());
+			return false;
+		}
+		infile.seekg(0, std::ios::end);
+		std::streamoff length = infile.tellg();
+		infile.close();
+
+		if (length < 0 || length > static_cast<std::streamoff>(0xffffffffu)) {
+			Utils::logError("ModArchive: '%s' is too large to be packed.", (dir + files[i]).c_str());
+			return false;
+		}
+
+		sizes.push_back(static_cast<Uint32>(length));
+		toc_size += ENTRY_HEADER_SIZE + static_cast<Uint32>(files[i].length());
+	}
+
+	// lay out the data; every entry starts on a page boundary
+	std::vector<Uint32> offsets;
+	Uint32 end = HEADER_SIZE + toc_size;
+	for (size_t i = 0; i < files.size(); ++i) {
+		if (end > 0xffffffffu - (PAGE_SIZE - 1) || sizes[i] > 0xffffffffu - (PAGE_SIZE - 1) - end) {
+			Utils::logError("ModArchive: '%s' is too large to be packed into a single archive.", mod_dir.c_str());
+			return false;
+		}
+		end = (end + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+		offsets.push_back(end);
+		end += sizes[i];
+	}
+
+	std::string header;
+	header.append(ARCHIVE_MAGIC, ARCHIVE_MAGIC_LENGTH);
+	writeUint32(header, VERSION);
+	writeUint32(header, static_cast<Uint32>(files.size()));
+	writeUint32(header, HEADER_SIZE);
+	writeUint32(header, toc_size);
+	writeUint32(header, PAGE_SIZE);
+	writeUint32(header, 0);
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		writeUint32(header, offsets[i]);
+		writeUint32(header, sizes[i]);
+		writeUint32(header, FLAG_NONE);
+		writeUint32(header, static_cast<Uint32>(files[i].length()));
+		header += files[i];
+	}
+
+	std::ofstream outfile(archive_path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!outfile.is_open()) {
+		Utils::logError("ModArchive: Could not write '%s'.", archive_path.c_str());
+		return false;
+	}
+
+	outfile.write(header.data(), header.length());
+	size_t written = header.length();
+
+	std::vector<char> contents;
+	for (size_t i = 0; i < files.size(); ++i) {
+		if (written < offsets[i]) {
+			std::string padding(offsets[i] - written, '\0');
+			outfile.write(padding.data(), padding.length());
+			written = offsets[i];
+		}
+
+		if (sizes[i] == 0)
+			continue;
+
+		contents.resize(sizes[i]);
+		std::ifstream infile((dir + files[i]).c_str(), std::ios::in | std::ios::binary);
+		infile.read(&contents[0], sizes[i]);
+		if (infile.gcount() != static_cast<std::streamsize>(sizes[i])) {
+			Utils::logError("ModArchive: Could not read '%s'.", (dir + files[i]).c_str());
+			outfile.close();
+			Filesystem::removeFile(archive_path);
+			return false;
+		}
+		infile.close();
+
+		outfile.write(&contents[0], sizes[i]);
+		written += sizes[i];
+	}
+
+	bool ok = outfile.good();
+	outfile.close();
+
+	if (!ok) {
+		Utils::logError("ModArchive: Could not write '%s'. The disk may be full.", archive_path.c_str());
+		Filesystem::removeFile(archive_path);
+		return false;
+	}
+
+	Utils::logInfo("ModArchive: Packed %u files from '%s' into '%s'.", static_cast<unsigned>(files.size()), mod_dir.c_str(), archive_path.c_str());
+	return true;
+}
+
+void ModFileStream::MemoryBuffer::set(const char* buf_data, size_t buf_size) {
+	// the get area is never written to
+	char* begin = const_cast<char*>(buf_data);
+	setg(begin, begin, begin + buf_size);
+}
+
+ModFileStream::MemoryBuffer::pos_type ModFileStream::MemoryBuffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+	if (!(which & std::ios_base::in))
+		return pos_type(off_type(-1));
+
+	off_type base = 0;
+	if (dir == std::ios_base::cur)
+		base = gptr() - eback();
+	else if (dir == std::ios_base::end)
+		base = egptr() - eback();
+
+	const off_type target = base + off;
+	if (target < 0 || target > egptr() - eback())
+		return pos_type(off_type(-1));
+
+	setg(eback(), eback() + target, egptr());
+	return pos_type(target);
+}
+
+ModFileStream::MemoryBuffer::pos_type ModFileStream::MemoryBuffer::seekpos(pos_type pos, std::ios_base::openmode which) {
+	return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+ModFileStream::ModFileStream()
+	: std::istream(NULL)
+	, mem_open(false)
+{
+	rdbuf(&file_buf);
+}
+
+ModFileStream::~ModFileStream() {
+}
+
+void ModFileStream::open(const char* filename, std::ios_base::openmode mode) {
+	const char* buf_data = NULL;
+	size_t buf_size = 0;
+
+	if (mods && mods->getFileData(filename, &buf_data, &buf_size)) {
+		openMemory(buf_data, buf_size);
+		return;
+	}
+
+	mem_buf.set(NULL, 0);
+	mem_open = false;
+	rdbuf(&file_buf);
+	if (!file_buf.open(filename, mode | std::ios_base::in))
+		setstate(std::ios_base::failbit);
+}
+
+void ModFileStream::openMemory(const char* buf_data, size_t buf_size) {
+	mem_buf.set(buf_data, buf_size);
+	mem_open = true;
+	rdbuf(&mem_buf);
+}
+
+bool ModFileStream::is_open() const {
+	return mem_open || file_buf.is_open();
+}
+
+void ModFileStream::close() {
+	if (mem_open) {
+		mem_buf.set(NULL, 0);
+		mem_open = false;
+		rdbuf(&file_buf);
+	}
+	else if (!file_buf.close()) {
+		setstate(std::ios_base::failbit);
+	}
+}
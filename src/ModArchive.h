@@ -0,0 +1,134 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class ModArchive
+ *
+ * A mod packed into a single file. The archive is memory-mapped where possible, and
+ * the contents of its files are used in place without being copied.
+ *
+ * File format (all integers are unsigned 32-bit little endian):
+ *   header:  "FLAREPAK", version, entry count, TOC offset, TOC size, page size, reserved
+ *   TOC:     for each entry, sorted by name: offset, size, flags, name length, name
+ *   data:    the contents of each entry, starting on a page boundary
+ *
+ * Entry names are relative to the mod folder and use '/' as the separator.
+ * Only uncompressed entries (flags = 0) are supported.
+ */
+
+#ifndef MOD_ARCHIVE_H
+#define MOD_ARCHIVE_H
+
+#include "CommonIncludes.h"
+
+class ModArchive {
+private:
+	class Entry {
+	public:
+		std::string name;
+		Uint32 offset;
+		Uint32 size;
+
+		Entry()
+			: offset(0)
+			, size(0) {
+		}
+		bool operator<(const Entry& other) const {
+			return name < other.name;
+		}
+	};
+
+	static const Uint32 VERSION = 1;
+	static const Uint32 HEADER_SIZE = 32;
+	static const Uint32 ENTRY_HEADER_SIZE = 16;
+	static const Uint32 PAGE_SIZE = 4096;
+	static const Uint32 FLAG_NONE = 0;
+
+	bool readTOC();
+
+	static Uint32 readUint32(const char* src);
+	static void writeUint32(std::string& dest, Uint32 val);
+	static void listFiles(const std::string& dir, const std::string& rel_dir, std::vector<std::string>& files, int depth);
+
+	std::string path;
+	std::vector<Entry> entries;
+
+	const char* data;
+	size_t data_size;
+	bool is_mapped;
+
+	// holds the archive if it can't be memory-mapped
+	std::vector<char> buffer;
+
+	long modified_time;
+
+public:
+	static const std::string EXTENSION;
+
+	ModArchive();
+	~ModArchive();
+
+	// returns false if the file doesn't exist or isn't a valid archive
+	bool open(const std::string& _path);
+	void close();
+
+	// points data at the contents of an entry, which remain valid until the archive is closed
+	bool getEntry(const std::string& name, const char** entry_data, size_t* entry_size) const;
+
+	size_t getEntryCount() const;
+	const std::string& getEntryName(size_t index) const;
+
+	const std::string& getPath() const;
+	long getModifiedTime() const;
+
+	// writes all files in mod_dir to a new archive
+	static bool pack(const std::string& mod_dir, const std::string& archive_path);
+};
+
+/**
+ * class ModFileStream
+ *
+ * Can be used in place of std::ifstream to read files returned by ModManager::locate() and list(),
+ * including files in mod archives.
+ */
+class ModFileStream : public std::istream {
+private:
+	// reads from memory owned by someone else
+	class MemoryBuffer : public std::streambuf {
+	public:
+		void set(const char* buf_data, size_t buf_size);
+
+	protected:
+		virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+		virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+	};
+
+	std::filebuf file_buf;
+	MemoryBuffer mem_buf;
+	bool mem_open;
+
+public:
+	ModFileStream();
+	~ModFileStream();
+
+	void open(const char* filename, std::ios_base::openmode mode = std::ios_base::in);
+	void openMemory(const char* buf_data, size_t buf_size);
+	bool is_open() const;
+	void close();
+};
+
+#endif // MOD_ARCHIVE_H
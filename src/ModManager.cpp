@@ -17,6 +17,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
 #include "CommonIncludes.h"
+#include "ModArchive.h"
 #include "ModManager.h"
 #include "Platform.h"
 #include "Settings.h"
@@ -27,6 +28,27 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include <cassert>
 
+namespace {
+
+// holds a mutex until it goes out of scope
+class ScopedLock {
+public:
+	explicit ScopedLock(SDL_mutex* _mutex)
+		: mutex(_mutex) {
+		if (mutex)
+			SDL_LockMutex(mutex);
+	}
+	~ScopedLock() {
+		if (mutex)
+			SDL_UnlockMutex(mutex);
+	}
+
+private:
+	SDL_mutex* mutex;
+};
+
+} // namespace
+
 Mod::Mod()
 	: name("")
 	, description("")
@@ -116,6 +138,9 @@ const std::string ModManager::FALLBACK_GAME = "default";
 
 ModManager::ModManager(const std::vector<std::string> *_cmd_line_mods)
 	: cmd_line_mods(_cmd_line_mods)
+	, cache_lock(SDL_CreateMutex())
+	, index_fs_calls(0)
+	, index_fs_calls_saved(0)
 {
 	loc_cache.clear();
 	mod_dirs.clear();
@@ -126,6 +151,15 @@ ModManager::ModManager(const std::vector<std::string> *_cmd_line_mods)
 	Filesystem::getDirList(settings->path_data + "mods", mod_dirs_other);
 	Filesystem::getDirList(settings->path_user + "mods", mod_dirs_other);
 
+	// packed mods are used the same way as mod folders
+	std::vector<std::string> mod_archives;
+	Filesystem::getFileList(settings->path_data + "mods", ModArchive::EXTENSION, mod_archives);
+	Filesystem::getFileList(settings->path_user + "mods", ModArchive::EXTENSION, mod_archives);
+	for (size_t i = 0; i < mod_archives.size(); ++i) {
+		std::string archive_name = mod_archives[i].substr(mod_archives[i].rfind('/') + 1);
+		mod_dirs_other.push_back(archive_name.substr(0, archive_name.length() - ModArchive::EXTENSION.length()));
+	}
+
 	for (unsigned i=0; i<mod_dirs_other.size(); ++i) {
 		if (find(mod_dirs.begin(), mod_dirs.end(), mod_dirs_other[i]) == mod_dirs.end())
 			mod_dirs.push_back(mod_dirs_other[i]);
@@ -144,6 +178,8 @@ ModManager::ModManager(const std::vector<std::string> *_cmd_line_mods)
 			ss << ", ";
 	}
 	Utils::logInfo(ss.str().c_str());
+
+	rebuildIndex();
 }
 
 /**
@@ -240,56 +276,100 @@ void ModManager::loadModList() {
  * Use private loc_cache to prevent excessive disk I/O
  */
 std::string ModManager::locate(const std::string& filename) {
+	ScopedLock scoped_lock(cache_lock);
+
 	// if we have this location already cached, return it
-	if (loc_cache.find(filename) != loc_cache.end()) {
-		return loc_cache[filename];
+	std::map<std::string,std::string>::iterator it = loc_cache.find(filename);
+	if (it != loc_cache.end()) {
+		return it->second;
 	}
 
-	// search through mods for the first instance of this filename
-	std::string test_path;
+	// without the index, every mod folder would be checked again for files that aren't in a mod
+	// each check is a stat() and an open()
+	it = loc_miss_cache.find(filename);
+	if (it != loc_miss_cache.end()) {
+		index_fs_calls_saved += 2 * (index_sources.size() + 1);
+		return it->second;
+	}
 
-	for (size_t i = mod_list.size(); i > 0; i--) {
-		for (size_t j = 0; j < mod_paths.size(); j++) {
-			test_path = mod_paths[j] + "mods/" + mod_list[i-1].name + "/" + filename;
-			if (Filesystem::fileExists(test_path)) {
-				loc_cache[filename] = test_path;
-				return test_path;
-			}
+	// the index holds the first instance of this filename when searching through mods in reverse order
+	std::map<std::string, size_t>::iterator file = file_index.find(getIndexKey(filename));
+	if (file != file_index.end()) {
+		std::string path = index_sources[file->second] + filename;
+		loc_cache[filename] = path;
+		index_fs_calls_saved += 2 * (index_sources.size() - file->second);
+		return path;
+	}
+
+#if defined(_WIN32) || defined(__APPLE__)
+	// the index is case-sensitive, but the file system here usually isn't
+	// so a name that differs in case from the file on disk has to be checked in each mod folder
+	for (size_t i = index_sources.size(); i > 0; --i) {
+		std::string path = index_sources[i-1] + filename;
+		index_fs_calls += 2;
+		if (Filesystem::fileExists(path)) {
+			loc_cache[filename] = path;
+			return path;
 		}
 	}
+#endif
 
 	// all else failing, simply return the filename if it exists
-	test_path = settings->path_data + filename;
+	std::string test_path = settings->path_data + filename;
+	index_fs_calls += 2;
 	if (!Filesystem::fileExists(test_path))
 		test_path = "";
 
-	return test_path;
-}
+	loc_miss_cache[filename] = test_path;
+#if !defined(_WIN32) && !defined(__APPLE__)
+	index_fs_calls_saved += 2 * index_sources.size();
+#endif
 
-void amendPathToVector(const std::string &path, std::vector<std::string> &vec) {
-	if (Filesystem::pathExists(path)) {
-		if (Filesystem::isDirectory(path)) {
-			Filesystem::getFileList(path, "txt", vec);
-		}
-		else {
-			vec.push_back(path);
-		}
-	}
+	return test_path;
 }
 
 std::vector<std::string> ModManager::list(const std::string &path, bool full_paths) {
 	std::vector<std::string> ret;
-	std::string test_path;
+	std::vector<IndexFile> found;
+
+	const std::string key = getIndexKey(path);
+
+	// path is a directory; only text files are listed
+	std::map<std::string, std::vector<IndexFile> >::iterator dir = dir_index.find(key);
+	if (dir != dir_index.end()) {
+		const std::vector<IndexFile>& files = dir->second;
+		for (size_t i = 0; i < files.size(); ++i) {
+			const std::string& name = files[i].name;
+			if (name.length() > 3 && name.compare(name.length() - 3, 3, "txt") == 0)
+				found.push_back(IndexFile(files[i].source, index_sources[files[i].source] + path + "/" + name));
+		}
+	}
 
-	for (size_t i = 0; i < mod_list.size(); ++i) {
-		for (size_t j = mod_paths.size(); j > 0; j--) {
-			test_path = mod_paths[j-1] + "mods/" + mod_list[i].name + "/" + path;
-			amendPathToVector(test_path, ret);
+	// path is a file
+	size_t slash = key.rfind('/');
+	const std::string parent_key = (slash == std::string::npos ? "" : key.substr(0, slash));
+	const std::string base_name = (slash == std::string::npos ? key : key.substr(slash + 1));
+	dir = dir_index.find(parent_key);
+	if (dir != dir_index.end() && !base_name.empty()) {
+		const std::vector<IndexFile>& files = dir->second;
+		for (size_t i = 0; i < files.size(); ++i) {
+			if (files[i].name == base_name)
+				found.push_back(IndexFile(files[i].source, index_sources[files[i].source] + path));
 		}
 	}
 
+	// each source would otherwise need a stat() for existence, and another stat() and a directory read if it exists
+	SDL_LockMutex(cache_lock);
+	index_fs_calls_saved += index_sources.size() + 2 * found.size();
+	SDL_UnlockMutex(cache_lock);
+
 	// we don't need to check for duplicates if there are no paths
-	if (ret.empty()) return ret;
+	if (found.empty()) return ret;
+
+	std::stable_sort(found.begin(), found.end());
+	for (size_t i = 0; i < found.size(); ++i) {
+		ret.push_back(found[i].name);
+	}
 
 	if (!full_paths) {
 		// reduce the each file path down to be relative to mods/
@@ -311,6 +391,191 @@ std::vector<std::string> ModManager::list(const std::string &path, bool full_pat
 	return ret;
 }
 
+void ModManager::rebuildIndex() {
+	loc_cache.clear();
+	loc_miss_cache.clear();
+	index_sources.clear();
+	file_index.clear();
+	dir_index.clear();
+
+	const unsigned long prev_fs_calls = index_fs_calls;
+
+	for (size_t i = 0; i < mod_list.size(); ++i) {
+		for (size_t j = mod_paths.size(); j > 0; j--) {
+			const std::string mod_path = mod_paths[j-1] + "mods/" + mod_list[i].name;
+
+			// if a mod has both an archive and a folder in the same place, files in the folder take priority
+			ModArchive* archive = openArchive(mod_path + ModArchive::EXTENSION);
+			if (archive) {
+				index_sources.push_back(mod_path + ModArchive::EXTENSION + "/");
+				scanArchive(index_sources.size() - 1, archive);
+			}
+
+			index_sources.push_back(mod_path + "/");
+			scanDir(index_sources.size() - 1, index_sources.back(), "", 0);
+		}
+	}
+
+	Utils::logInfo("ModManager: Indexed %u files in %u directories (%lu file system calls).",
+		static_cast<unsigned>(file_index.size()), static_cast<unsigned>(dir_index.size()), index_fs_calls - prev_fs_calls);
+}
+
+void ModManager::scanDir(size_t source, const std::string& dir, const std::string& rel_dir, int depth) {
+	std::vector<std::string> files;
+	std::vector<std::string> dirs;
+
+	index_fs_calls++;
+	if (Filesystem::getDirEntries(dir, files, dirs) != 0)
+		return;
+
+	std::vector<IndexFile>& dir_files = dir_index[rel_dir];
+	for (size_t i = 0; i < files.size(); ++i) {
+		dir_files.push_back(IndexFile(source, files[i]));
+
+		// later sources have a higher priority
+		file_index[rel_dir.empty() ? files[i] : rel_dir + "/" + files[i]] = source;
+	}
+
+	if (depth >= INDEX_MAX_DEPTH)
+		return;
+
+	for (size_t i = 0; i < dirs.size(); ++i) {
+		scanDir(source, dir + dirs[i] + "/", (rel_dir.empty() ? dirs[i] : rel_dir + "/" + dirs[i]), depth + 1);
+	}
+}
+
+void ModManager::scanArchive(size_t source, ModArchive* archive) {
+	for (size_t i = 0; i < archive->getEntryCount(); ++i) {
+		const std::string& name = archive->getEntryName(i);
+
+		size_t slash = name.rfind('/');
+		if (slash == std::string::npos)
+			dir_index[""].push_back(IndexFile(source, name));
+		else
+			dir_index[name.substr(0, slash)].push_back(IndexFile(source, name.substr(slash + 1)));
+
+		file_index[name] = source;
+	}
+}
+
+/**
+ * Archives stay open until the ModManager is destroyed, since the data of their files is used in place
+ */
+ModArchive* ModManager::openArchive(const std::string& archive_path) {
+	std::map<std::string, ModArchive*>::iterator it = archives.find(archive_path);
+	if (it != archives.end()) {
+		index_fs_calls++;
+		if (Filesystem::getFileModifiedTime(archive_path) == it->second->getModifiedTime())
+			return it->second;
+
+		old_archives.push_back(it->second);
+		archives.erase(it);
+	}
+
+	index_fs_calls++;
+	ModArchive* archive = new ModArchive();
+	if (!archive->open(archive_path)) {
+		delete archive;
+		return NULL;
+	}
+
+	archives[archive_path] = archive;
+	return archive;
+}
+
+/**
+ * Finds the archive that a path returned by locate() or list() points into
+ */
+ModArchive* ModManager::findArchive(const std::string& path, std::string& entry_name) {
+	if (archives.empty())
+		return NULL;
+
+	const std::string separator = ModArchive::EXTENSION + "/";
+	size_t pos = path.find(separator);
+	while (pos != std::string::npos) {
+		std::map<std::string, ModArchive*>::iterator it = archives.find(path.substr(0, pos + ModArchive::EXTENSION.length()));
+		if (it != archives.end()) {
+			entry_name = getIndexKey(path.substr(pos + separator.length()));
+			return it->second;
+		}
+		pos = path.find(separator, pos + 1);
+	}
+
+	return NULL;
+}
+
+bool ModManager::getFileData(const std::string& path, const char** data, size_t* size) {
+	if (!memory_files.empty()) {
+		std::map<std::string, std::pair<const char*, size_t> >::iterator it = memory_files.find(path);
+		if (it != memory_files.end()) {
+			*data = it->second.first;
+			*size = it->second.second;
+			return true;
+		}
+	}
+
+	std::string entry_name;
+	ModArchive* archive = findArchive(path, entry_name);
+	return archive && archive->getEntry(entry_name, data, size);
+}
+
+SDL_RWops* ModManager::openRW(const std::string& path) {
+	const char* data = NULL;
+	size_t size = 0;
+	if (getFileData(path, &data, &size))
+		return SDL_RWFromConstMem(data, static_cast<int>(size));
+
+	return SDL_RWFromFile(path.c_str(), "rb");
+}
+
+void ModManager::addMemoryFile(const std::string& path, const char* data, size_t size) {
+	memory_files[path] = std::pair<const char*, size_t>(data, size);
+}
+
+void ModManager::clearMemoryFiles() {
+	memory_files.clear();
+}
+
+long ModManager::getFileModifiedTime(const std::string& path) {
+	std::string entry_name;
+	ModArchive* archive = findArchive(path, entry_name);
+	if (archive)
+		return archive->getModifiedTime();
+
+	return Filesystem::getFileModifiedTime(path);
+}
+
+long ModManager::getFileSize(const std::string& path) {
+	const char* data = NULL;
+	size_t size = 0;
+	if (getFileData(path, &data, &size))
+		return static_cast<long>(size);
+
+	return Filesystem::getFileSize(path);
+}
+
+/**
+ * Converts a path passed to locate() or list() to the form used by the index
+ */
+std::string ModManager::getIndexKey(const std::string& path) {
+	std::string key;
+	key.reserve(path.length());
+
+	for (size_t i = 0; i < path.length(); ++i) {
+		// skip repeated slashes and "./"
+		if (path[i] == '/' && (key.empty() || key[key.length()-1] == '/'))
+			continue;
+		if (path[i] == '.' && (key.empty() || key[key.length()-1] == '/') && (i+1 == path.length() || path[i+1] == '/'))
+			continue;
+		key += path[i];
+	}
+
+	while (!key.empty() && key[key.length()-1] == '/')
+		key.erase(key.length()-1);
+
+	return key;
+}
+
 void ModManager::setPaths() {
 	// set some flags if directories are identical
 	bool uniq_path_data = settings->path_user != settings->path_data;
@@ -327,7 +592,7 @@ void ModManager::setPaths() {
 
 Mod ModManager::loadMod(const std::string& name) {
 	Mod mod;
-	std::ifstream infile;
+	ModFileStream infile;
 	std::string starts_with, line, key, val;
 
 	mod.name = name;
@@ -337,6 +602,17 @@ Mod ModManager::loadMod(const std::string& name) {
 		std::string path = mod_paths[i] + "mods/" + name + "/settings.txt";
 		infile.open(path.c_str(), std::ios::in);
 
+		if (!infile.is_open()) {
+			infile.clear();
+
+			// the mod might be packed
+			ModArchive* archive = openArchive(mod_paths[i] + "mods/" + name + ModArchive::EXTENSION);
+			const char* data = NULL;
+			size_t size = 0;
+			if (archive && archive->getEntry("settings.txt", &data, &size))
+				infile.openMemory(data, size);
+		}
+
 		while (infile.good()) {
 			line = Parse::getLine(infile);
 			key = "";
@@ -558,4 +834,13 @@ void ModManager::resetModConfig() {
 }
 
 ModManager::~ModManager() {
+	for (std::map<std::string, ModArchive*>::iterator it = archives.begin(); it != archives.end(); ++it) {
+		delete it->second;
+	}
+	for (size_t i = 0; i < old_archives.size(); ++i) {
+		delete old_archives[i];
+	}
+
+	if (cache_lock)
+		SDL_DestroyMutex(cache_lock);
 }
@@ -21,6 +21,14 @@ class ModManager
 
 ModManager maintains a list of active mods and provides functions for checking
 mods in priority order when loading data files.
+
+The files of the active mods are indexed once, so that locate() and list() don't
+need to query the file system. The index must be rebuilt if the mod list or the
+files in the mod folders change.
+
+A mod can also be packed into a single archive file (see ModArchive). Paths to
+files in an archive look like "mods/[NAME].pak/[FILE]", and must be read with
+openRW(), getFileData() or ModFileStream.
 */
 
 #ifndef MOD_MANAGER_H
@@ -28,6 +36,7 @@ mods in priority order when loading data files.
 
 #include "CommonIncludes.h"
 
+class ModArchive;
 class Version;
 
 class Mod {
@@ -55,17 +64,62 @@ public:
 
 class ModManager {
 private:
+	// a file in one of the indexed mod folders
+	class IndexFile {
+	public:
+		size_t source; // index into index_sources
+		std::string name;
+
+		IndexFile(size_t _source, const std::string& _name)
+			: source(_source)
+			, name(_name) {
+		}
+		bool operator<(const IndexFile& other) const {
+			return source < other.source;
+		}
+	};
+
 	void loadModList();
 	void setPaths();
 
+	void scanDir(size_t source, const std::string& dir, const std::string& rel_dir, int depth);
+	void scanArchive(size_t source, ModArchive* archive);
+	std::string getIndexKey(const std::string& path);
+
+	ModArchive* openArchive(const std::string& archive_path);
+	ModArchive* findArchive(const std::string& path, std::string& entry_name);
+
 	std::map<std::string,std::string> loc_cache;
+	std::map<std::string,std::string> loc_miss_cache;
 	std::vector<std::string> mod_paths;
 
+	// mod folders in the order that list() returns files from; locate() uses the reverse order
+	std::vector<std::string> index_sources;
+	// relative filename -> the highest priority source that has it
+	std::map<std::string, size_t> file_index;
+	// relative directory -> the files in it from each source, in list() order
+	std::map<std::string, std::vector<IndexFile> > dir_index;
+
+	// archive path -> open archive
+	std::map<std::string, ModArchive*> archives;
+	// archives that changed on disk; they are kept open because their data may still be in use
+	std::vector<ModArchive*> old_archives;
+
+	// path -> contents added with addMemoryFile()
+	std::map<std::string, std::pair<const char*, size_t> > memory_files;
+
 	const std::vector<std::string> *cmd_line_mods;
 
+	// locate() and list() are also called by loading threads; this guards the caches and counters that they update
+	// the index itself is only read, so it must not be rebuilt while other threads are loading
+	SDL_mutex* cache_lock;
+
 public:
 	static const bool LIST_FULL_PATHS = true;
 
+	// folder depth for the mod index and the mod packer; deep enough for any mod, but protects against symlink loops
+	static const int INDEX_MAX_DEPTH = 32;
+
 	static const std::string FALLBACK_MOD;
 	static const std::string FALLBACK_GAME;
 
@@ -90,6 +144,30 @@ public:
 	// that can be passed to locate() later
 	std::vector<std::string> list(const std::string& path, bool full_paths);
 
+	// points data at the contents of a file that is already in memory, either in a mod archive or added with addMemoryFile()
+	// returns false if path has to be read from disk
+	bool getFileData(const std::string& path, const char** data, size_t* size);
+
+	// makes a path returned by locate() read from memory that is owned by the caller, such as a preloaded file
+	// the memory must stay valid until clearMemoryFiles() is called
+	void addMemoryFile(const std::string& path, const char* data, size_t size);
+	void clearMemoryFiles();
+
+	// opens a path returned by locate() or list() for reading; returns NULL on failure
+	SDL_RWops* openRW(const std::string& path);
+
+	// for files in a mod archive, this is the modification time of the archive
+	long getFileModifiedTime(const std::string& path);
+	long getFileSize(const std::string& path);
+
+	// scans the folders and archives of the active mods
+	// called on construction; must be called again after changing mod_list
+	void rebuildIndex();
+
+	// file system calls made by the index, and an estimate of the calls that would have been made without it
+	unsigned long index_fs_calls;
+	unsigned long index_fs_calls_saved;
+
 	std::vector<std::string> mod_dirs;
 	std::vector<Mod> mod_list;
 };
@@ -34,6 +34,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MapRenderer.h"
 #include "NPC.h"
 #include "NPCManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
@@ -170,6 +171,8 @@ void NPCManager::createMapEvent(const NPC& npc, size_t _npcs) {
 }
 
 void NPCManager::logic() {
+	PROFILER_ZONE("NPCManager::logic");
+
 	for (unsigned i=0; i<npcs.size(); i++) {
 		npcs[i]->logic();
 	}
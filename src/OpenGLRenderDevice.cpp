@@ -455,7 +455,7 @@ void* openShaderFile(const std::string& filename, GLint *length)
 {
 	std::string full_filename = mods->locate(filename);
 
-	FILE *f = fopen(full_filename.c_str(), "r");
+	SDL_RWops *f = mods->openRW(full_filename);
 	void *buffer;
 
 	if (!f) {
@@ -463,13 +463,11 @@ void* openShaderFile(const std::string& filename, GLint *length)
 		return NULL;
 	}
 
-	fseek(f, 0, SEEK_END);
-	*length = static_cast<GLint>(ftell(f));
-	fseek(f, 0, SEEK_SET);
+	*length = static_cast<GLint>(SDL_RWsize(f));
 
 	buffer = malloc(*length+1);
-	*length = static_cast<GLint>(fread(buffer, 1, *length, f));
-	fclose(f);
+	*length = static_cast<GLint>(SDL_RWread(f, buffer, 1, *length));
+	SDL_RWclose(f);
 	((char*)buffer)[*length] = '\0';
 
 	return buffer;
@@ -760,6 +758,13 @@ int OpenGLRenderDevice::renderToImage(Image* src_image, Rect& src, Image* dest_i
 	return 0;
 }
 
+int OpenGLRenderDevice::copyToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) {
+	glDisable(GL_BLEND);
+	int ret = renderToImage(src_image, src, dest_image, dest);
+	glEnable(GL_BLEND);
+	return ret;
+}
+
 Image * OpenGLRenderDevice::renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended) {
 	OpenGLImage *image = new OpenGLImage(this);
 	if (!image) return NULL;
@@ -859,6 +864,8 @@ void OpenGLRenderDevice::commitFrame() {
 }
 
 void OpenGLRenderDevice::destroyContext() {
+	// finish images that are still loading, so that they are released with the rest of the cache
+	waitForImageLoads();
 	resetGamma();
 
 	// we need to free all loaded graphics as they may be tied to the current context
@@ -953,7 +960,7 @@ void OpenGLRenderDevice::updateTitleBar() {
 	if (!window) return;
 
 	title = Utils::strdup(msg->get(eset->misc.window_title));
-	titlebar_icon = IMG_Load(mods->locate("images/logo/icon.png").c_str());
+	titlebar_icon = IMG_Load_RW(mods->openRW(mods->locate("images/logo/icon.png")), 1);
 
 	if (title) SDL_SetWindowTitle(window, title);
 	if (titlebar_icon) SDL_SetWindowIcon(window, titlebar_icon);
@@ -966,8 +973,9 @@ Image *OpenGLRenderDevice::loadImage(const std::string& filename, int error_type
 	if (img != NULL) return img;
 
 	// load image
-	OpenGLImage *image = NULL;
-	SDL_Surface *cleanup = IMG_Load(mods->locate(filename).c_str());
+	SDL_Surface *cleanup = takePreloadedImage(filename);
+	if (!cleanup)
+		cleanup = IMG_Load_RW(mods->openRW(mods->locate(filename)), 1);
 	if(!cleanup) {
 		if (error_type != ERROR_NONE)
 			Utils::logError("OpenGLRenderDevice: Couldn't load image: '%s'. %s", filename.c_str(), IMG_GetError());
@@ -977,36 +985,50 @@ Image *OpenGLRenderDevice::loadImage(const std::string& filename, int error_type
 			mods->resetModConfig();
 			Utils::Exit(1);
 		}
+
+		return NULL;
 	}
-	else {
-		image = new OpenGLImage(this);
-		SDL_Surface *surface = SDL_ConvertSurfaceFormat(cleanup, SDL_PIXELFORMAT_ABGR8888, 0);
-		image->w = surface->w;
-		image->h = surface->h;
 
-		glGenTextures(1, &(image->texture));
+	OpenGLImage *image = new OpenGLImage(this);
+	setImageSurface(image, cleanup, filename);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, image->texture);
+	// store image to cache
+	cacheStore(filename, image);
+	return image;
+}
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,     GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,     GL_CLAMP_TO_EDGE);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
-		int error = glGetError();
-		if (error != GL_NO_ERROR)
-			Utils::logInfo("Error while calling glTexImage2D(): %d", error);
+Image *OpenGLRenderDevice::createEmptyImage() {
+	return new OpenGLImage(this);
+}
 
-		SDL_FreeSurface(surface);
-		SDL_FreeSurface(cleanup);
-	}
+void OpenGLRenderDevice::setImageSurface(Image *dest, SDL_Surface *cleanup, const std::string& filename) {
+	OpenGLImage *image = static_cast<OpenGLImage *>(dest);
+	SDL_Surface *surface = SDL_ConvertSurfaceFormat(cleanup, SDL_PIXELFORMAT_ABGR8888, 0);
+	image->w = surface->w;
+	image->h = surface->h;
+
+	glGenTextures(1, &(image->texture));
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, image->texture);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,     GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,     GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
+	int error = glGetError();
+	if (error != GL_NO_ERROR)
+		Utils::logInfo("Error while calling glTexImage2D(): %d", error);
+
+	SDL_FreeSurface(surface);
+	SDL_FreeSurface(cleanup);
 
 	// load normal texture
 	std::string normalFileName = filename.substr(0, filename.size() - 4) + "_N.png";
 	normalFileName = mods->locate(normalFileName);
 
-	SDL_Surface *cleanupN = IMG_Load(normalFileName.c_str());
+	SDL_Surface *cleanupN = IMG_Load_RW(mods->openRW(normalFileName), 1);
 	if(cleanupN && cleanupN->w == image->w && cleanupN->h == image->h) {
 		SDL_Surface *surfaceN = SDL_ConvertSurfaceFormat(cleanupN, SDL_PIXELFORMAT_ABGR8888, 0);
 
@@ -1020,7 +1042,7 @@ Image *OpenGLRenderDevice::loadImage(const std::string& filename, int error_type
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,     GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,     GL_CLAMP_TO_EDGE);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, surfaceN->w, surfaceN->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, surfaceN->pixels);
-		int error = glGetError();
+		error = glGetError();
 		if (error != GL_NO_ERROR)
 			Utils::logInfo("Error while calling glTexImage2D(): %d", error);
 
@@ -1036,7 +1058,7 @@ Image *OpenGLRenderDevice::loadImage(const std::string& filename, int error_type
 	std::string aoFileName = filename.substr(0, filename.size() - 4) + "_AO.png";
 	aoFileName = mods->locate(aoFileName);
 
-	SDL_Surface *cleanupAO = IMG_Load(aoFileName.c_str());
+	SDL_Surface *cleanupAO = IMG_Load_RW(mods->openRW(aoFileName), 1);
 	if(cleanupAO && cleanupAO->w == image->w && cleanupAO->h == image->h) {
 		SDL_Surface *surfaceAO = SDL_ConvertSurfaceFormat(cleanupAO, SDL_PIXELFORMAT_ABGR8888, 0);
 
@@ -1050,7 +1072,7 @@ Image *OpenGLRenderDevice::loadImage(const std::string& filename, int error_type
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,     GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,     GL_CLAMP_TO_EDGE);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, surfaceAO->w, surfaceAO->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, surfaceAO->pixels);
-		int error = glGetError();
+		error = glGetError();
 		if (error != GL_NO_ERROR)
 			Utils::logInfo("Error while calling glTexImage2D(): %d", error);
 
@@ -1061,10 +1083,6 @@ Image *OpenGLRenderDevice::loadImage(const std::string& filename, int error_type
 		Utils::logInfo("Skip loading image %s, it has wrong size", aoFileName.c_str());
 		SDL_FreeSurface(cleanupAO);
 	}
-
-	// store image to cache
-	cacheStore(filename, image);
-	return image;
 }
 
 void OpenGLRenderDevice::getWindowSize(short unsigned *screen_w, short unsigned *screen_h) {
@@ -78,6 +78,7 @@ public:
 	virtual int render(Renderable& r, Rect& dest);
 	virtual int render(Sprite* r);
 	virtual int renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest);
+	virtual int copyToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest);
 
 	Image *renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended = true);
 	void drawPixel(int x, int y, const Color& color);
@@ -96,6 +97,8 @@ public:
 protected:
 	int createContextInternal();
 	void createContextError();
+	Image *createEmptyImage();
+	void setImageSurface(Image *image, SDL_Surface *surface, const std::string& filename);
 
 private:
 	void drawLine(int x0, int y0, int x1, int y1, const Color& color);
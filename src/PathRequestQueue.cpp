@@ -0,0 +1,266 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "PathRequestQueue.h"
+#include "Settings.h"
+#include "SharedResources.h"
+
+PathRequestQueue::PathRequestQueue()
+	: node_budget(0)
+	, next_id(0)
+	, use_thread(false)
+	, thread(NULL)
+	, lock(NULL)
+	, wake(NULL)
+	, batch_done(NULL)
+	, batch_state(BATCH_NONE)
+	, quit(false)
+{
+}
+
+PathRequestQueue::~PathRequestQueue() {
+	stopWorker();
+}
+
+/**
+ * The worker is started on the first request, so that menus and cutscenes don't need a thread
+ */
+void PathRequestQueue::startWorker() {
+#ifndef __EMSCRIPTEN__
+	if (thread || !settings->pathfinding_thread)
+		return;
+
+	lock = SDL_CreateMutex();
+	wake = SDL_CreateCond();
+	batch_done = SDL_CreateCond();
+	quit = false;
+
+	if (lock && wake && batch_done)
+		thread = SDL_CreateThread(runWorker, "pathfinding", this);
+
+	if (!thread) {
+		Utils::logError("PathRequestQueue: Unable to create worker thread, paths will be computed on the main thread: %s", SDL_GetError());
+		if (batch_done) SDL_DestroyCond(batch_done);
+		if (wake) SDL_DestroyCond(wake);
+		if (lock) SDL_DestroyMutex(lock);
+		batch_done = NULL;
+		wake = NULL;
+		lock = NULL;
+	}
+
+	use_thread = (thread != NULL);
+#endif
+}
+
+void PathRequestQueue::stopWorker() {
+	if (!thread)
+		return;
+
+	SDL_LockMutex(lock);
+	quit = true;
+	SDL_CondSignal(wake);
+	SDL_UnlockMutex(lock);
+
+	SDL_WaitThread(thread, NULL);
+	SDL_DestroyCond(batch_done);
+	SDL_DestroyCond(wake);
+	SDL_DestroyMutex(lock);
+
+	thread = NULL;
+	batch_done = NULL;
+	wake = NULL;
+	lock = NULL;
+	use_thread = false;
+	batch_state = BATCH_NONE;
+}
+
+int PathRequestQueue::runWorker(void* data) {
+	PathRequestQueue* queue = static_cast<PathRequestQueue*>(data);
+
+	while (true) {
+		SDL_LockMutex(queue->lock);
+		while (queue->batch_state != BATCH_WORKING && !queue->quit)
+			SDL_CondWait(queue->wake, queue->lock);
+		bool quit_now = queue->quit;
+		SDL_UnlockMutex(queue->lock);
+
+		if (quit_now)
+			break;
+
+		queue->processBatch();
+
+		SDL_LockMutex(queue->lock);
+		queue->batch_state = BATCH_DONE;
+		SDL_CondSignal(queue->batch_done);
+		SDL_UnlockMutex(queue->lock);
+	}
+
+	return 0;
+}
+
+int PathRequestQueue::request(const FPoint& start, const FPoint& end, int movement_type) {
+	startWorker();
+
+	int id = next_id++;
+	if (next_id < 0)
+		next_id = 0;
+
+	PathRequest& req = requests[id];
+	req.start = start;
+	req.end = end;
+	req.movement_type = movement_type;
+
+	pending.push_back(id);
+	return id;
+}
+
+bool PathRequestQueue::poll(int id, std::vector<FPoint> &path, bool &found) {
+	std::map<int, PathRequest>::iterator it = requests.find(id);
+
+	// unknown requests were dropped by clear(), so treat them as finished without a path
+	if (it == requests.end()) {
+		found = false;
+		return true;
+	}
+
+	if (!it->second.processed)
+		return false;
+
+	path.swap(it->second.path);
+	found = it->second.found;
+	requests.erase(it);
+	return true;
+}
+
+void PathRequestQueue::cancel(int id) {
+	std::map<int, PathRequest>::iterator it = requests.find(id);
+	if (it == requests.end())
+		return;
+
+	// the worker may still be using this request, so it gets removed when the batch is collected
+	// the flag is only read on the main thread
+	it->second.cancelled = true;
+
+	for (std::deque<int>::iterator p = pending.begin(); p != pending.end(); ++p) {
+		if (*p == id) {
+			pending.erase(p);
+			requests.erase(it);
+			break;
+		}
+	}
+}
+
+void PathRequestQueue::clear() {
+	// wait for the worker so that it doesn't write into requests we're about to delete
+	if (use_thread) {
+		SDL_LockMutex(lock);
+		while (batch_state == BATCH_WORKING)
+			SDL_CondWait(batch_done, lock);
+		batch_state = BATCH_NONE;
+		SDL_UnlockMutex(lock);
+	}
+
+	batch.clear();
+	batch_ids.clear();
+	pending.clear();
+	requests.clear();
+}
+
+/**
+ * Runs searches from the batch until the node budget is used up
+ * Called from the worker thread, or from logic() if there is no worker
+ */
+void PathRequestQueue::processBatch() {
+	unsigned int nodes_used = 0;
+
+	for (size_t i = 0; i < batch.size(); ++i) {
+		if (node_budget > 0 && nodes_used >= node_budget)
+			break;
+
+		PathRequest* req = batch[i];
+
+		snapshot.path_nodes_expanded = 0;
+		req->found = snapshot.computePath(req->start, req->end, req->path, req->movement_type, MapCollision::DEFAULT_PATH_LIMIT);
+		req->searched = true;
+
+		nodes_used += snapshot.path_nodes_expanded;
+	}
+}
+
+/**
+ * Finished requests wait for poll(); the ones that didn't fit in the node budget go back to the front of the queue
+ */
+void PathRequestQueue::collectBatch() {
+	for (size_t i = batch.size(); i > 0; --i) {
+		PathRequest* req = batch[i-1];
+		int id = batch_ids[i-1];
+
+		if (req->cancelled)
+			requests.erase(id);
+		else if (req->searched)
+			req->processed = true;
+		else
+			pending.push_front(id);
+	}
+
+	batch.clear();
+	batch_ids.clear();
+}
+
+void PathRequestQueue::logic(const MapCollision& collider) {
+	if (use_thread) {
+		SDL_LockMutex(lock);
+		int state = batch_state;
+		SDL_UnlockMutex(lock);
+
+		if (state == BATCH_WORKING)
+			return;
+
+		if (state == BATCH_DONE) {
+			collectBatch();
+			SDL_LockMutex(lock);
+			batch_state = BATCH_NONE;
+			SDL_UnlockMutex(lock);
+		}
+	}
+
+	if (pending.empty())
+		return;
+
+	// the worker searches a copy of the collision map, so entities can keep moving on the real one
+	// only the tiles that changed since the last batch are copied
+	snapshot.copyCollision(collider);
+	node_budget = settings->path_node_budget > 0 ? static_cast<unsigned int>(settings->path_node_budget) : 0;
+
+	while (!pending.empty()) {
+		int id = pending.front();
+		pending.pop_front();
+		batch.push_back(&requests[id]);
+		batch_ids.push_back(id);
+	}
+
+	if (use_thread) {
+		SDL_LockMutex(lock);
+		batch_state = BATCH_WORKING;
+		SDL_CondSignal(wake);
+		SDL_UnlockMutex(lock);
+	}
+	else {
+		processBatch();
+		collectBatch();
+	}
+}
@@ -0,0 +1,117 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class PathRequestQueue
+ *
+ * Runs MapCollision::computePath() on a worker thread.
+ * Requests are handed to the worker once per frame along with a snapshot of the collision map,
+ * and their results can be polled on a later frame. The snapshot is patched with the tiles that
+ * changed since the previous batch, rather than copied whole.
+ * The worker stops starting new searches once the per-frame node budget is used up.
+ *
+ * If threads aren't available, the same batches are processed on the main thread.
+ */
+
+#ifndef PATH_REQUEST_QUEUE_H
+#define PATH_REQUEST_QUEUE_H
+
+#include "CommonIncludes.h"
+#include "MapCollision.h"
+#include "Utils.h"
+
+#include <deque>
+
+class PathRequest {
+public:
+	FPoint start;
+	FPoint end;
+	int movement_type;
+
+	std::vector<FPoint> path;
+	bool found;
+	bool searched; // written by the worker
+	bool processed; // set once the batch is collected on the main thread
+	bool cancelled;
+
+	PathRequest()
+		: movement_type(MapCollision::MOVE_NORMAL)
+		, found(false)
+		, searched(false)
+		, processed(false)
+		, cancelled(false)
+	{}
+};
+
+class PathRequestQueue {
+public:
+	static const int NO_REQUEST = -1;
+
+	PathRequestQueue();
+	~PathRequestQueue();
+
+	// returns a handle that can be passed to poll() and cancel()
+	int request(const FPoint& start, const FPoint& end, int movement_type);
+
+	// returns true when the request is complete; path and found are set as computePath() would
+	// the handle is invalid afterwards
+	bool poll(int id, std::vector<FPoint> &path, bool &found);
+
+	void cancel(int id);
+
+	// drops all requests, such as when changing maps
+	void clear();
+
+	// called once per frame; collects finished searches and starts the next batch
+	void logic(const MapCollision& collider);
+
+private:
+	PathRequestQueue(const PathRequestQueue&); // not implemented
+
+	enum {
+		BATCH_NONE = 0,
+		BATCH_WORKING = 1,
+		BATCH_DONE = 2
+	};
+
+	static int runWorker(void* data);
+	void startWorker();
+	void stopWorker();
+	void processBatch();
+	void collectBatch();
+
+	std::map<int, PathRequest> requests;
+	std::deque<int> pending;
+
+	// only touched by the worker while batch_state is BATCH_WORKING
+	std::vector<PathRequest*> batch;
+	std::vector<int> batch_ids;
+	MapCollision snapshot;
+	unsigned int node_budget;
+
+	int next_id;
+	bool use_thread;
+
+	SDL_Thread* thread;
+	SDL_mutex* lock;
+	SDL_cond* wake;
+	SDL_cond* batch_done;
+	int batch_state;
+	bool quit;
+};
+
+#endif // PATH_REQUEST_QUEUE_H
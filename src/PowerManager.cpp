@@ -175,7 +175,8 @@ Power::Power()
 PowerManager::PowerManager()
 	: collider(NULL)
 	, used_items()
-	, used_equipped_items() {
+	, used_equipped_items()
+	, target_nearest_max(0) {
 	loadEffects();
 	loadPowers();
 }
@@ -262,6 +263,16 @@ void PowerManager::loadEffects() {
 	if (!effects.empty() && effects.back().id == "") {
 		effects.pop_back();
 	}
+
+	// map the interned effect ids to their definitions; the first definition of an id is used
+	for (size_t i = 0; i < effects.size(); ++i) {
+		effects[i].id_index = EffectManager::getIDIndex(effects[i].id);
+
+		if (effects[i].id_index >= effect_def_indexes.size())
+			effect_def_indexes.resize(effects[i].id_index + 1, EffectManager::NO_ID_INDEX);
+		if (effect_def_indexes[effects[i].id_index] == EffectManager::NO_ID_INDEX)
+			effect_def_indexes[effects[i].id_index] = i;
+	}
 }
 
 void PowerManager::loadPowers() {
@@ -694,6 +705,8 @@ void PowerManager::loadPowers() {
 				infile.error("PowerManager: Unknown effect '%s'", pe.id.c_str());
 			}
 			else {
+				pe.id_index = EffectManager::getIDIndex(pe.id);
+
 				if (infile.key == "post_effect_src")
 					pe.target_src = true;
 
@@ -869,13 +882,14 @@ void PowerManager::loadPowers() {
 			// @ATTR power.remove_effect|repeatable(predefined_string, int) : Effect ID, Number of Effect instances|Removes a number of instances of a specific Effect ID. Omitting the number of instances, or setting it to zero, will remove all instances/stacks.
 			std::string first = Parse::popFirstString(infile.val);
 			int second = Parse::popFirstInt(infile.val);
-			powers[input_id].remove_effects.push_back(std::pair<std::string, int>(first, second));
+			powers[input_id].remove_effects.push_back(std::pair<size_t, int>(EffectManager::getIDIndex(first), second));
 		}
 		else if (infile.key == "replace_by_effect") {
 			// @ATTR power.replace_by_effect|repeatable(int, predefined_string, int) : Power ID, Effect ID, Number of Effect instances|If the caster has at least the number of instances of the Effect ID, the defined Power ID will be cast instead.
 			PowerReplaceByEffect prbe;
 			prbe.power_id = Parse::popFirstInt(infile.val);
 			prbe.effect_id = Parse::popFirstString(infile.val);
+			prbe.effect_id_index = EffectManager::getIDIndex(prbe.effect_id);
 			prbe.count = Parse::popFirstInt(infile.val);
 			powers[input_id].replace_by_effect.push_back(prbe);
 		}
@@ -906,6 +920,8 @@ void PowerManager::loadPowers() {
 
 		// calculate effective combat range
 		setCombatRange(i);
+
+		target_nearest_max = std::max(target_nearest_max, powers[i].target_nearest);
 	}
 }
 
@@ -1140,7 +1156,7 @@ bool PowerManager::effect(StatBlock *target_stats, StatBlock *caster_stats, int
 			continue;
 
 		EffectDef effect_data;
-		EffectDef* effect_ptr = getEffectDef(pe.id);
+		EffectDef* effect_ptr = getEffectDef(pe.id_index);
 
 		int magnitude = pe.magnitude;
 		int duration = pe.duration;
@@ -1199,6 +1215,7 @@ bool PowerManager::effect(StatBlock *target_stats, StatBlock *caster_stats, int
 		else {
 			// all other effects
 			effect_data.id = effect_data.type = pe.id;
+			effect_data.id_index = pe.id_index;
 		}
 
 		dest_stats->effects.addEffect(effect_data, duration, magnitude, source_type, power_index);
@@ -1497,7 +1514,7 @@ bool PowerManager::block(int power_index, StatBlock *src_stats) {
 
 int PowerManager::checkReplaceByEffect(int power_index, StatBlock *src_stats) {
 	for (size_t i = 0; i < powers[power_index].replace_by_effect.size(); ++i) {
-		if (src_stats->effects.hasEffect(powers[power_index].replace_by_effect[i].effect_id, powers[power_index].replace_by_effect[i].count)) {
+		if (src_stats->effects.hasEffect(powers[power_index].replace_by_effect[i].effect_id_index, powers[power_index].replace_by_effect[i].count)) {
 			return powers[power_index].replace_by_effect[i].power_id;
 		}
 	}
@@ -1696,12 +1713,15 @@ void PowerManager::activatePassivePostPowers(StatBlock *src_stats) {
 }
 
 EffectDef* PowerManager::getEffectDef(const std::string& id) {
-	for (unsigned i=0; i<effects.size(); ++i) {
-		if (effects[i].id == id) {
-			return &effects[i];
-		}
-	}
-	return NULL;
+	// only a lookup, so that probing for an effect doesn't intern the string
+	return getEffectDef(EffectManager::findIDIndex(id));
+}
+
+EffectDef* PowerManager::getEffectDef(size_t id_index) {
+	if (id_index >= effect_def_indexes.size() || effect_def_indexes[id_index] == EffectManager::NO_ID_INDEX)
+		return NULL;
+
+	return &effects[effect_def_indexes[id_index]];
 }
 
 int PowerManager::verifyID(int power_id, FileParser* infile, bool allow_zero) {
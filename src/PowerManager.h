@@ -28,18 +28,19 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef POWER_MANAGER_H
 #define POWER_MANAGER_H
 
+#include "EffectManager.h"
 #include "Map.h"
 #include "MapCollision.h"
 #include "Utils.h"
 
 class Animation;
 class AnimationSet;
-class EffectDef;
 class Hazard;
 
 class PostEffect {
 public:
 	std::string id;
+	size_t id_index;
 	int magnitude;
 	int duration;
 	int chance;
@@ -47,6 +48,7 @@ public:
 
 	PostEffect()
 		: id("")
+		, id_index(EffectManager::NO_ID_INDEX)
 		, magnitude(0)
 		, duration(0)
 		, chance(100)
@@ -59,6 +61,7 @@ public:
 	int power_id;
 	int count;
 	std::string effect_id;
+	size_t effect_id_index;
 };
 
 class PowerRequiredItem {
@@ -303,7 +306,7 @@ public:
 	int script_trigger;
 	std::string script;
 
-	std::vector< std::pair<std::string, int> > remove_effects;
+	std::vector< std::pair<size_t, int> > remove_effects; // interned effect ids
 
 	std::vector<PowerReplaceByEffect> replace_by_effect;
 
@@ -322,6 +325,9 @@ private:
 
 	MapCollision *collider;
 
+	// indexes into effects, by interned effect id
+	std::vector<size_t> effect_def_indexes;
+
 	void loadEffects();
 	void loadPowers();
 
@@ -370,6 +376,7 @@ public:
 	int checkReplaceByEffect(int power_index, StatBlock *src_stats);
 
 	EffectDef* getEffectDef(const std::string& id);
+	EffectDef* getEffectDef(size_t id_index);
 
 	std::vector<EffectDef> effects;
 	std::vector<Power> powers;
@@ -381,6 +388,9 @@ public:
 
 	std::vector<int> used_items;
 	std::vector<int> used_equipped_items;
+
+	// the largest target_nearest of any power; the hero doesn't need to look for enemies further away than this
+	float target_nearest_max;
 };
 
 #endif
@@ -0,0 +1,237 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "Profiler.h"
+#include "RenderDevice.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "Utils.h"
+
+namespace {
+
+double ticksToMS(Uint64 ticks) {
+	return static_cast<double>(ticks) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+// trace timestamps are in microseconds
+double ticksToUS(Uint64 ticks) {
+	return ticksToMS(ticks) * 1000.0;
+}
+
+} // namespace
+
+const size_t Profiler::FRAME_COUNT;
+const size_t Profiler::NO_ZONE;
+const int Profiler::GRAPH_FRAMES;
+const int Profiler::GRAPH_HEIGHT;
+const int Profiler::GRAPH_MARGIN;
+
+bool Profiler::show_graph = false;
+std::vector<Profiler::Frame> Profiler::frames;
+size_t Profiler::frame_index = 0;
+size_t Profiler::frames_finished = 0;
+Uint32 Profiler::frame_serial = 0;
+bool Profiler::in_frame = false;
+unsigned short Profiler::depth = 0;
+
+Profiler::Zone::Zone(const char* name)
+	: frame_serial(Profiler::frame_serial)
+	, index(NO_ZONE) {
+	if (!in_frame)
+		return;
+
+	Frame& frame = frames[frame_index];
+	index = frame.zones.size();
+	frame.zones.resize(index + 1);
+
+	ZoneRecord& record = frame.zones.back();
+	record.name = name;
+	record.depth = depth;
+	record.start = SDL_GetPerformanceCounter();
+	record.end = 0;
+
+	depth++;
+}
+
+Profiler::Zone::~Zone() {
+	// the zone was started before this frame
+	if (index == NO_ZONE || !in_frame || frame_serial != Profiler::frame_serial)
+		return;
+
+	frames[frame_index].zones[index].end = SDL_GetPerformanceCounter();
+	depth--;
+}
+
+void Profiler::beginFrame() {
+	if (frames.empty())
+		frames.resize(FRAME_COUNT);
+
+	if (in_frame)
+		endFrame();
+
+	frame_index = (frame_index + 1) % FRAME_COUNT;
+	frame_serial++;
+
+	// the oldest frame is overwritten
+	if (frames_finished == FRAME_COUNT)
+		frames_finished--;
+
+	// the zone vectors keep their capacity, so recording doesn't allocate once the buffer has filled up
+	Frame& frame = frames[frame_index];
+	frame.zones.clear();
+	frame.start = SDL_GetPerformanceCounter();
+	frame.end = frame.start;
+
+	in_frame = true;
+	depth = 0;
+}
+
+void Profiler::endFrame() {
+	if (!in_frame)
+		return;
+
+	frames[frame_index].end = SDL_GetPerformanceCounter();
+	in_frame = false;
+
+	if (frames_finished < FRAME_COUNT)
+		frames_finished++;
+}
+
+const Profiler::Frame& Profiler::getFrame(size_t age) {
+	// the current frame is still being recorded
+	size_t newest = in_frame ? frame_index + FRAME_COUNT - 1 : frame_index;
+	return frames[(newest + FRAME_COUNT - age) % FRAME_COUNT];
+}
+
+void Profiler::renderGraph() {
+	if (!show_graph || !render_device || frames_finished == 0)
+		return;
+
+	const double target_ms = 1000.0 / static_cast<double>(std::max<unsigned short>(settings->max_frames_per_sec, 1));
+
+	// twice the target frame time fits in the graph
+	const double ms_per_pixel = (target_ms * 2) / static_cast<double>(GRAPH_HEIGHT);
+
+	const int left = GRAPH_MARGIN;
+	const int bottom = settings->view_h - GRAPH_MARGIN;
+	const int right = left + GRAPH_FRAMES * 2;
+
+	const Color color_background(0, 0, 0, 160);
+	const Color color_good(0, 200, 0);
+	const Color color_slow(255, 200, 0);
+	const Color color_over(255, 0, 0);
+	const Color color_target(255, 255, 255);
+
+	render_device->drawRectangle(Point(left, bottom - GRAPH_HEIGHT), Point(right, bottom), color_background);
+
+	size_t count = std::min(frames_finished, static_cast<size_t>(GRAPH_FRAMES));
+	for (size_t i = 0; i < count; ++i) {
+		const Frame& frame = getFrame(i);
+		double ms = ticksToMS(frame.end - frame.start);
+
+		int height = std::min(static_cast<int>(ms / ms_per_pixel), GRAPH_HEIGHT);
+		if (height < 1)
+			height = 1;
+
+		Color color = color_good;
+		if (ms > target_ms)
+			color = color_over;
+		else if (ms > target_ms * 0.75)
+			color = color_slow;
+
+		// the most recent frame is on the right
+		int x = right - 1 - static_cast<int>(i) * 2;
+		render_device->drawLine(x, bottom, x, bottom - height, color);
+	}
+
+	int target_y = bottom - static_cast<int>(target_ms / ms_per_pixel);
+	render_device->drawLine(left, target_y, right, target_y, color_target);
+}
+
+bool Profiler::writeTrace(const std::string& filename, float seconds) {
+	std::ofstream outfile(filename.c_str(), std::ios::out | std::ios::trunc);
+	if (!outfile.is_open()) {
+		Utils::logError("Profiler: Unable to write '%s'.", filename.c_str());
+		return false;
+	}
+
+	size_t count = 0;
+	if (frames_finished > 0) {
+		const Uint64 newest_end = getFrame(0).end;
+		const Uint64 max_age = static_cast<Uint64>(static_cast<double>(std::max(seconds, 0.f)) * static_cast<double>(SDL_GetPerformanceFrequency()));
+
+		while (count < frames_finished && newest_end - getFrame(count).start <= max_age) {
+			count++;
+		}
+	}
+
+	// timestamps are relative to the oldest frame in the trace
+	const Uint64 base = count > 0 ? getFrame(count - 1).start : 0;
+	bool first_event = true;
+
+	outfile.setf(std::ios::fixed);
+	outfile.precision(3);
+
+	outfile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	for (size_t i = count; i > 0; --i) {
+		const Frame& frame = getFrame(i - 1);
+
+		if (!first_event)
+			outfile << ",\n";
+		first_event = false;
+
+		outfile << "{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1";
+		outfile << ",\"ts\":" << ticksToUS(frame.start - base);
+		outfile << ",\"dur\":" << ticksToUS(frame.end - frame.start) << "}";
+
+		for (size_t j = 0; j < frame.zones.size(); ++j) {
+			const ZoneRecord& zone = frame.zones[j];
+
+			// zones that were still open when the frame ended are cut off at the end of the frame
+			Uint64 zone_end = zone.end != 0 ? zone.end : frame.end;
+
+			outfile << ",\n{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1";
+			outfile << ",\"ts\":" << ticksToUS(zone.start - base);
+			outfile << ",\"dur\":" << ticksToUS(zone_end - zone.start) << "}";
+		}
+	}
+
+	outfile << "\n]}\n";
+
+	if (outfile.bad()) {
+		Utils::logError("Profiler: Unable to write '%s'.", filename.c_str());
+		outfile.close();
+		return false;
+	}
+	outfile.close();
+
+	Utils::logInfo("Profiler: Wrote %u frames to '%s'.", static_cast<unsigned>(count), filename.c_str());
+	return true;
+}
+
+bool Profiler::hasZones() {
+#ifdef FLARE_PROFILER
+	return true;
+#else
+	return false;
+#endif
+}
+
+float Profiler::getRecordedSeconds() {
+	return static_cast<float>(FRAME_COUNT) / static_cast<float>(std::max<unsigned short>(settings->max_frames_per_sec, 1));
+}
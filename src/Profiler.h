@@ -0,0 +1,111 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class Profiler
+ *
+ * Records how long each frame took, and the zones that ran during it, in a ring buffer of recent frames.
+ * The recorded frames can be shown as a frame time graph, or written as a Chrome trace (chrome://tracing).
+ *
+ * Zones are added with PROFILER_ZONE("name"), which measures the time until the end of the enclosing scope.
+ * The name must be a string literal. Zones are only compiled in when FLARE_PROFILER is defined
+ * (the USE_PROFILER CMake option); frame times are always recorded.
+ * Zones are only recorded on the main thread, between beginFrame() and endFrame().
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "CommonIncludes.h"
+
+#ifdef FLARE_PROFILER
+#define PROFILER_ZONE_NAME2(line) profiler_zone_##line
+#define PROFILER_ZONE_NAME(line) PROFILER_ZONE_NAME2(line)
+#define PROFILER_ZONE(name) Profiler::Zone PROFILER_ZONE_NAME(__LINE__)(name)
+#else
+#define PROFILER_ZONE(name)
+#endif
+
+class Profiler {
+public:
+	class Zone {
+	public:
+		explicit Zone(const char* name);
+		~Zone();
+
+	private:
+		Uint32 frame_serial;
+		size_t index;
+	};
+
+	static void beginFrame();
+	static void endFrame();
+
+	// draws the frame times of the most recent frames, if show_graph is set
+	static void renderGraph();
+
+	// writes the frames of the last few seconds as a Chrome trace; returns false if the file can't be written
+	static bool writeTrace(const std::string& filename, float seconds);
+
+	// false if the zones were compiled out
+	static bool hasZones();
+
+	// the number of seconds of frames that are kept, at the current frame rate
+	static float getRecordedSeconds();
+
+	static bool show_graph;
+
+private:
+	class ZoneRecord {
+	public:
+		const char* name;
+		Uint64 start;
+		Uint64 end;
+		unsigned short depth;
+	};
+
+	class Frame {
+	public:
+		Uint64 start;
+		Uint64 end;
+		std::vector<ZoneRecord> zones;
+
+		Frame()
+			: start(0)
+			, end(0) {
+		}
+	};
+
+	static const size_t FRAME_COUNT = 1200;
+	static const size_t NO_ZONE = static_cast<size_t>(-1);
+
+	static const int GRAPH_FRAMES = 120;
+	static const int GRAPH_HEIGHT = 80;
+	static const int GRAPH_MARGIN = 8;
+
+	// returns the finished frame that ended age frames ago; 0 is the most recent one
+	static const Frame& getFrame(size_t age);
+
+	static std::vector<Frame> frames;
+	static size_t frame_index;
+	static size_t frames_finished;
+	static Uint32 frame_serial;
+	static bool in_frame;
+	static unsigned short depth;
+};
+
+#endif // PROFILER_H
@@ -16,7 +16,10 @@ You should have received a copy of the GNU General Public License along with
 FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
+#include <SDL_image.h>
+
 #include "EngineSettings.h"
+#include "ModManager.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedResources.h"
@@ -44,7 +47,7 @@ void Image::ref() {
 
 void Image::unref() {
 	--ref_counter;
-	if (ref_counter == 0)
+	if (ref_counter == 0 && !device->retainImage(this))
 		delete this;
 }
 
@@ -162,6 +165,14 @@ RenderDevice::RenderDevice()
 	, is_initialized(false)
 	, reload_graphics(false)
 	, ddpi(0)
+	, retained_bytes(0)
+	, cache_hits(0)
+	, cache_misses(0)
+	, cache_evictions(0)
+	, image_loaders_quit(false)
+	, image_load_lock(NULL)
+	, image_load_wake(NULL)
+	, image_load_done(NULL)
 {
 	// don't bother initializing gamma_r, gamma_g, gamma_b
 	// it is up to the implemented render device to initialize them
@@ -169,6 +180,8 @@ RenderDevice::RenderDevice()
 }
 
 RenderDevice::~RenderDevice() {
+	stopImageLoaders();
+	clearPreloadedImages();
 }
 
 int RenderDevice::createContext() {
@@ -219,32 +232,309 @@ void RenderDevice::destroyContext() {
 Image * RenderDevice::cacheLookup(const std::string &filename) {
 	IMAGE_CACHE_CONTAINER_ITER it;
 	it = cache.find(filename);
+	if (it != cache.end() && !image_loads.empty()) {
+		// the caller expects a complete image, so finish loading it now
+		// if loading fails, the image is removed from the cache and the caller tries again
+		waitForImageLoad(it->second);
+		it = cache.find(filename);
+	}
 	if (it != cache.end()) {
-		it->second->ref();
+		++cache_hits;
+		refCachedImage(it->second);
 		return it->second;
 	}
+	++cache_misses;
 	return NULL;
 }
 
 void RenderDevice::cacheStore(const std::string &filename, Image *image) {
 	if (image == NULL) return;
 	cache[filename] = image;
+	image->cache_filename = filename;
 }
 
 void RenderDevice::cacheRemove(Image *image) {
-	IMAGE_CACHE_CONTAINER_ITER it = cache.begin();
-	while (it != cache.end()) {
-		if (it->second == image)
-			break;
-		++it;
+	if (image->cache_filename.empty())
+		return;
+
+	// the entry may have been replaced by a newer image with the same filename
+	IMAGE_CACHE_CONTAINER_ITER it = cache.find(image->cache_filename);
+	if (it != cache.end() && it->second == image) {
+		cache.erase(it);
+	}
+	image->cache_filename.clear();
+}
+
+void RenderDevice::addPreloadedImage(const std::string& filename, SDL_Surface* surface) {
+	if (surface == NULL) return;
+
+	std::map<std::string, SDL_Surface*>::iterator it = preloaded_images.find(filename);
+	if (it != preloaded_images.end()) {
+		SDL_FreeSurface(it->second);
+		it->second = surface;
+	}
+	else {
+		preloaded_images[filename] = surface;
+	}
+}
+
+void RenderDevice::clearPreloadedImages() {
+	std::map<std::string, SDL_Surface*>::iterator it;
+	for (it = preloaded_images.begin(); it != preloaded_images.end(); ++it) {
+		SDL_FreeSurface(it->second);
 	}
+	preloaded_images.clear();
+}
+
+SDL_Surface* RenderDevice::takePreloadedImage(const std::string& filename) {
+	if (preloaded_images.empty())
+		return NULL;
+
+	std::map<std::string, SDL_Surface*>::iterator it = preloaded_images.find(filename);
+	if (it == preloaded_images.end())
+		return NULL;
+
+	SDL_Surface* surface = it->second;
+	preloaded_images.erase(it);
+	return surface;
+}
 
+Image *RenderDevice::loadImageAsync(const std::string& filename, int error_type) {
+	IMAGE_CACHE_CONTAINER_ITER it = cache.find(filename);
 	if (it != cache.end()) {
-		cache.erase(it);
+		++cache_hits;
+		refCachedImage(it->second);
+		return it->second;
+	}
+	++cache_misses;
+
+	Image *image = createEmptyImage();
+	cacheStore(filename, image);
+
+	// the load holds its own reference, so that the caller can release the image before it's ready
+	image->ref();
+
+	ImageLoad *load = new ImageLoad();
+	load->image = image;
+	load->filename = filename;
+	load->error_type = error_type;
+	image_loads.push_back(load);
+
+	load->surface = takePreloadedImage(filename);
+	if (load->surface) {
+		load->done = true;
+		return image;
+	}
+
+	// ModManager isn't thread-safe, so the file is opened here
+	load->rw = mods->openRW(mods->locate(filename));
+
+	startImageLoaders();
+	if (load->rw && !image_loaders.empty()) {
+		SDL_LockMutex(image_load_lock);
+		image_load_queue.push_back(load);
+		SDL_CondSignal(image_load_wake);
+		SDL_UnlockMutex(image_load_lock);
+	}
+	else {
+		decodeImage(load);
+		load->done = true;
+	}
+
+	return image;
+}
+
+/**
+ * Fills in the images that have been decoded so far
+ * Called once per frame
+ */
+void RenderDevice::updateImageLoads() {
+	if (image_loads.empty())
+		return;
+
+	std::vector<ImageLoad*> finished;
+
+	if (image_load_lock)
+		SDL_LockMutex(image_load_lock);
+
+	size_t unfinished = 0;
+	for (size_t i = 0; i < image_loads.size(); ++i) {
+		if (image_loads[i]->done)
+			finished.push_back(image_loads[i]);
+		else
+			image_loads[unfinished++] = image_loads[i];
+	}
+	image_loads.resize(unfinished);
+
+	if (image_load_lock)
+		SDL_UnlockMutex(image_load_lock);
+
+	for (size_t i = 0; i < finished.size(); ++i) {
+		finishImageLoad(finished[i]);
+	}
+}
+
+/**
+ * Blocks until all images from loadImageAsync() are ready
+ */
+void RenderDevice::waitForImageLoads() {
+	if (image_loads.empty())
+		return;
+
+	if (image_load_lock) {
+		SDL_LockMutex(image_load_lock);
+		for (size_t i = 0; i < image_loads.size(); ++i) {
+			while (!image_loads[i]->done)
+				SDL_CondWait(image_load_done, image_load_lock);
+		}
+		SDL_UnlockMutex(image_load_lock);
+	}
+
+	updateImageLoads();
+}
+
+void RenderDevice::waitForImageLoad(Image *image) {
+	for (size_t i = 0; i < image_loads.size(); ++i) {
+		ImageLoad *load = image_loads[i];
+		if (load->image != image)
+			continue;
+
+		if (image_load_lock) {
+			SDL_LockMutex(image_load_lock);
+			while (!load->done)
+				SDL_CondWait(image_load_done, image_load_lock);
+			SDL_UnlockMutex(image_load_lock);
+		}
+
+		image_loads.erase(image_loads.begin() + i);
+		finishImageLoad(load);
+		return;
 	}
 }
 
+void RenderDevice::finishImageLoad(ImageLoad *load) {
+	if (load->surface) {
+		setImageSurface(load->image, load->surface, load->filename);
+	}
+	else {
+		// leave the image empty, but let the next request for this file try again
+		cacheRemove(load->image);
+
+		if (load->error_type != ERROR_NONE)
+			Utils::logError("RenderDevice: Couldn't load image: '%s'. %s", load->filename.c_str(), load->error.c_str());
+
+		if (load->error_type == ERROR_EXIT) {
+			Utils::logErrorDialog("RenderDevice: Couldn't load image: '%s'.\n%s", load->filename.c_str(), load->error.c_str());
+			mods->resetModConfig();
+			Utils::Exit(1);
+		}
+	}
+
+	load->image->unref();
+	delete load;
+}
+
+void RenderDevice::decodeImage(ImageLoad *load) {
+	load->surface = IMG_Load_RW(load->rw, 1);
+	load->rw = NULL;
+
+	if (!load->surface)
+		load->error = IMG_GetError();
+}
+
+/**
+ * Worker threads are only created once the first image is loaded asynchronously
+ */
+void RenderDevice::startImageLoaders() {
+#ifndef __EMSCRIPTEN__
+	if (image_load_lock)
+		return;
+
+	image_load_lock = SDL_CreateMutex();
+	image_load_wake = SDL_CreateCond();
+	image_load_done = SDL_CreateCond();
+	image_loaders_quit = false;
+
+	// leave one core for the main thread
+	int thread_count = std::max(1, std::min(SDL_GetCPUCount() - 1, 4));
+
+	if (image_load_lock && image_load_wake && image_load_done) {
+		for (int i = 0; i < thread_count; ++i) {
+			SDL_Thread *thread = SDL_CreateThread(runImageLoader, "image_loader", this);
+			if (!thread)
+				break;
+			image_loaders.push_back(thread);
+		}
+	}
+
+	if (image_loaders.empty()) {
+		Utils::logError("RenderDevice: Unable to create image loading threads, images will be loaded on the main thread: %s", SDL_GetError());
+	}
+#endif
+}
+
+void RenderDevice::stopImageLoaders() {
+	if (image_load_lock) {
+		SDL_LockMutex(image_load_lock);
+		image_loaders_quit = true;
+		SDL_CondBroadcast(image_load_wake);
+		SDL_UnlockMutex(image_load_lock);
+
+		for (size_t i = 0; i < image_loaders.size(); ++i) {
+			SDL_WaitThread(image_loaders[i], NULL);
+		}
+		image_loaders.clear();
+		image_load_queue.clear();
+	}
+
+	// the images themselves might already be gone, so only the decoding state is freed
+	for (size_t i = 0; i < image_loads.size(); ++i) {
+		if (image_loads[i]->rw)
+			SDL_RWclose(image_loads[i]->rw);
+		if (image_loads[i]->surface)
+			SDL_FreeSurface(image_loads[i]->surface);
+		delete image_loads[i];
+	}
+	image_loads.clear();
+
+	if (image_load_done) SDL_DestroyCond(image_load_done);
+	if (image_load_wake) SDL_DestroyCond(image_load_wake);
+	if (image_load_lock) SDL_DestroyMutex(image_load_lock);
+	image_load_done = NULL;
+	image_load_wake = NULL;
+	image_load_lock = NULL;
+}
+
+int RenderDevice::runImageLoader(void *data) {
+	RenderDevice *device = static_cast<RenderDevice *>(data);
+
+	SDL_LockMutex(device->image_load_lock);
+	while (true) {
+		while (!device->image_loaders_quit && device->image_load_queue.empty())
+			SDL_CondWait(device->image_load_wake, device->image_load_lock);
+
+		if (device->image_loaders_quit)
+			break;
+
+		ImageLoad *load = device->image_load_queue.front();
+		device->image_load_queue.pop_front();
+
+		SDL_UnlockMutex(device->image_load_lock);
+		decodeImage(load);
+		SDL_LockMutex(device->image_load_lock);
+
+		load->done = true;
+		SDL_CondBroadcast(device->image_load_done);
+	}
+	SDL_UnlockMutex(device->image_load_lock);
+
+	return 0;
+}
+
 void RenderDevice::cacheRemoveAll() {
+	// nothing else refers to the retained images, so they have to be deleted here
+	clearRetainedImages();
+
 	IMAGE_CACHE_CONTAINER_ITER it = cache.begin();
 
 	while (it != cache.end()) {
@@ -253,6 +543,80 @@ void RenderDevice::cacheRemoveAll() {
 	}
 }
 
+/**
+ * Increases the reference count of a cached image, reclaiming it if it was retained
+ */
+void RenderDevice::refCachedImage(Image *image) {
+	std::map<Image *, RETAINED_IMAGE_LIST::iterator>::iterator it = retained_image_index.find(image);
+	if (it != retained_image_index.end()) {
+		retained_bytes -= it->second->second;
+		retained_images.erase(it->second);
+		retained_image_index.erase(it);
+	}
+
+	image->ref();
+}
+
+bool RenderDevice::retainImage(Image *image) {
+	const size_t max_bytes = static_cast<size_t>(std::max(settings->image_cache_memory, 0)) * 1024 * 1024;
+	const size_t bytes = getImageBytes(image);
+	if (bytes == 0 || bytes > max_bytes)
+		return false;
+
+	// only images that can be looked up again are worth keeping
+	if (image->cache_filename.empty())
+		return false;
+
+	IMAGE_CACHE_CONTAINER_ITER it = cache.find(image->cache_filename);
+	if (it == cache.end() || it->second != image)
+		return false;
+
+	retained_images.push_back(std::pair<Image *, size_t>(image, bytes));
+	retained_image_index[image] = --retained_images.end();
+	retained_bytes += bytes;
+
+	evictRetainedImages(max_bytes);
+	return true;
+}
+
+void RenderDevice::evictRetainedImages(size_t max_bytes) {
+	while (retained_bytes > max_bytes && !retained_images.empty()) {
+		Image *image = retained_images.front().first;
+		retained_bytes -= retained_images.front().second;
+		retained_image_index.erase(image);
+		retained_images.pop_front();
+
+		++cache_evictions;
+
+		// also removes the image from the cache
+		delete image;
+	}
+}
+
+void RenderDevice::clearRetainedImages() {
+	evictRetainedImages(0);
+}
+
+size_t RenderDevice::getImageBytes(Image *image) {
+	return static_cast<size_t>(std::max(image->getWidth(), 0)) * static_cast<size_t>(std::max(image->getHeight(), 0)) * (BITS_PER_PIXEL / 8);
+}
+
+RenderDevice::ImageCacheStats RenderDevice::getImageCacheStats() {
+	ImageCacheStats stats;
+	stats.hits = cache_hits;
+	stats.misses = cache_misses;
+	stats.evictions = cache_evictions;
+	stats.retained_images = retained_images.size();
+	stats.retained_bytes = retained_bytes;
+
+	for (IMAGE_CACHE_CONTAINER_ITER it = cache.begin(); it != cache.end(); ++it) {
+		++stats.images;
+		stats.bytes += getImageBytes(it->second);
+	}
+
+	return stats;
+}
+
 bool RenderDevice::localToGlobal(Sprite *r) {
 	m_clip = r->getClip();
 
@@ -359,6 +723,14 @@ void RenderDevice::windowResizeInternal() {
 	}
 }
 
+/**
+ * Like renderToImage(), but replaces the destination pixels instead of blending with them
+ * Devices that can't disable blending fall back to renderToImage()
+ */
+int RenderDevice::copyToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) {
+	return renderToImage(src_image, src, dest_image, dest);
+}
+
 void RenderDevice::setBackgroundColor(Color color) {
 	// print out the color to avoid unused variable compiler warning
 	Utils::logInfo("RenderDevice: Trying to set background color to (%d,%d,%d,%d).", color.r, color.g, color.b, color.a);
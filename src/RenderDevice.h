@@ -21,6 +21,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef RENDERDEVICE_H
 #define RENDERDEVICE_H
 
+#include <deque>
+#include <list>
 #include <vector>
 #include <map>
 #include "Utils.h"
@@ -87,7 +89,8 @@ protected:
  *
  * Image uses a refrence counter to control when to free the resource, when the
  * last reference is released, the Image is deleted and then removed from cache
- * using RenderDevice::freeImage().
+ * using RenderDevice::freeImage(). Images loaded from files may instead be kept
+ * by RenderDevice::retainImage() until they are loaded again or evicted.
  *
  * The caller who instantiates an Image is responsible for release the reference
  * to the image when not used anymore.
@@ -126,10 +129,14 @@ private:
 	friend class SDLSoftwareImage;
 	friend class SDLHardwareImage;
 	friend class OpenGLImage;
+	friend class RenderDevice;
 
 private:
 	RenderDevice *device;
 	uint32_t ref_counter;
+
+	// the key of this image in RenderDevice::cache, or empty if it isn't cached
+	std::string cache_filename;
 };
 
 class Renderable {
@@ -202,6 +209,27 @@ public:
 
 	static const unsigned char BITS_PER_PIXEL;
 
+	class ImageCacheStats {
+	public:
+		unsigned long hits;
+		unsigned long misses;
+		unsigned long evictions;
+		size_t images;
+		size_t bytes;
+		size_t retained_images;
+		size_t retained_bytes;
+
+		ImageCacheStats()
+			: hits(0)
+			, misses(0)
+			, evictions(0)
+			, images(0)
+			, bytes(0)
+			, retained_images(0)
+			, retained_bytes(0) {
+		}
+	};
+
 	RenderDevice();
 	virtual ~RenderDevice();
 
@@ -217,10 +245,32 @@ public:
 	virtual Image *createImage(int width, int height) = 0;
 	void freeImage(Image *image);
 
+	/* Called when the last reference to an image is released.
+	 * Images loaded from files are kept until they are loaded again, or until the image_cache_memory setting
+	 * is exceeded, at which point the least recently released images are deleted.
+	 * Returns false if the image should be deleted right away. */
+	bool retainImage(Image *image);
+	ImageCacheStats getImageCacheStats();
+
+	/* Images that were decoded ahead of time, such as by MapPreloader.
+	 * loadImage() takes ownership of a preloaded surface; the rest are freed by clearPreloadedImages(). */
+	void addPreloadedImage(const std::string& filename, SDL_Surface* surface);
+	void clearPreloadedImages();
+
+	/* Asynchronous image loading
+	 * loadImageAsync() returns an empty image right away, and the file is decoded on a worker thread.
+	 * The image is filled in by updateImageLoads() or waitForImageLoads(), which are called from the main thread.
+	 * The size of the image isn't known until then, so sprites should only be created from it after waitForImageLoads().
+	 * If the file can't be loaded, the image stays empty. */
+	Image *loadImageAsync(const std::string& filename, int error_type);
+	void updateImageLoads();
+	void waitForImageLoads();
+
 	/** Screen operations */
 	virtual int render(Sprite* r) = 0;
 	virtual int render(Renderable& r, Rect& dest) = 0;
 	virtual int renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) = 0;
+	virtual int copyToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest);
 	virtual Image* renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended) = 0;
 	virtual void blankScreen() = 0;
 	virtual void commitFrame() = 0;
@@ -243,8 +293,17 @@ protected:
 	void cacheStore(const std::string &filename, Image *);
 	void cacheRemove(Image *image);
 	void cacheRemoveAll();
+	void clearRetainedImages();
 	void windowResizeInternal();
 
+	/* returns NULL if the image wasn't preloaded */
+	SDL_Surface* takePreloadedImage(const std::string& filename);
+
+	/* Used by loadImageAsync(): creates an image without pixels, and fills it from a decoded surface later.
+	 * setImageSurface() takes ownership of the surface. */
+	virtual Image *createEmptyImage() = 0;
+	virtual void setImageSurface(Image *image, SDL_Surface *surface, const std::string& filename) = 0;
+
 	/** Context operations */
 	virtual int createContextInternal() = 0;
 	virtual void createContextError() = 0;
@@ -276,6 +335,62 @@ private:
 
 	IMAGE_CACHE_CONTAINER cache;
 
+	// images in the cache that are no longer referenced, with their size in bytes; the least recently released is first
+	typedef std::list<std::pair<Image *, size_t> > RETAINED_IMAGE_LIST;
+	RETAINED_IMAGE_LIST retained_images;
+	std::map<Image *, RETAINED_IMAGE_LIST::iterator> retained_image_index;
+	size_t retained_bytes;
+
+	unsigned long cache_hits;
+	unsigned long cache_misses;
+	unsigned long cache_evictions;
+
+	void refCachedImage(Image *image);
+	void evictRetainedImages(size_t max_bytes);
+	static size_t getImageBytes(Image *image);
+
+	std::map<std::string, SDL_Surface*> preloaded_images;
+
+	class ImageLoad {
+	public:
+		Image *image;
+		std::string filename;
+		int error_type;
+
+		// only touched by the worker until done is set
+		SDL_RWops *rw;
+		SDL_Surface *surface;
+		std::string error;
+		bool done;
+
+		ImageLoad()
+			: image(NULL)
+			, error_type(ERROR_NONE)
+			, rw(NULL)
+			, surface(NULL)
+			, done(false) {
+		}
+	};
+
+	static int runImageLoader(void *data);
+	static void decodeImage(ImageLoad *load);
+	void startImageLoaders();
+	void stopImageLoaders();
+	void waitForImageLoad(Image *image);
+	void finishImageLoad(ImageLoad *load);
+
+	// unfinished loads, in the order they were started
+	std::vector<ImageLoad*> image_loads;
+
+	// guarded by image_load_lock
+	std::deque<ImageLoad*> image_load_queue;
+	bool image_loaders_quit;
+
+	std::vector<SDL_Thread*> image_loaders;
+	SDL_mutex *image_load_lock;
+	SDL_cond *image_load_wake;
+	SDL_cond *image_load_done;
+
 	virtual void getWindowSize(short unsigned *screen_w, short unsigned *screen_h) = 0;
 };
 
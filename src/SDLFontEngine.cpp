@@ -78,7 +78,7 @@ SDLFontEngine::SDLFontEngine() : FontEngine(), active_font(NULL) {
 					style->ptsize = Parse::popFirstInt(infile.val);
 					style->blend = Parse::toBool(Parse::popFirstString(infile.val));
 
-					style->ttfont = TTF_OpenFont(mods->locate("fonts/" + style->path).c_str(), style->ptsize);
+					style->ttfont = TTF_OpenFontRW(mods->openRW(mods->locate("fonts/" + style->path)), 1, style->ptsize);
 					if(style->ttfont == NULL) {
 						Utils::logError("FontEngine: TTF_OpenFont: %s", TTF_GetError());
 					}
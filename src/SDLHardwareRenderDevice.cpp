@@ -45,6 +45,10 @@ SDLHardwareImage::SDLHardwareImage(RenderDevice *_device, SDL_Renderer *_rendere
 }
 
 SDLHardwareImage::~SDLHardwareImage() {
+	// queued draws might still be using this texture
+	if (surface && device)
+		static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
+
 	if (surface)
 		SDL_DestroyTexture(surface);
 	if (pixel_batch_surface)
@@ -66,6 +70,7 @@ int SDLHardwareImage::getHeight() const {
 void SDLHardwareImage::fillWithColor(const Color& color) {
 	if (!surface) return;
 
+	static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
 	SDL_SetRenderTarget(renderer, surface);
 	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 	SDL_SetRenderDrawColor(renderer, color.r, color.g , color.b, color.a);
@@ -120,6 +125,7 @@ void SDLHardwareImage::drawPixel(int x, int y, const Color& color) {
 		}
 	}
 	else {
+		static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
 		SDL_SetRenderTarget(renderer, surface);
 		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 		SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
@@ -129,6 +135,7 @@ void SDLHardwareImage::drawPixel(int x, int y, const Color& color) {
 }
 
 void SDLHardwareImage::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
+	static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
 	SDL_SetRenderTarget(renderer, surface);
 	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
@@ -173,6 +180,7 @@ void SDLHardwareImage::endPixelBatch() {
 	SDL_Texture *pixel_batch_texture = SDL_CreateTextureFromSurface(renderer, pixel_batch_surface);
 
 	if (pixel_batch_texture) {
+		static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
 		SDL_SetRenderTarget(renderer, surface);
 		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 		SDL_RenderCopy(renderer, pixel_batch_texture, NULL, NULL);
@@ -196,6 +204,7 @@ Image* SDLHardwareImage::resize(int width, int height) {
 
 	if (scaled->surface != NULL) {
 		// copy the source texture to the new texture, stretching it in the process
+		static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
 		SDL_SetRenderTarget(renderer, scaled->surface);
 		SDL_RenderCopyEx(renderer, surface, NULL, NULL, 0, NULL, SDL_FLIP_NONE);
 		SDL_SetRenderTarget(renderer, NULL);
@@ -218,6 +227,9 @@ SDLHardwareRenderDevice::SDLHardwareRenderDevice()
 	, titlebar_icon(NULL)
 	, title(NULL)
 	, background_color(0,0,0,0)
+	, batch_texture(NULL)
+	, batch_blend_mode(SDL_BLENDMODE_BLEND)
+	, batch_alpha_mod(255)
 {
 	Utils::logInfo("Using Render Device: SDLHardwareRenderDevice (hardware, SDL 2, %s)", SDL_GetCurrentVideoDriver());
 
@@ -371,23 +383,15 @@ void SDLHardwareRenderDevice::createContextError() {
 int SDLHardwareRenderDevice::render(Renderable& r, Rect& dest) {
 	dest.w = r.src.w;
 	dest.h = r.src.h;
-    SDL_Rect src = r.src;
-    SDL_Rect _dest = dest;
-	SDL_SetRenderTarget(renderer, texture);
 
 	SDL_Texture *surface = static_cast<SDLHardwareImage *>(r.image)->surface;
+	if (!surface)
+		return -1;
 
-	if (r.blend_mode == Renderable::BLEND_ADD) {
-		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_ADD);
-	}
-	else { // Renderable::BLEND_NORMAL
-		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
-	}
-
-	SDL_SetTextureColorMod(surface, r.color_mod.r, r.color_mod.g, r.color_mod.b);
-	SDL_SetTextureAlphaMod(surface, r.alpha_mod);
+	SDL_BlendMode blend_mode = (r.blend_mode == Renderable::BLEND_ADD) ? SDL_BLENDMODE_ADD : SDL_BLENDMODE_BLEND;
 
-	return SDL_RenderCopy(renderer, surface, &src, &_dest);
+	addToBatch(surface, blend_mode, r.color_mod, r.alpha_mod, r.src, dest);
+	return 0;
 }
 
 int SDLHardwareRenderDevice::render(Sprite *r) {
@@ -414,21 +418,143 @@ int SDLHardwareRenderDevice::render(Sprite *r) {
 	m_dest.w = m_clip.w;
 	m_dest.h = m_clip.h;
 
-    SDL_Rect src = m_clip;
-    SDL_Rect dest = m_dest;
+	SDL_Texture *surface = static_cast<SDLHardwareImage *>(r->getGraphics())->surface;
+	if (!surface)
+		return -1;
+
+	// sprites keep whatever blend mode the texture already has
+	SDL_BlendMode blend_mode = SDL_BLENDMODE_BLEND;
+	if (surface == batch_texture)
+		blend_mode = batch_blend_mode;
+	else
+		SDL_GetTextureBlendMode(surface, &blend_mode);
+
+	addToBatch(surface, blend_mode, r->color_mod, r->alpha_mod, m_clip, m_dest);
+	return 0;
+}
+
+/**
+ * Queue a copy of src to dest on the screen
+ * The queue is flushed when the texture or blend mode changes (or the modulation, without SDL_RenderGeometry), so draw order is preserved
+ */
+void SDLHardwareRenderDevice::addToBatch(SDL_Texture* surface, SDL_BlendMode blend_mode, const Color& color_mod, Uint8 alpha_mod, SDL_Rect src, SDL_Rect dest) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// modulation is stored in the vertices, so sprites with different tints can share a batch
+	if (surface != batch_texture || blend_mode != batch_blend_mode)
+#else
+	if (surface != batch_texture || blend_mode != batch_blend_mode || alpha_mod != batch_alpha_mod ||
+	    color_mod.r != batch_color_mod.r || color_mod.g != batch_color_mod.g || color_mod.b != batch_color_mod.b)
+#endif
+	{
+		flushBatch();
+		batch_texture = surface;
+		batch_blend_mode = blend_mode;
+		batch_color_mod = color_mod;
+		batch_alpha_mod = alpha_mod;
+
+#if !SDL_VERSION_ATLEAST(2, 0, 18)
+		SDL_SetRenderTarget(renderer, texture);
+		SDL_SetTextureBlendMode(batch_texture, batch_blend_mode);
+		SDL_SetTextureColorMod(batch_texture, batch_color_mod.r, batch_color_mod.g, batch_color_mod.b);
+		SDL_SetTextureAlphaMod(batch_texture, batch_alpha_mod);
+#endif
+	}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	int tex_w, tex_h;
+	if (SDL_QueryTexture(surface, NULL, NULL, &tex_w, &tex_h) != 0 || tex_w <= 0 || tex_h <= 0)
+		return;
+
+	// SDL_RenderCopy() clips the source rect to the texture, so do the same here
+	if (src.x < 0) {
+		src.w += src.x;
+		dest.x -= src.x;
+		src.x = 0;
+	}
+	if (src.y < 0) {
+		src.h += src.y;
+		dest.y -= src.y;
+		src.y = 0;
+	}
+	if (src.x + src.w > tex_w)
+		src.w = tex_w - src.x;
+	if (src.y + src.h > tex_h)
+		src.h = tex_h - src.y;
+
+	if (src.w <= 0 || src.h <= 0)
+		return;
+
+	dest.w = src.w;
+	dest.h = src.h;
+
+	float u0 = static_cast<float>(src.x) / static_cast<float>(tex_w);
+	float v0 = static_cast<float>(src.y) / static_cast<float>(tex_h);
+	float u1 = static_cast<float>(src.x + src.w) / static_cast<float>(tex_w);
+	float v1 = static_cast<float>(src.y + src.h) / static_cast<float>(tex_h);
+
+	float x0 = static_cast<float>(dest.x);
+	float y0 = static_cast<float>(dest.y);
+	float x1 = static_cast<float>(dest.x + dest.w);
+	float y1 = static_cast<float>(dest.y + dest.h);
+
+	// SDL_RenderGeometry() only documents vertex colors, so the modulation goes in the vertices
+	SDL_Vertex v;
+	v.color.r = color_mod.r;
+	v.color.g = color_mod.g;
+	v.color.b = color_mod.b;
+	v.color.a = alpha_mod;
+
+	int first = static_cast<int>(batch_vertices.size());
+
+	v.position.x = x0; v.position.y = y0; v.tex_coord.x = u0; v.tex_coord.y = v0;
+	batch_vertices.push_back(v);
+	v.position.x = x1; v.position.y = y0; v.tex_coord.x = u1; v.tex_coord.y = v0;
+	batch_vertices.push_back(v);
+	v.position.x = x1; v.position.y = y1; v.tex_coord.x = u1; v.tex_coord.y = v1;
+	batch_vertices.push_back(v);
+	v.position.x = x0; v.position.y = y1; v.tex_coord.x = u0; v.tex_coord.y = v1;
+	batch_vertices.push_back(v);
+
+	batch_indices.push_back(first);
+	batch_indices.push_back(first + 1);
+	batch_indices.push_back(first + 2);
+	batch_indices.push_back(first);
+	batch_indices.push_back(first + 2);
+	batch_indices.push_back(first + 3);
+#else
+	// no geometry support, so draw right away; state changes are still skipped for consecutive draws
+	SDL_RenderCopy(renderer, surface, &src, &dest);
+#endif
+}
+
+void SDLHardwareRenderDevice::flushBatch() {
+	if (!batch_texture)
+		return;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
 	SDL_SetRenderTarget(renderer, texture);
+	SDL_SetTextureBlendMode(batch_texture, batch_blend_mode);
 
-	SDL_Texture *surface = static_cast<SDLHardwareImage *>(r->getGraphics())->surface;
-	SDL_SetTextureColorMod(surface, r->color_mod.r, r->color_mod.g, r->color_mod.b);
-	SDL_SetTextureAlphaMod(surface, r->alpha_mod);
+	// the vertex colors hold the modulation; the texture's own modulation would be applied on top of it
+	SDL_SetTextureColorMod(batch_texture, 255, 255, 255);
+	SDL_SetTextureAlphaMod(batch_texture, 255);
 
-	return SDL_RenderCopy(renderer, static_cast<SDLHardwareImage *>(r->getGraphics())->surface, &src, &dest);
+	if (!batch_indices.empty()) {
+		SDL_RenderGeometry(renderer, batch_texture, &batch_vertices[0], static_cast<int>(batch_vertices.size()), &batch_indices[0], static_cast<int>(batch_indices.size()));
+	}
+	batch_vertices.clear();
+	batch_indices.clear();
+#endif
+
+	batch_texture = NULL;
 }
 
 int SDLHardwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) {
 	if (!src_image || !dest_image)
 		return -1;
 
+	flushBatch();
+
 	if (SDL_SetRenderTarget(renderer, static_cast<SDLHardwareImage *>(dest_image)->surface) != 0)
 		return -1;
 
@@ -443,6 +569,36 @@ int SDLHardwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* d
 	return 0;
 }
 
+int SDLHardwareRenderDevice::copyToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) {
+	if (!src_image || !dest_image)
+		return -1;
+
+	SDL_Texture *surface = static_cast<SDLHardwareImage *>(src_image)->surface;
+	if (!surface)
+		return -1;
+
+	flushBatch();
+
+	// temporarily disable blending and modulation so that the pixels are copied as-is
+	SDL_BlendMode blend_mode;
+	Uint8 r, g, b, a;
+	SDL_GetTextureBlendMode(surface, &blend_mode);
+	SDL_GetTextureColorMod(surface, &r, &g, &b);
+	SDL_GetTextureAlphaMod(surface, &a);
+
+	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_NONE);
+	SDL_SetTextureColorMod(surface, 255, 255, 255);
+	SDL_SetTextureAlphaMod(surface, 255);
+
+	int ret = renderToImage(src_image, src, dest_image, dest);
+
+	SDL_SetTextureBlendMode(surface, blend_mode);
+	SDL_SetTextureColorMod(surface, r, g, b);
+	SDL_SetTextureAlphaMod(surface, a);
+
+	return ret;
+}
+
 Image * SDLHardwareRenderDevice::renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended) {
 	SDLHardwareImage *image = new SDLHardwareImage(this, renderer);
 
@@ -466,16 +622,19 @@ Image * SDLHardwareRenderDevice::renderTextToImage(FontStyle* font_style, const
 }
 
 void SDLHardwareRenderDevice::drawPixel(int x, int y, const Color& color) {
+	flushBatch();
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 	SDL_RenderDrawPoint(renderer, x, y);
 }
 
 void SDLHardwareRenderDevice::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
+	flushBatch();
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 	SDL_RenderDrawLine(renderer, x0, y0, x1, y1);
 }
 
 void SDLHardwareRenderDevice::drawRectangle(const Point& p0, const Point& p1, const Color& color) {
+	flushBatch();
 	SDL_Rect r;
 	r.x = p0.x;
 	r.y = p0.y;
@@ -486,6 +645,7 @@ void SDLHardwareRenderDevice::drawRectangle(const Point& p0, const Point& p1, co
 }
 
 void SDLHardwareRenderDevice::blankScreen() {
+	flushBatch();
 	SDL_SetRenderDrawColor(renderer, background_color.r, background_color.g, background_color.b, background_color.a);
 	SDL_SetRenderTarget(renderer, NULL);
 	SDL_RenderClear(renderer);
@@ -495,6 +655,7 @@ void SDLHardwareRenderDevice::blankScreen() {
 }
 
 void SDLHardwareRenderDevice::commitFrame() {
+	flushBatch();
 	SDL_SetRenderTarget(renderer, NULL);
 	SDL_RenderCopy(renderer, texture, NULL, NULL);
 	SDL_RenderPresent(renderer);
@@ -504,6 +665,9 @@ void SDLHardwareRenderDevice::commitFrame() {
 }
 
 void SDLHardwareRenderDevice::destroyContext() {
+	// finish images that are still loading, so that they are released with the rest of the cache
+	waitForImageLoads();
+	flushBatch();
 	resetGamma();
 
 	// we need to free all loaded graphics as they may be tied to the current context
@@ -552,6 +716,7 @@ Image *SDLHardwareRenderDevice::createImage(int width, int height) {
 			Utils::logError("SDLHardwareRenderDevice: SDL_CreateTexture failed: %s", SDL_GetError());
 		}
 		else {
+				flushBatch();
 				SDL_SetRenderTarget(renderer, image->surface);
 				SDL_SetTextureBlendMode(image->surface, SDL_BLENDMODE_BLEND);
 				SDL_SetRenderDrawColor(renderer, 0,0,0,0);
@@ -582,7 +747,7 @@ void SDLHardwareRenderDevice::updateTitleBar() {
 	if (!window) return;
 
 	title = Utils::strdup(msg->get(eset->misc.window_title));
-	titlebar_icon = IMG_Load(mods->locate("images/logo/icon.png").c_str());
+	titlebar_icon = IMG_Load_RW(mods->openRW(mods->locate("images/logo/icon.png")), 1);
 
 	if (title) SDL_SetWindowTitle(window, title);
 	if (titlebar_icon) SDL_SetWindowIcon(window, titlebar_icon);
@@ -598,7 +763,13 @@ Image *SDLHardwareRenderDevice::loadImage(const std::string& filename, int error
 	SDLHardwareImage *image = new SDLHardwareImage(this, renderer);
 	if (!image) return NULL;
 
-	image->surface = IMG_LoadTexture(renderer, mods->locate(filename).c_str());
+	SDL_Surface *preloaded = takePreloadedImage(filename);
+	if (preloaded) {
+		setImageSurface(image, preloaded, filename);
+	}
+	else {
+		image->surface = IMG_LoadTexture_RW(renderer, mods->openRW(mods->locate(filename)), 1);
+	}
 
 	if(image->surface == NULL) {
 		delete image;
@@ -619,6 +790,15 @@ Image *SDLHardwareRenderDevice::loadImage(const std::string& filename, int error
 	return image;
 }
 
+Image *SDLHardwareRenderDevice::createEmptyImage() {
+	return new SDLHardwareImage(this, renderer);
+}
+
+void SDLHardwareRenderDevice::setImageSurface(Image *image, SDL_Surface *surface, const std::string&) {
+	static_cast<SDLHardwareImage *>(image)->surface = SDL_CreateTextureFromSurface(renderer, surface);
+	SDL_FreeSurface(surface);
+}
+
 void SDLHardwareRenderDevice::getWindowSize(short unsigned *screen_w, short unsigned *screen_h) {
 	int w,h;
 	SDL_GetWindowSize(window, &w, &h);
@@ -627,6 +807,7 @@ void SDLHardwareRenderDevice::getWindowSize(short unsigned *screen_w, short unsi
 }
 
 void SDLHardwareRenderDevice::windowResize() {
+	flushBatch();
 	windowResizeInternal();
 
 	SDL_RenderSetLogicalSize(renderer, settings->view_w, settings->view_h);
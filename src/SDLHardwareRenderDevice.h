@@ -65,6 +65,7 @@ public:
 	virtual int render(Renderable& r, Rect& dest);
 	virtual int render(Sprite* r);
 	virtual int renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest);
+	virtual int copyToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest);
 
 	Image *renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended);
 	void drawPixel(int x, int y, const Color& color);
@@ -83,12 +84,18 @@ public:
 
 	Image* loadImage(const std::string& filename, int error_type);
 
+	// submits queued draws; must be called before changing the render target or any texture state
+	void flushBatch();
+
 protected:
 	int createContextInternal();
 	void createContextError();
+	Image *createEmptyImage();
+	void setImageSurface(Image *image, SDL_Surface *surface, const std::string& filename);
 
 private:
 	void getWindowSize(short unsigned *screen_w, short unsigned *screen_h);
+	void addToBatch(SDL_Texture* surface, SDL_BlendMode blend_mode, const Color& color_mod, Uint8 alpha_mod, SDL_Rect src, SDL_Rect dest);
 
 	SDL_Window *window;
 	SDL_Renderer *renderer;
@@ -96,6 +103,16 @@ private:
 	SDL_Surface* titlebar_icon;
 	char* title;
 	Color background_color;
+
+	// consecutive draws that share a texture, blend mode and modulation are drawn with a single SDL_RenderGeometry() call
+	SDL_Texture* batch_texture;
+	SDL_BlendMode batch_blend_mode;
+	Color batch_color_mod;
+	Uint8 batch_alpha_mod;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	std::vector<SDL_Vertex> batch_vertices;
+	std::vector<int> batch_indices;
+#endif
 };
 
 #endif
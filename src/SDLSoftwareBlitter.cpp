@@ -0,0 +1,460 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "SDLSoftwareBlitter.h"
+#include "Utils.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLITTER_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define BLITTER_HAS_NEON
+#include <arm_neon.h>
+#endif
+
+// the indices of the modulation values passed to the row functions
+#define MOD_R 0
+#define MOD_G 1
+#define MOD_B 2
+#define MOD_A 3
+
+namespace {
+
+/**
+ * x / 255, rounded down. Exact for 0 <= x <= 255*255
+ */
+inline Uint32 div255(Uint32 x) {
+	return (x + 1 + (x >> 8)) >> 8;
+}
+
+#ifdef BLITTER_HAS_SSE2
+inline __m128i div255SSE2(__m128i x) {
+	const __m128i one = _mm_set1_epi16(1);
+	return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, one), _mm_srli_epi16(x, 8)), 8);
+}
+
+/**
+ * Applies modulation to two unpacked pixels and premultiplies their color by alpha
+ * The alpha of each pixel is returned in all four of its lanes
+ */
+inline __m128i premultiplySSE2(__m128i s, __m128i mod, __m128i *alpha) {
+	const __m128i rgb_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+	const __m128i alpha_lane = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+	s = div255SSE2(_mm_mullo_epi16(s, mod));
+
+	__m128i a = _mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3));
+	a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+	*alpha = a;
+
+	// the alpha lane is multiplied by 255 so that it stays the same
+	return div255SSE2(_mm_mullo_epi16(s, _mm_or_si128(_mm_and_si128(a, rgb_mask), alpha_lane)));
+}
+
+void blendRowSSE2(const Uint32 *src, Uint32 *dest, int width, const Uint8 *mod) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(255);
+	const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xff000000));
+	const __m128i mod16 = _mm_set_epi16(mod[MOD_A], mod[MOD_R], mod[MOD_G], mod[MOD_B], mod[MOD_A], mod[MOD_R], mod[MOD_G], mod[MOD_B]);
+
+	int i = 0;
+	for (; i + 4 <= width; i += 4) {
+		const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+		// skip fully transparent pixels
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), zero)) == 0xffff)
+			continue;
+
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i));
+
+		__m128i a_lo, a_hi;
+		const __m128i s_lo = premultiplySSE2(_mm_unpacklo_epi8(s, zero), mod16, &a_lo);
+		const __m128i s_hi = premultiplySSE2(_mm_unpackhi_epi8(s, zero), mod16, &a_hi);
+
+		const __m128i d_lo = _mm_add_epi16(s_lo, div255SSE2(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(max, a_lo))));
+		const __m128i d_hi = _mm_add_epi16(s_hi, div255SSE2(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(max, a_hi))));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(d_lo, d_hi));
+	}
+
+	SDLSoftwareBlitter::blendRowScalar(src + i, dest + i, width - i, mod);
+}
+
+void addRowSSE2(const Uint32 *src, Uint32 *dest, int width, const Uint8 *mod) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xff000000));
+	const __m128i mod16 = _mm_set_epi16(mod[MOD_A], mod[MOD_R], mod[MOD_G], mod[MOD_B], mod[MOD_A], mod[MOD_R], mod[MOD_G], mod[MOD_B]);
+
+	int i = 0;
+	for (; i + 4 <= width; i += 4) {
+		const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+		// skip fully transparent pixels
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), zero)) == 0xffff)
+			continue;
+
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i));
+
+		__m128i a_lo, a_hi;
+		const __m128i s_lo = premultiplySSE2(_mm_unpacklo_epi8(s, zero), mod16, &a_lo);
+		const __m128i s_hi = premultiplySSE2(_mm_unpackhi_epi8(s, zero), mod16, &a_hi);
+
+		// the destination alpha is not changed by additive blending
+		const __m128i s_rgb = _mm_andnot_si128(alpha_mask, _mm_packus_epi16(s_lo, s_hi));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_adds_epu8(d, s_rgb));
+	}
+
+	SDLSoftwareBlitter::addRowScalar(src + i, dest + i, width - i, mod);
+}
+#endif // BLITTER_HAS_SSE2
+
+#ifdef BLITTER_HAS_NEON
+inline uint8x8_t mul255NEON(uint8x8_t a, uint8x8_t b) {
+	const uint16x8_t x = vmull_u8(a, b);
+	const uint16x8_t one = vdupq_n_u16(1);
+	return vmovn_u16(vshrq_n_u16(vaddq_u16(vaddq_u16(x, one), vshrq_n_u16(x, 8)), 8));
+}
+
+/**
+ * Applies modulation to eight deinterleaved pixels and premultiplies their color by alpha
+ */
+inline uint8x8x4_t premultiplyNEON(uint8x8x4_t s, const Uint8 *mod) {
+	s.val[3] = mul255NEON(s.val[3], vdup_n_u8(mod[MOD_A]));
+	s.val[0] = mul255NEON(mul255NEON(s.val[0], vdup_n_u8(mod[MOD_B])), s.val[3]);
+	s.val[1] = mul255NEON(mul255NEON(s.val[1], vdup_n_u8(mod[MOD_G])), s.val[3]);
+	s.val[2] = mul255NEON(mul255NEON(s.val[2], vdup_n_u8(mod[MOD_R])), s.val[3]);
+	return s;
+}
+
+void blendRowNEON(const Uint32 *src, Uint32 *dest, int width, const Uint8 *mod) {
+	int i = 0;
+	for (; i + 8 <= width; i += 8) {
+		// channels are loaded in memory order: B, G, R, A
+		const uint8x8x4_t s = premultiplyNEON(vld4_u8(reinterpret_cast<const uint8_t*>(src + i)), mod);
+		uint8x8x4_t d = vld4_u8(reinterpret_cast<const uint8_t*>(dest + i));
+
+		const uint8x8_t inv = vsub_u8(vdup_n_u8(255), s.val[3]);
+		for (int c = 0; c < 4; ++c) {
+			d.val[c] = vadd_u8(s.val[c], mul255NEON(d.val[c], inv));
+		}
+
+		vst4_u8(reinterpret_cast<uint8_t*>(dest + i), d);
+	}
+
+	SDLSoftwareBlitter::blendRowScalar(src + i, dest + i, width - i, mod);
+}
+
+void addRowNEON(const Uint32 *src, Uint32 *dest, int width, const Uint8 *mod) {
+	int i = 0;
+	for (; i + 8 <= width; i += 8) {
+		const uint8x8x4_t s = premultiplyNEON(vld4_u8(reinterpret_cast<const uint8_t*>(src + i)), mod);
+		uint8x8x4_t d = vld4_u8(reinterpret_cast<const uint8_t*>(dest + i));
+
+		// the destination alpha is not changed by additive blending
+		for (int c = 0; c < 3; ++c) {
+			d.val[c] = vqadd_u8(d.val[c], s.val[c]);
+		}
+
+		vst4_u8(reinterpret_cast<uint8_t*>(dest + i), d);
+	}
+
+	SDLSoftwareBlitter::addRowScalar(src + i, dest + i, width - i, mod);
+}
+#endif // BLITTER_HAS_NEON
+
+} // namespace
+
+SDLSoftwareBlitter::SDLSoftwareBlitter()
+	: type(-1)
+	, impl(IMPL_NONE)
+	, blend_row(NULL)
+	, add_row(NULL)
+{
+}
+
+void SDLSoftwareBlitter::init(int _type) {
+	type = _type;
+	impl = IMPL_NONE;
+	blend_row = NULL;
+	add_row = NULL;
+
+	if (type == BLITTER_SDL)
+		return;
+
+	if (type == BLITTER_SIMD) {
+#ifdef BLITTER_HAS_SSE2
+		if (SDL_HasSSE2() && setImplementation(IMPL_SSE2))
+			return;
+#endif
+#ifdef BLITTER_HAS_NEON
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+		if (SDL_HasNEON() && setImplementation(IMPL_NEON))
+			return;
+#else
+		if (setImplementation(IMPL_NEON))
+			return;
+#endif
+#endif
+	}
+
+	setImplementation(IMPL_SCALAR);
+}
+
+int SDLSoftwareBlitter::getType() const {
+	return type;
+}
+
+bool SDLSoftwareBlitter::setImplementation(int _impl) {
+	impl = _impl;
+
+	if (impl == IMPL_SCALAR) {
+		blend_row = &SDLSoftwareBlitter::blendRowScalar;
+		add_row = &SDLSoftwareBlitter::addRowScalar;
+	}
+#ifdef BLITTER_HAS_SSE2
+	else if (impl == IMPL_SSE2) {
+		blend_row = &blendRowSSE2;
+		add_row = &addRowSSE2;
+	}
+#endif
+#ifdef BLITTER_HAS_NEON
+	else if (impl == IMPL_NEON) {
+		blend_row = &blendRowNEON;
+		add_row = &addRowNEON;
+	}
+#endif
+	else {
+		impl = IMPL_NONE;
+		return false;
+	}
+
+	if (impl != IMPL_SCALAR && !verify()) {
+		Utils::logError("SDLSoftwareBlitter: %s output does not match the scalar blitter, so it will not be used.", getImplementationName(impl));
+		impl = IMPL_NONE;
+		blend_row = NULL;
+		add_row = NULL;
+		return false;
+	}
+
+	Utils::logInfo("SDLSoftwareBlitter: Using %s blitter.", getImplementationName(impl));
+	return true;
+}
+
+/**
+ * Compares the output of the current implementation with the scalar implementation
+ * Rows of every length up to a few SIMD widths are used, so that the scalar tail handling is covered as well
+ */
+bool SDLSoftwareBlitter::verify() {
+	const int MAX_WIDTH = 37;
+	const int NUM_MODS = 6;
+	const Uint8 mods[NUM_MODS][4] = {
+		{255, 255, 255, 255},
+		{255, 255, 255, 128},
+		{255, 0, 0, 255},
+		{128, 200, 64, 32},
+		{0, 0, 0, 0},
+		{17, 255, 99, 254}
+	};
+
+	std::vector<Uint32> src(MAX_WIDTH);
+	std::vector<Uint32> dest(MAX_WIDTH);
+	std::vector<Uint32> dest_ref(MAX_WIDTH);
+
+	// a fixed sequence, so that the game's random numbers aren't affected
+	Uint32 seed = 0x2f6b3a1d;
+
+	for (int mode = 0; mode < 2; ++mode) {
+		RowFunc test_row = (mode == 0 ? blend_row : add_row);
+		RowFunc ref_row = (mode == 0 ? &SDLSoftwareBlitter::blendRowScalar : &SDLSoftwareBlitter::addRowScalar);
+
+		for (int m = 0; m < NUM_MODS; ++m) {
+			for (int width = 1; width <= MAX_WIDTH; ++width) {
+				for (int i = 0; i < width; ++i) {
+					seed = seed * 1664525 + 1013904223;
+					src[i] = seed;
+					seed = seed * 1664525 + 1013904223;
+					dest[i] = seed;
+
+					// include runs of fully transparent and fully opaque pixels
+					if ((i / 4) % 3 == 1)
+						src[i] &= 0x00ffffff;
+					else if ((i / 4) % 3 == 2 && i % 2 == 0)
+						src[i] |= 0xff000000;
+				}
+				dest_ref = dest;
+
+				test_row(&src[0], &dest[0], width, mods[m]);
+				ref_row(&src[0], &dest_ref[0], width, mods[m]);
+
+				if (dest != dest_ref)
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool SDLSoftwareBlitter::blit(SDL_Surface *src, const SDL_Rect *src_rect, SDL_Surface *dest, SDL_Rect *dest_rect) {
+	if (impl == IMPL_NONE || !src || !dest || !src_rect || !dest_rect)
+		return false;
+
+	if (src->format->format != SDL_PIXELFORMAT_ARGB8888 || dest->format->format != SDL_PIXELFORMAT_ARGB8888)
+		return false;
+
+	if (SDL_MUSTLOCK(src) || SDL_MUSTLOCK(dest))
+		return false;
+
+	Uint32 color_key;
+	if (SDL_GetColorKey(src, &color_key) == 0)
+		return false;
+
+	SDL_BlendMode blend_mode;
+	SDL_GetSurfaceBlendMode(src, &blend_mode);
+
+	RowFunc row = NULL;
+	if (blend_mode == SDL_BLENDMODE_BLEND)
+		row = blend_row;
+	else if (blend_mode == SDL_BLENDMODE_ADD)
+		row = add_row;
+	else
+		return false;
+
+	Uint8 mod[4];
+	SDL_GetSurfaceColorMod(src, &mod[MOD_R], &mod[MOD_G], &mod[MOD_B]);
+	SDL_GetSurfaceAlphaMod(src, &mod[MOD_A]);
+
+	// clip the same way as SDL_BlitSurface()
+	int src_x = src_rect->x;
+	int src_y = src_rect->y;
+	int w = src_rect->w;
+	int h = src_rect->h;
+
+	if (src_x < 0) {
+		w += src_x;
+		dest_rect->x -= src_x;
+		src_x = 0;
+	}
+	w = std::min(w, src->w - src_x);
+
+	if (src_y < 0) {
+		h += src_y;
+		dest_rect->y -= src_y;
+		src_y = 0;
+	}
+	h = std::min(h, src->h - src_y);
+
+	const SDL_Rect& clip = dest->clip_rect;
+	int dx = clip.x - dest_rect->x;
+	if (dx > 0) {
+		w -= dx;
+		dest_rect->x += dx;
+		src_x += dx;
+	}
+	dx = dest_rect->x + w - clip.x - clip.w;
+	if (dx > 0)
+		w -= dx;
+
+	int dy = clip.y - dest_rect->y;
+	if (dy > 0) {
+		h -= dy;
+		dest_rect->y += dy;
+		src_y += dy;
+	}
+	dy = dest_rect->y + h - clip.y - clip.h;
+	if (dy > 0)
+		h -= dy;
+
+	if (w <= 0 || h <= 0) {
+		dest_rect->w = 0;
+		dest_rect->h = 0;
+		return true;
+	}
+
+	dest_rect->w = w;
+	dest_rect->h = h;
+
+	const Uint8 *src_pixels = static_cast<const Uint8*>(src->pixels) + src_y * src->pitch + src_x * 4;
+	Uint8 *dest_pixels = static_cast<Uint8*>(dest->pixels) + dest_rect->y * dest->pitch + dest_rect->x * 4;
+
+	for (int y = 0; y < h; ++y) {
+		row(reinterpret_cast<const Uint32*>(src_pixels), reinterpret_cast<Uint32*>(dest_pixels), w, mod);
+		src_pixels += src->pitch;
+		dest_pixels += dest->pitch;
+	}
+
+	return true;
+}
+
+/**
+ * The reference implementation, which uses the same math as SDL's generic blitter
+ */
+void SDLSoftwareBlitter::blendRowScalar(const Uint32 *src, Uint32 *dest, int width, const Uint8 *mod) {
+	for (int i = 0; i < width; ++i) {
+		const Uint32 s = src[i];
+		const Uint32 sa = div255((s >> 24) * mod[MOD_A]);
+		if (sa == 0)
+			continue;
+
+		const Uint32 sr = div255(div255(((s >> 16) & 0xff) * mod[MOD_R]) * sa);
+		const Uint32 sg = div255(div255(((s >> 8) & 0xff) * mod[MOD_G]) * sa);
+		const Uint32 sb = div255(div255((s & 0xff) * mod[MOD_B]) * sa);
+
+		const Uint32 d = dest[i];
+		const Uint32 inv = 255 - sa;
+		const Uint32 da = sa + div255((d >> 24) * inv);
+		const Uint32 dr = sr + div255(((d >> 16) & 0xff) * inv);
+		const Uint32 dg = sg + div255(((d >> 8) & 0xff) * inv);
+		const Uint32 db = sb + div255((d & 0xff) * inv);
+
+		dest[i] = (da << 24) | (dr << 16) | (dg << 8) | db;
+	}
+}
+
+void SDLSoftwareBlitter::addRowScalar(const Uint32 *src, Uint32 *dest, int width, const Uint8 *mod) {
+	for (int i = 0; i < width; ++i) {
+		const Uint32 s = src[i];
+		const Uint32 sa = div255((s >> 24) * mod[MOD_A]);
+		if (sa == 0)
+			continue;
+
+		const Uint32 sr = div255(div255(((s >> 16) & 0xff) * mod[MOD_R]) * sa);
+		const Uint32 sg = div255(div255(((s >> 8) & 0xff) * mod[MOD_G]) * sa);
+		const Uint32 sb = div255(div255((s & 0xff) * mod[MOD_B]) * sa);
+
+		// the destination alpha is not changed by additive blending
+		const Uint32 d = dest[i];
+		const Uint32 dr = std::min<Uint32>(255, sr + ((d >> 16) & 0xff));
+		const Uint32 dg = std::min<Uint32>(255, sg + ((d >> 8) & 0xff));
+		const Uint32 db = std::min<Uint32>(255, sb + (d & 0xff));
+
+		dest[i] = (d & 0xff000000) | (dr << 16) | (dg << 8) | db;
+	}
+}
+
+const char* SDLSoftwareBlitter::getImplementationName(int _impl) {
+	if (_impl == IMPL_SCALAR)
+		return "scalar";
+	else if (_impl == IMPL_SSE2)
+		return "SSE2";
+	else if (_impl == IMPL_NEON)
+		return "NEON";
+	return "none";
+}
@@ -0,0 +1,78 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class SDLSoftwareBlitter
+ *
+ * Alpha and additive blending between ARGB8888 surfaces, with color and alpha modulation.
+ * SDL_BlitSurface() falls back to a slow generic path when modulation is used, which is
+ * the common case for tinted entities and effects.
+ *
+ * The blending math is the same as SDL's generic blitter. The scalar implementation is the
+ * reference; the SSE2 and NEON implementations are checked against it when they are selected,
+ * and are not used if their output differs.
+ */
+
+#ifndef SDL_SOFTWARE_BLITTER_H
+#define SDL_SOFTWARE_BLITTER_H
+
+#include "CommonIncludes.h"
+
+class SDLSoftwareBlitter {
+public:
+	enum {
+		BLITTER_SDL = 0, // use SDL_BlitSurface()
+		BLITTER_SCALAR = 1,
+		BLITTER_SIMD = 2 // the best available of the types below
+	};
+
+	enum {
+		IMPL_NONE = 0,
+		IMPL_SCALAR = 1,
+		IMPL_SSE2 = 2,
+		IMPL_NEON = 3
+	};
+
+	SDLSoftwareBlitter();
+
+	// picks an implementation for one of the BLITTER_* types
+	void init(int type);
+	int getType() const;
+
+	// behaves like SDL_BlitSurface(), using the blend mode and modulation of the source surface
+	// returns false without drawing if the surfaces aren't supported, in which case SDL_BlitSurface() should be used instead
+	bool blit(SDL_Surface *src, const SDL_Rect *src_rect, SDL_Surface *dest, SDL_Rect *dest_rect);
+
+	// reference implementations; mod is {r, g, b, a}
+	static void blendRowScalar(const Uint32 *src, Uint32 *dest, int width, const Uint8 *mod);
+	static void addRowScalar(const Uint32 *src, Uint32 *dest, int width, const Uint8 *mod);
+
+private:
+	typedef void (*RowFunc)(const Uint32 *src, Uint32 *dest, int width, const Uint8 *mod);
+
+	bool setImplementation(int impl);
+	bool verify();
+
+	static const char* getImplementationName(int impl);
+
+	int type;
+	int impl;
+	RowFunc blend_row;
+	RowFunc add_row;
+};
+
+#endif // SDL_SOFTWARE_BLITTER_H
@@ -38,9 +38,12 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "SDLSoftwareRenderDevice.h"
 #include "SDLFontEngine.h"
 
+unsigned long SDLSoftwareImage::next_version = 0;
+
 SDLSoftwareImage::SDLSoftwareImage(RenderDevice *_device)
 	: Image(_device)
-	, surface(NULL) {
+	, surface(NULL)
+	, version(++next_version) {
 }
 
 SDLSoftwareImage::~SDLSoftwareImage() {
@@ -60,6 +63,7 @@ void SDLSoftwareImage::fillWithColor(const Color& color) {
 	if (!surface) return;
 
 	SDL_FillRect(surface, NULL, MapRGBA(color.r, color.g, color.b, color.a));
+	setModified();
 }
 
 /*
@@ -109,6 +113,7 @@ void SDLSoftwareImage::drawPixel(int x, int y, const Color& color) {
 	if (SDL_MUSTLOCK(surface)) {
 		SDL_UnlockSurface(surface);
 	}
+	setModified();
 }
 
 void SDLSoftwareImage::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
@@ -141,6 +146,10 @@ void SDLSoftwareImage::drawLine(int x0, int y0, int x1, int y1, const Color& col
 }
 
 
+void SDLSoftwareImage::setModified() {
+	version = ++next_version;
+}
+
 Uint32 SDLSoftwareImage::MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
 	if (!surface) return 0;
 	return SDL_MapRGBA(surface->format, r, g, b, a);
@@ -186,7 +195,9 @@ SDLSoftwareRenderDevice::SDLSoftwareRenderDevice()
 	, texture(NULL)
 	, titlebar_icon(NULL)
 	, title(NULL)
-	, background_color(0) {
+	, background_color(0)
+	, dirty_rect_mode(false)
+	, full_redraw(true) {
 	Utils::logInfo("RenderDevice: Using SDLSoftwareRenderDevice (software, SDL 2, %s)", SDL_GetCurrentVideoDriver());
 
 	fullscreen = settings->fullscreen;
@@ -341,7 +352,17 @@ int SDLSoftwareRenderDevice::render(Renderable& r, Rect& dest) {
 	SDL_SetSurfaceColorMod(surface, r.color_mod.r, r.color_mod.g, r.color_mod.b);
 	SDL_SetSurfaceAlphaMod(surface, r.alpha_mod);
 
-	return SDL_BlitSurface(surface, &src, screen, &_dest);
+	if (dirty_rect_mode) {
+		DrawCommand cmd;
+		cmd.type = DrawCommand::TYPE_IMAGE;
+		cmd.image = static_cast<SDLSoftwareImage *>(r.image);
+		cmd.src = src;
+		cmd.dest = _dest;
+		addDrawCommand(cmd);
+		return 0;
+	}
+
+	return blitToScreen(surface, &src, &_dest);
 }
 
 int SDLSoftwareRenderDevice::render(Sprite *r) {
@@ -360,7 +381,24 @@ int SDLSoftwareRenderDevice::render(Sprite *r) {
 	SDL_SetSurfaceColorMod(surface, r->color_mod.r, r->color_mod.g, r->color_mod.b);
 	SDL_SetSurfaceAlphaMod(surface, r->alpha_mod);
 
-	return SDL_BlitSurface(surface, &src, screen, &dest);
+	if (dirty_rect_mode) {
+		DrawCommand cmd;
+		cmd.type = DrawCommand::TYPE_IMAGE;
+		cmd.image = static_cast<SDLSoftwareImage *>(r->getGraphics());
+		cmd.src = src;
+		cmd.dest = dest;
+		addDrawCommand(cmd);
+		return 0;
+	}
+
+	return blitToScreen(surface, &src, &dest);
+}
+
+int SDLSoftwareRenderDevice::blitToScreen(SDL_Surface *surface, SDL_Rect *src, SDL_Rect *dest) {
+	if (blitter.blit(surface, src, screen, dest))
+		return 0;
+
+	return SDL_BlitSurface(surface, src, screen, dest);
 }
 
 int SDLSoftwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) {
@@ -369,10 +407,38 @@ int SDLSoftwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* d
 	SDL_Rect _src = src;
 	SDL_Rect _dest = dest;
 
+	static_cast<SDLSoftwareImage *>(dest_image)->setModified();
+
 	return SDL_BlitSurface(static_cast<SDLSoftwareImage *>(src_image)->surface, &_src,
 						   static_cast<SDLSoftwareImage *>(dest_image)->surface, &_dest);
 }
 
+int SDLSoftwareRenderDevice::copyToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) {
+	if (!src_image || !dest_image) return -1;
+
+	SDL_Surface *surface = static_cast<SDLSoftwareImage *>(src_image)->surface;
+	if (!surface) return -1;
+
+	// temporarily disable blending and modulation so that the pixels are copied as-is
+	SDL_BlendMode blend_mode;
+	Uint8 r, g, b, a;
+	SDL_GetSurfaceBlendMode(surface, &blend_mode);
+	SDL_GetSurfaceColorMod(surface, &r, &g, &b);
+	SDL_GetSurfaceAlphaMod(surface, &a);
+
+	SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+	SDL_SetSurfaceColorMod(surface, 255, 255, 255);
+	SDL_SetSurfaceAlphaMod(surface, 255);
+
+	int ret = renderToImage(src_image, src, dest_image, dest);
+
+	SDL_SetSurfaceBlendMode(surface, blend_mode);
+	SDL_SetSurfaceColorMod(surface, r, g, b);
+	SDL_SetSurfaceAlphaMod(surface, a);
+
+	return ret;
+}
+
 Image* SDLSoftwareRenderDevice::renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended) {
 	SDLSoftwareImage *image = new SDLSoftwareImage(this);
 	if (!image) return NULL;
@@ -392,6 +458,19 @@ Image* SDLSoftwareRenderDevice::renderTextToImage(FontStyle* font_style, const s
 }
 
 void SDLSoftwareRenderDevice::drawPixel(int x, int y, const Color& color) {
+	if (dirty_rect_mode) {
+		DrawCommand cmd;
+		cmd.type = DrawCommand::TYPE_PIXEL;
+		cmd.color = color;
+		cmd.p0 = cmd.p1 = Point(x, y);
+		addDrawCommand(cmd);
+		return;
+	}
+
+	writePixel(x, y, color);
+}
+
+void SDLSoftwareRenderDevice::writePixel(int x, int y, const Color& color) {
 	Uint32 pixel = MapRGBA(color.r, color.g, color.b, color.a);
 
 	int bpp = screen->format->BytesPerPixel;
@@ -434,6 +513,20 @@ void SDLSoftwareRenderDevice::drawPixel(int x, int y, const Color& color) {
 }
 
 void SDLSoftwareRenderDevice::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
+	if (dirty_rect_mode) {
+		DrawCommand cmd;
+		cmd.type = DrawCommand::TYPE_LINE;
+		cmd.color = color;
+		cmd.p0 = Point(x0, y0);
+		cmd.p1 = Point(x1, y1);
+		addDrawCommand(cmd);
+		return;
+	}
+
+	drawLineClipped(x0, y0, x1, y1, color, NULL);
+}
+
+void SDLSoftwareRenderDevice::drawLineClipped(int x0, int y0, int x1, int y1, const Color& color, const SDL_Rect *clip) {
 	const int dx = abs(x1-x0);
 	const int dy = abs(y1-y0);
 	const int sx = x0 < x1 ? 1 : -1;
@@ -443,7 +536,8 @@ void SDLSoftwareRenderDevice::drawLine(int x0, int y0, int x1, int y1, const Col
 	do {
 		//skip draw if outside screen
 		if (x0 > 0 && y0 > 0 && x0 < settings->view_w && y0 < settings->view_h) {
-			this->drawPixel(x0,y0,color);
+			if (!clip || (x0 >= clip->x && y0 >= clip->y && x0 < clip->x + clip->w && y0 < clip->y + clip->h))
+				writePixel(x0,y0,color);
 		}
 
 		int e2 = 2*err;
@@ -473,12 +567,30 @@ void SDLSoftwareRenderDevice::drawRectangle(const Point& p0, const Point& p1, co
 }
 
 void SDLSoftwareRenderDevice::blankScreen() {
+	if (settings->software_blitter != blitter.getType())
+		blitter.init(settings->software_blitter);
+
+	if (settings->dirty_rects != dirty_rect_mode) {
+		dirty_rect_mode = settings->dirty_rects;
+		clearDrawCommands(draw_commands);
+		clearDrawCommands(prev_draw_commands);
+		full_redraw = true;
+	}
+
+	// in dirty rectangle mode, the screen is only cleared where it gets redrawn
+	if (dirty_rect_mode)
+		return;
+
 	SDL_FillRect(screen, NULL, background_color);
 	return;
 }
 
 void SDLSoftwareRenderDevice::commitFrame() {
-	SDL_UpdateTexture(texture, NULL, screen->pixels, screen->pitch);
+	if (dirty_rect_mode)
+		commitDirtyRects();
+	else
+		SDL_UpdateTexture(texture, NULL, screen->pixels, screen->pitch);
+
 	SDL_RenderClear(renderer);
 	SDL_RenderCopy(renderer, texture, NULL, NULL);
 	SDL_RenderPresent(renderer);
@@ -488,8 +600,14 @@ void SDLSoftwareRenderDevice::commitFrame() {
 }
 
 void SDLSoftwareRenderDevice::destroyContext() {
+	// finish images that are still loading, so that they are released with the rest of the cache
+	waitForImageLoads();
 	resetGamma();
 
+	clearDrawCommands(draw_commands);
+	clearDrawCommands(prev_draw_commands);
+	full_redraw = true;
+
 	// we need to free all loaded graphics as they may be tied to the current context
 	RenderDevice::cacheRemoveAll();
 	reload_graphics = true;
@@ -581,7 +699,7 @@ void SDLSoftwareRenderDevice::updateTitleBar() {
 	if (!window) return;
 
 	title = Utils::strdup(msg->get(eset->misc.window_title));
-	titlebar_icon = IMG_Load(mods->locate("images/logo/icon.png").c_str());
+	titlebar_icon = IMG_Load_RW(mods->openRW(mods->locate("images/logo/icon.png")), 1);
 
 	if (title) SDL_SetWindowTitle(window, title);
 	if (titlebar_icon) SDL_SetWindowIcon(window, titlebar_icon);
@@ -596,7 +714,9 @@ Image *SDLSoftwareRenderDevice::loadImage(const std::string& filename, int error
 	// load image
 	SDLSoftwareImage *image;
 	image = NULL;
-	SDL_Surface *cleanup = IMG_Load(mods->locate(filename).c_str());
+	SDL_Surface *cleanup = takePreloadedImage(filename);
+	if (!cleanup)
+		cleanup = IMG_Load_RW(mods->openRW(mods->locate(filename)), 1);
 	if(!cleanup) {
 		if (error_type != ERROR_NONE)
 			Utils::logError("SDLSoftwareRenderDevice: Couldn't load image: '%s'. %s", filename.c_str(), IMG_GetError());
@@ -611,8 +731,7 @@ Image *SDLSoftwareRenderDevice::loadImage(const std::string& filename, int error
 	}
 	else {
 		image = new SDLSoftwareImage(this);
-		image->surface = SDL_ConvertSurfaceFormat(cleanup, SDL_PIXELFORMAT_ARGB8888, 0);
-		SDL_FreeSurface(cleanup);
+		setImageSurface(image, cleanup, filename);
 	}
 
 	// store image to cache
@@ -620,6 +739,17 @@ Image *SDLSoftwareRenderDevice::loadImage(const std::string& filename, int error
 	return image;
 }
 
+Image *SDLSoftwareRenderDevice::createEmptyImage() {
+	return new SDLSoftwareImage(this);
+}
+
+void SDLSoftwareRenderDevice::setImageSurface(Image *image, SDL_Surface *surface, const std::string&) {
+	SDLSoftwareImage *dest = static_cast<SDLSoftwareImage *>(image);
+	dest->surface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+	dest->setModified();
+	SDL_FreeSurface(surface);
+}
+
 void SDLSoftwareRenderDevice::setSDL_RGBA(Uint32 *rmask, Uint32 *gmask, Uint32 *bmask, Uint32 *amask) {
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 	*rmask = 0xff000000;
@@ -656,10 +786,16 @@ void SDLSoftwareRenderDevice::windowResize() {
 	texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, settings->view_w, settings->view_h);
 
 	settings->updateScreenVars();
+
+	full_redraw = true;
 }
 
 void SDLSoftwareRenderDevice::setBackgroundColor(Color color) {
+	uint32_t prev_color = background_color;
 	background_color = SDL_MapRGBA(screen->format, color.r, color.g, color.b, color.a);
+
+	if (background_color != prev_color)
+		full_redraw = true;
 }
 
 void SDLSoftwareRenderDevice::setFullscreen(bool enable_fullscreen) {
@@ -680,3 +816,188 @@ void SDLSoftwareRenderDevice::setFullscreen(bool enable_fullscreen) {
 		windowResize();
 	}
 }
+
+SDLSoftwareRenderDevice::DrawCommand::DrawCommand()
+	: type(TYPE_IMAGE)
+	, image(NULL)
+	, version(0)
+	, blend_mode(SDL_BLENDMODE_NONE)
+	, alpha_mod(255)
+{
+	src.x = src.y = src.w = src.h = 0;
+	dest = bounds = src;
+}
+
+bool SDLSoftwareRenderDevice::DrawCommand::operator==(const DrawCommand& other) const {
+	if (type != other.type)
+		return false;
+
+	if (type == TYPE_IMAGE) {
+		return image == other.image && version == other.version &&
+		       src.x == other.src.x && src.y == other.src.y && src.w == other.src.w && src.h == other.src.h &&
+		       dest.x == other.dest.x && dest.y == other.dest.y &&
+		       blend_mode == other.blend_mode && alpha_mod == other.alpha_mod &&
+		       color.r == other.color.r && color.g == other.color.g && color.b == other.color.b;
+	}
+
+	return p0.x == other.p0.x && p0.y == other.p0.y && p1.x == other.p1.x && p1.y == other.p1.y &&
+	       color.r == other.color.r && color.g == other.color.g && color.b == other.color.b && color.a == other.color.a;
+}
+
+/**
+ * Fills in the state needed to replay the command and keeps the image alive until the command is dropped
+ */
+void SDLSoftwareRenderDevice::addDrawCommand(DrawCommand& cmd) {
+	SDL_Rect screen_rect;
+	screen_rect.x = 0;
+	screen_rect.y = 0;
+	screen_rect.w = screen->w;
+	screen_rect.h = screen->h;
+
+	if (cmd.type == DrawCommand::TYPE_IMAGE) {
+		if (!cmd.image || !cmd.image->surface)
+			return;
+
+		SDL_Surface *surface = cmd.image->surface;
+		SDL_GetSurfaceBlendMode(surface, &cmd.blend_mode);
+		SDL_GetSurfaceColorMod(surface, &cmd.color.r, &cmd.color.g, &cmd.color.b);
+		SDL_GetSurfaceAlphaMod(surface, &cmd.alpha_mod);
+		cmd.version = cmd.image->version;
+
+		cmd.bounds.x = cmd.dest.x;
+		cmd.bounds.y = cmd.dest.y;
+		cmd.bounds.w = cmd.src.w;
+		cmd.bounds.h = cmd.src.h;
+	}
+	else {
+		cmd.bounds.x = std::min(cmd.p0.x, cmd.p1.x);
+		cmd.bounds.y = std::min(cmd.p0.y, cmd.p1.y);
+		cmd.bounds.w = abs(cmd.p1.x - cmd.p0.x) + 1;
+		cmd.bounds.h = abs(cmd.p1.y - cmd.p0.y) + 1;
+	}
+
+	SDL_Rect clipped;
+	if (!SDL_IntersectRect(&cmd.bounds, &screen_rect, &clipped))
+		return;
+	cmd.bounds = clipped;
+
+	if (cmd.image)
+		cmd.image->ref();
+
+	draw_commands.push_back(cmd);
+}
+
+void SDLSoftwareRenderDevice::replayDrawCommand(const DrawCommand& cmd, const SDL_Rect& clip) {
+	if (cmd.type == DrawCommand::TYPE_IMAGE) {
+		SDL_Surface *surface = cmd.image->surface;
+		SDL_Rect src = cmd.src;
+		SDL_Rect dest = cmd.dest;
+
+		SDL_SetSurfaceBlendMode(surface, cmd.blend_mode);
+		SDL_SetSurfaceColorMod(surface, cmd.color.r, cmd.color.g, cmd.color.b);
+		SDL_SetSurfaceAlphaMod(surface, cmd.alpha_mod);
+		blitToScreen(surface, &src, &dest);
+	}
+	else if (cmd.type == DrawCommand::TYPE_PIXEL) {
+		if (cmd.p0.x >= clip.x && cmd.p0.y >= clip.y && cmd.p0.x < clip.x + clip.w && cmd.p0.y < clip.y + clip.h)
+			writePixel(cmd.p0.x, cmd.p0.y, cmd.color);
+	}
+	else if (cmd.type == DrawCommand::TYPE_LINE) {
+		drawLineClipped(cmd.p0.x, cmd.p0.y, cmd.p1.x, cmd.p1.y, cmd.color, &clip);
+	}
+}
+
+void SDLSoftwareRenderDevice::clearDrawCommands(std::vector<DrawCommand>& commands) {
+	for (size_t i = 0; i < commands.size(); ++i) {
+		if (commands[i].image)
+			commands[i].image->unref();
+	}
+	commands.clear();
+}
+
+/**
+ * Adds an area to the list of dirty rectangles, merging it with any rectangles it overlaps
+ * Falls back to redrawing the whole screen if the list gets too long or covers most of the screen
+ */
+void SDLSoftwareRenderDevice::addDirtyRect(const SDL_Rect& rect) {
+	if (full_redraw || rect.w <= 0 || rect.h <= 0)
+		return;
+
+	SDL_Rect merged = rect;
+	size_t i = 0;
+	while (i < dirty_rects.size()) {
+		if (SDL_HasIntersection(&merged, &dirty_rects[i])) {
+			SDL_UnionRect(&merged, &dirty_rects[i], &merged);
+			dirty_rects[i] = dirty_rects.back();
+			dirty_rects.pop_back();
+
+			// the larger rectangle might overlap ones that were already checked
+			i = 0;
+		}
+		else {
+			++i;
+		}
+	}
+	dirty_rects.push_back(merged);
+
+	int dirty_area = 0;
+	for (i = 0; i < dirty_rects.size(); ++i) {
+		dirty_area += dirty_rects[i].w * dirty_rects[i].h;
+	}
+
+	if (dirty_rects.size() > MAX_DIRTY_RECTS || dirty_area > (screen->w * screen->h * 3) / 4)
+		full_redraw = true;
+}
+
+/**
+ * Redraws and uploads the parts of the screen where this frame's draw list differs from the last frame's
+ */
+void SDLSoftwareRenderDevice::commitDirtyRects() {
+	dirty_rects.clear();
+
+	if (inpt->window_resized)
+		full_redraw = true;
+
+	const size_t count = std::max(draw_commands.size(), prev_draw_commands.size());
+	for (size_t i = 0; i < count && !full_redraw; ++i) {
+		if (i < draw_commands.size() && i < prev_draw_commands.size() && draw_commands[i] == prev_draw_commands[i])
+			continue;
+
+		if (i < draw_commands.size())
+			addDirtyRect(draw_commands[i].bounds);
+		if (i < prev_draw_commands.size())
+			addDirtyRect(prev_draw_commands[i].bounds);
+	}
+
+	if (full_redraw) {
+		SDL_Rect screen_rect;
+		screen_rect.x = 0;
+		screen_rect.y = 0;
+		screen_rect.w = screen->w;
+		screen_rect.h = screen->h;
+
+		dirty_rects.clear();
+		dirty_rects.push_back(screen_rect);
+		full_redraw = false;
+	}
+
+	for (size_t i = 0; i < dirty_rects.size(); ++i) {
+		const SDL_Rect& clip = dirty_rects[i];
+
+		SDL_SetClipRect(screen, &clip);
+		SDL_FillRect(screen, &clip, background_color);
+
+		for (size_t j = 0; j < draw_commands.size(); ++j) {
+			if (SDL_HasIntersection(&draw_commands[j].bounds, &clip))
+				replayDrawCommand(draw_commands[j], clip);
+		}
+
+		SDL_SetClipRect(screen, NULL);
+
+		const Uint8 *pixels = static_cast<const Uint8 *>(screen->pixels) + clip.y * screen->pitch + clip.x * screen->format->BytesPerPixel;
+		SDL_UpdateTexture(texture, &clip, pixels, screen->pitch);
+	}
+
+	clearDrawCommands(prev_draw_commands);
+	prev_draw_commands.swap(draw_commands);
+}
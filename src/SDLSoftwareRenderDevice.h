@@ -22,6 +22,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define SDLSOFTWARERENDERDEVICE_H
 
 #include "RenderDevice.h"
+#include "SDLSoftwareBlitter.h"
 
 /** Provide rendering device using SDL_BlitSurface backend.
  *
@@ -31,6 +32,10 @@ FLARE.  If not, see http://www.gnu.org/licenses/
  * As this is for the FLARE engine, the implementation uses the engine's
  * global settings context, which is included by the interface.
  *
+ * When the dirty_rects setting is enabled, draw calls to the screen are recorded
+ * instead of being blitted right away. On commitFrame(), the draw list is compared
+ * with the previous frame's, and only the areas that changed are redrawn and uploaded.
+ *
  * @class SDLSoftwareRenderDevice
  * @see RenderDevice
  * @author Kurt Rinnert
@@ -51,10 +56,18 @@ public:
 	void drawLine(int x0, int y0, int x1, int y1, const Color& color);
 	Image* resize(int width, int height);
 
+	// must be called whenever the pixels of the surface are changed
+	void setModified();
+
 	SDL_Surface *surface;
 
+	// unique for each image and each change to its pixels
+	unsigned long version;
+
 private:
 	Uint32 MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+
+	static unsigned long next_version;
 };
 
 class SDLSoftwareRenderDevice : public RenderDevice {
@@ -65,6 +78,7 @@ public:
 	virtual int render(Renderable& r, Rect& dest);
 	virtual int render(Sprite* r);
 	virtual int renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest);
+	virtual int copyToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest);
 
 	Image* renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended);
 	void drawPixel(int x, int y, const Color& color);
@@ -86,12 +100,50 @@ public:
 protected:
 	int createContextInternal();
 	void createContextError();
+	Image *createEmptyImage();
+	void setImageSurface(Image *image, SDL_Surface *surface, const std::string& filename);
 
 private:
+	// a recorded draw call to the screen, used in dirty rectangle mode
+	class DrawCommand {
+	public:
+		enum {
+			TYPE_IMAGE = 0,
+			TYPE_PIXEL = 1,
+			TYPE_LINE = 2
+		};
+
+		int type;
+		SDLSoftwareImage *image;
+		unsigned long version;
+		SDL_Rect src;
+		SDL_Rect dest;
+		SDL_BlendMode blend_mode;
+		Color color; // color mod of the image, or the color of the pixel/line
+		Uint8 alpha_mod;
+		Point p0;
+		Point p1;
+		SDL_Rect bounds; // the area of the screen that is drawn to
+
+		DrawCommand();
+		bool operator==(const DrawCommand& other) const;
+	};
+
+	static const size_t MAX_DIRTY_RECTS = 16;
+
 	Uint32 MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
 	void getWindowSize(short unsigned *screen_w, short unsigned *screen_h);
 	void setSDL_RGBA(Uint32 *rmask, Uint32 *gmask, Uint32 *bmask, Uint32 *amask);
 
+	int blitToScreen(SDL_Surface *surface, SDL_Rect *src, SDL_Rect *dest);
+	void writePixel(int x, int y, const Color& color);
+	void drawLineClipped(int x0, int y0, int x1, int y1, const Color& color, const SDL_Rect *clip);
+	void addDrawCommand(DrawCommand& cmd);
+	void replayDrawCommand(const DrawCommand& cmd, const SDL_Rect& clip);
+	void clearDrawCommands(std::vector<DrawCommand>& commands);
+	void addDirtyRect(const SDL_Rect& rect);
+	void commitDirtyRects();
+
 	SDL_Surface* screen;
 	SDL_Window* window;
 	SDL_Renderer* renderer;
@@ -99,6 +151,14 @@ private:
 	SDL_Surface* titlebar_icon;
 	char* title;
 	uint32_t background_color;
+
+	SDLSoftwareBlitter blitter;
+
+	bool dirty_rect_mode;
+	bool full_redraw;
+	std::vector<DrawCommand> draw_commands;
+	std::vector<DrawCommand> prev_draw_commands;
+	std::vector<SDL_Rect> dirty_rects;
 };
 
 #endif // SDLSOFTWARERENDERDEVICE_H
@@ -329,7 +329,7 @@ void SaveLoad::loadGame() {
 			}
 			else if (infile.key == "spawn") {
 				mapr->teleport_mapname = Parse::popFirstString(infile.val);
-				if (mapr->teleport_mapname != "" && Filesystem::fileExists(mods->locate(mapr->teleport_mapname))) {
+				if (mapr->teleport_mapname != "" && mods->locate(mapr->teleport_mapname) != "") {
 					mapr->teleport_destination.x = static_cast<float>(Parse::popFirstInt(infile.val)) + 0.5f;
 					mapr->teleport_destination.y = static_cast<float>(Parse::popFirstInt(infile.val)) + 0.5f;
 					mapr->teleportation = true;
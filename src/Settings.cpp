@@ -60,7 +60,7 @@ Settings::Settings()
 	, encounter_dist(0) // set in updateScreenVars()
 	, soft_reset(false)
 {
-	config.resize(39);
+	config.resize(47);
 	setConfigDefault(0,  "fullscreen",          &typeid(fullscreen),          "0",            &fullscreen,          "fullscreen mode. 1 enable, 0 disable.");
 	setConfigDefault(1,  "resolution_w",        &typeid(screen_w),            "640",          &screen_w,            "display resolution. 640x480 minimum.");
 	setConfigDefault(2,  "resolution_h",        &typeid(screen_h),            "480",          &screen_h,            "");
@@ -101,6 +101,14 @@ Settings::Settings()
 	setConfigDefault(37, "low_hp_warning_type", &typeid(low_hp_warning_type), "0",            &low_hp_warning_type, 
 			"low health warning type settings. 0 disable, 1 all, 2 message & cursor, 3 message & sound, 4 cursor & sound , 5 message, 6 cursor, 7 sound.");
 	setConfigDefault(38, "low_hp_threshold",    &typeid(low_hp_threshold),    "20",           &low_hp_threshold,    "set HP threshold that triggers warning.");
+	setConfigDefault(39, "pathfinding_thread",  &typeid(pathfinding_thread),  "1",            &pathfinding_thread,  "computes enemy paths on a separate thread. 1 enable, 0 disable.");
+	setConfigDefault(40, "path_node_budget",    &typeid(path_node_budget),    "10000",        &path_node_budget,    "maximum number of path nodes searched per frame before remaining path requests wait for the next frame. 0 is unlimited.");
+	setConfigDefault(41, "dirty_rects",         &typeid(dirty_rects),         "0",            &dirty_rects,         "software renderer only redraws the parts of the screen that changed since the last frame. 1 enable, 0 disable.");
+	setConfigDefault(42, "software_blitter",    &typeid(software_blitter),    "2",            &software_blitter,    "blitter used by the software renderer. 0 is SDL, 1 is the built-in blitter, 2 is the built-in blitter using SIMD instructions when available.");
+	setConfigDefault(43, "parser_cache",        &typeid(parser_cache),        "0",            &parser_cache,        "stores parsed mod data files in a binary cache, so that they load faster on the next start. 1 enable, 0 disable.");
+	setConfigDefault(44, "map_preload",         &typeid(map_preload),         "1",            &map_preload,         "reads and decodes the maps that the current map leads to on a separate thread. 1 enable, 0 disable.");
+	setConfigDefault(45, "map_preload_memory",  &typeid(map_preload_memory),  "64",           &map_preload_memory,  "memory in megabytes that preloaded maps may use.");
+	setConfigDefault(46, "image_cache_memory",  &typeid(image_cache_memory),  "128",          &image_cache_memory,  "memory in megabytes used to keep images that are no longer in use, so that loading them again is faster. 0 disables this.");
 }
 
 void Settings::setConfigDefault(size_t index, const std::string& name, const std::type_info *type, const std::string& default_val, void *storage, const std::string& comment) {
@@ -111,6 +111,16 @@ public:
 	// Misc
 	int prev_save_slot;
 
+	// Performance Settings
+	bool pathfinding_thread;
+	int path_node_budget;
+	bool dirty_rects;
+	int software_blitter;
+	bool parser_cache;
+	bool map_preload;
+	int map_preload_memory;
+	int image_cache_memory;
+
 	/**
 	 * NOTE Everything below is not part of the user's settings.txt, but somehow ended up here
 	 * TODO Move these to more appropriate locations?
@@ -26,6 +26,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
  */
 
 #include "Avatar.h"
+#include "Benchmark.h"
 #include "CampaignManager.h"
 #include "CombatText.h"
 #include "Enemy.h"
@@ -50,6 +51,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 StatBlock::StatBlock()
 	: statsLoaded(false)
+	, base_level(0)
 	, alive(true)
 	, corpse(false)
 	, corpse_timer()
@@ -61,6 +63,7 @@ StatBlock::StatBlock()
 	, permadeath(false)
 	, transformed(false)
 	, refresh_stats(false)
+	, refresh_base(true)
 	, converted(false)
 	, summoned(false)
 	, summoned_power_index(0)
@@ -616,6 +619,7 @@ void StatBlock::load(const std::string& filename) {
 	if (!flee_range_defined)
 		flee_range = threat_range / 2;
 
+	refresh_base = true;
 	applyEffects();
 }
 
@@ -652,6 +656,7 @@ void StatBlock::recalc() {
 	if (level < 1)
 		level = 1;
 
+	refresh_base = true;
 	applyEffects();
 
 	hp = get(Stats::HP_MAX);
@@ -666,27 +671,87 @@ void StatBlock::calcBase() {
 	// bonuses are skipped for the default level 1 of a stat
 	int lev0 = std::max(level - 1, 0);
 
+	base_level = level;
+	base_raw.resize(Stats::COUNT + eset->damage_types.count);
+	base_primary.resize(per_primary.size());
+	per_primary_stats.resize(per_primary.size());
+
 	for (size_t i = 0; i < Stats::COUNT + eset->damage_types.count; ++i) {
-		base[i] = starting[i];
-		base[i] += lev0 * per_level[i];
-		for (size_t j = 0; j < per_primary.size(); ++j) {
-			base[i] += std::max(get_primary(j) - 1, 0) * per_primary[j][i];
+		base_raw[i] = starting[i];
+		base_raw[i] += lev0 * per_level[i];
+	}
+
+	for (size_t j = 0; j < per_primary.size(); ++j) {
+		base_primary[j] = std::max(get_primary(j) - 1, 0);
+
+		per_primary_stats[j].clear();
+		for (size_t i = 0; i < Stats::COUNT + eset->damage_types.count; ++i) {
+			if (per_primary[j][i] == 0)
+				continue;
+
+			per_primary_stats[j].push_back(i);
+			base_raw[i] += base_primary[j] * per_primary[j][i];
 		}
 	}
 
-	// add damage from equipment and increase to minimum amounts
+	for (size_t i = 0; i < Stats::COUNT + eset->damage_types.count; ++i) {
+		base[i] = base_raw[i];
+	}
+
+	calcBaseEquipment();
+
+	// every stat is recalculated after this
+	base_changes.clear();
+}
+
+/**
+ * Updates base[] for the primary stats that changed since the last calcBase()
+ * Only the stats that have a per_primary bonus for a changed primary stat are touched
+ */
+void StatBlock::updateBase() {
+	for (size_t j = 0; j < per_primary.size(); ++j) {
+		int value = std::max(get_primary(j) - 1, 0);
+		if (value == base_primary[j])
+			continue;
+
+		int diff = value - base_primary[j];
+		base_primary[j] = value;
+
+		for (size_t k = 0; k < per_primary_stats[j].size(); ++k) {
+			size_t i = per_primary_stats[j][k];
+			base_raw[i] += diff * per_primary[j][i];
+			setBase(i, base_raw[i]);
+		}
+	}
+
+	// equipment can change at any time, but there are only a few of these stats
+	calcBaseEquipment();
+}
+
+/**
+ * Add damage and absorb from equipment and increase them to minimum amounts
+ */
+void StatBlock::calcBaseEquipment() {
 	for (size_t i = 0; i < eset->damage_types.list.size(); ++i) {
-		base[Stats::COUNT + (i*2)] += dmg_min_add[i];
-		base[Stats::COUNT + (i*2) + 1] += dmg_max_add[i];
-		base[Stats::COUNT + (i*2)] = std::max(base[Stats::COUNT + (i*2)], 0);
-		base[Stats::COUNT + (i*2) + 1] = std::max(base[Stats::COUNT + (i*2) + 1], base[Stats::COUNT + (i*2)]);
+		size_t dmg_min = Stats::COUNT + (i*2);
+		size_t dmg_max = Stats::COUNT + (i*2) + 1;
+
+		int value_min = std::max(base_raw[dmg_min] + dmg_min_add[i], 0);
+		setBase(dmg_min, value_min);
+		setBase(dmg_max, std::max(base_raw[dmg_max] + dmg_max_add[i], value_min));
 	}
 
-	// add absorb from equipment and increase to minimum amounts
-	base[Stats::ABS_MIN] += absorb_min_add;
-	base[Stats::ABS_MAX] += absorb_max_add;
-	base[Stats::ABS_MIN] = std::max(base[Stats::ABS_MIN], 0);
-	base[Stats::ABS_MAX] = std::max(base[Stats::ABS_MAX], base[Stats::ABS_MIN]);
+	int absorb_min = std::max(base_raw[Stats::ABS_MIN] + absorb_min_add, 0);
+	setBase(Stats::ABS_MIN, absorb_min);
+	setBase(Stats::ABS_MAX, std::max(base_raw[Stats::ABS_MAX] + absorb_max_add, absorb_min));
+}
+
+void StatBlock::setBase(size_t stat, int value) {
+	if (base[stat] == value)
+		return;
+
+	base[stat] = value;
+	base_changes.push_back(stat);
 }
 
 /**
@@ -710,11 +775,32 @@ void StatBlock::applyEffects() {
 		primary_additional[i] = effects.bonus_primary[i];
 	}
 
-	calcBase();
+	// a level up changes every stat with a per_level bonus, so it's simpler to start over
+	bool full_update = refresh_base || level != base_level;
+	if (full_update) {
+		calcBase();
+		refresh_base = false;
+	}
+	else {
+		updateBase();
+	}
+
+	if (full_update || effects.bonus_changed) {
+		for (size_t i=0; i<Stats::COUNT + eset->damage_types.count; i++) {
+			current[i] = base[i] + effects.bonus[i];
+		}
+	}
+	else {
+		for (size_t i = 0; i < base_changes.size(); ++i) {
+			current[base_changes[i]] = base[base_changes[i]] + effects.bonus[base_changes[i]];
+		}
 
-	for (size_t i=0; i<Stats::COUNT + eset->damage_types.count; i++) {
-		current[i] = base[i] + effects.bonus[i];
+		// the percentage bonuses below are applied on top of these
+		current[Stats::HP_MAX] = base[Stats::HP_MAX] + effects.bonus[Stats::HP_MAX];
+		current[Stats::MP_MAX] = base[Stats::MP_MAX] + effects.bonus[Stats::MP_MAX];
 	}
+	base_changes.clear();
+	effects.bonus_changed = false;
 
 	for (unsigned i=0; i<effects.bonus_resist.size(); i++) {
 		vulnerable[i] = vulnerable_base[i] - effects.bonus_resist[i];
@@ -727,16 +813,76 @@ void StatBlock::applyEffects() {
 	current[Stats::HP_MAX] = std::max(get(Stats::HP_MAX), 1);
 	current[Stats::MP_MAX] = std::max(get(Stats::MP_MAX), 1);
 
+#ifdef FLARE_DEBUG
+	checkIncrementalStats();
+#endif
+
 	if (hp > get(Stats::HP_MAX)) hp = get(Stats::HP_MAX);
 	if (mp > get(Stats::MP_MAX)) mp = get(Stats::MP_MAX);
 
 	speed = speed_default;
 }
 
+/**
+ * Compares the incrementally updated stats with a full recalculation
+ * Only used in debug builds. Any difference is logged and replaced by the full result.
+ */
+void StatBlock::checkIncrementalStats() {
+	const size_t stat_count = Stats::COUNT + eset->damage_types.count;
+	int lev0 = std::max(level - 1, 0);
+
+	std::vector<int> full_base(stat_count, 0);
+	for (size_t i = 0; i < stat_count; ++i) {
+		full_base[i] = starting[i];
+		full_base[i] += lev0 * per_level[i];
+		for (size_t j = 0; j < per_primary.size(); ++j) {
+			full_base[i] += std::max(get_primary(j) - 1, 0) * per_primary[j][i];
+		}
+	}
+
+	for (size_t i = 0; i < eset->damage_types.list.size(); ++i) {
+		full_base[Stats::COUNT + (i*2)] += dmg_min_add[i];
+		full_base[Stats::COUNT + (i*2) + 1] += dmg_max_add[i];
+		full_base[Stats::COUNT + (i*2)] = std::max(full_base[Stats::COUNT + (i*2)], 0);
+		full_base[Stats::COUNT + (i*2) + 1] = std::max(full_base[Stats::COUNT + (i*2) + 1], full_base[Stats::COUNT + (i*2)]);
+	}
+
+	full_base[Stats::ABS_MIN] += absorb_min_add;
+	full_base[Stats::ABS_MAX] += absorb_max_add;
+	full_base[Stats::ABS_MIN] = std::max(full_base[Stats::ABS_MIN], 0);
+	full_base[Stats::ABS_MAX] = std::max(full_base[Stats::ABS_MAX], full_base[Stats::ABS_MIN]);
+
+	std::vector<int> full_current(stat_count, 0);
+	for (size_t i = 0; i < stat_count; ++i) {
+		full_current[i] = full_base[i] + effects.bonus[i];
+	}
+
+	full_current[Stats::HP_MAX] += (full_current[Stats::HP_MAX] * full_current[Stats::HP_PERCENT]) / 100;
+	full_current[Stats::MP_MAX] += (full_current[Stats::MP_MAX] * full_current[Stats::MP_PERCENT]) / 100;
+	full_current[Stats::HP_MAX] = std::max(full_current[Stats::HP_MAX], 1);
+	full_current[Stats::MP_MAX] = std::max(full_current[Stats::MP_MAX], 1);
+
+	bool valid = true;
+	for (size_t i = 0; i < stat_count; ++i) {
+		if (base[i] != full_base[i] || current[i] != full_current[i]) {
+			Utils::logError("StatBlock: '%s': Stat %u is %d/%d (base/current), but a full recalculation gives %d/%d.", name.c_str(), static_cast<unsigned>(i), base[i], current[i], full_base[i], full_current[i]);
+			valid = false;
+		}
+	}
+
+	if (!valid) {
+		base = full_base;
+		current = full_current;
+		refresh_base = true;
+	}
+}
+
 /**
  * Process per-frame actions
  */
 void StatBlock::logic() {
+	BENCHMARK_ZONE(Benchmark::ZONE_STATBLOCK_LOGIC);
+
 	alive = !(hp <= 0 && !effects.triggered_death && !effects.revive);
 
 	// handle party buffs
@@ -41,8 +41,19 @@ private:
 	bool isNPCStat(FileParser *infile);
 	void loadHeroStats();
 	bool checkRequiredSpawns(int req_amount) const;
+	void updateBase();
+	void calcBaseEquipment();
+	void setBase(size_t stat, int value);
+	void checkIncrementalStats();
 	bool statsLoaded;
 
+	// the inputs of the last calcBase(), so that applyEffects() only has to update the stats that changed
+	int base_level;
+	std::vector<int> base_primary; // max(get_primary() - 1, 0) for each primary stat
+	std::vector<int> base_raw; // base[] before damage and absorb from equipment are added
+	std::vector< std::vector<size_t> > per_primary_stats; // the stats that each primary stat has a per_primary bonus for
+	std::vector<size_t> base_changes; // stats whose base[] value changed since current[] was calculated
+
 public:
 	enum {
 		AI_POWER_MELEE = 0,
@@ -131,6 +142,7 @@ public:
 	bool permadeath;
 	bool transformed;
 	bool refresh_stats;
+	bool refresh_base; // set after changing starting[], per_level[] or per_primary[], so that all stats are recalculated
 	bool converted;
 	bool summoned;
 	int summoned_power_index;
@@ -0,0 +1,261 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "TaskGraph.h"
+#include "Utils.h"
+
+#include <algorithm>
+
+namespace {
+
+double ticksToMS(Uint64 ticks) {
+	return static_cast<double>(ticks) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+} // namespace
+
+const bool TaskGraph::MAIN_THREAD;
+const bool TaskGraph::WORKER_THREAD;
+const int TaskGraph::MAX_WORKERS;
+
+TaskGraph::TaskGraph(const std::string& _name)
+	: name(_name)
+	, tasks_left(0)
+	, worker_tasks_left(0)
+	, worker_count(0)
+	, start_ticks(0)
+	, end_ticks(0)
+	, lock(NULL)
+	, task_done(NULL) {
+}
+
+TaskGraph::~TaskGraph() {
+}
+
+size_t TaskGraph::addTask(const std::string& task_name, TaskFunction function, void* data, bool main_thread) {
+	tasks.resize(tasks.size() + 1);
+	Task& task = tasks.back();
+	task.name = task_name;
+	task.function = function;
+	task.data = data;
+	task.main_thread = main_thread;
+	return tasks.size() - 1;
+}
+
+void TaskGraph::addDependency(size_t task, size_t dependency) {
+	if (task >= tasks.size() || dependency >= task) {
+		Utils::logError("TaskGraph: %s: Task %u can't depend on task %u.", name.c_str(), static_cast<unsigned>(task), static_cast<unsigned>(dependency));
+		return;
+	}
+
+	std::vector<size_t>& dependents = tasks[dependency].dependents;
+	if (std::find(dependents.begin(), dependents.end(), task) != dependents.end())
+		return;
+
+	dependents.push_back(task);
+	tasks[task].dependency_count++;
+}
+
+void TaskGraph::run() {
+	start_ticks = SDL_GetPerformanceCounter();
+
+	ready_main.clear();
+	ready_worker.clear();
+	tasks_left = tasks.size();
+	worker_tasks_left = 0;
+	worker_count = 0;
+
+	for (size_t i = 0; i < tasks.size(); ++i) {
+		tasks[i].dependencies_left = tasks[i].dependency_count;
+		if (!tasks[i].main_thread)
+			worker_tasks_left++;
+
+		if (tasks[i].dependency_count == 0) {
+			if (tasks[i].main_thread)
+				ready_main.push_back(i);
+			else
+				ready_worker.push_back(i);
+		}
+	}
+
+	std::vector<Worker> workers;
+
+#ifndef __EMSCRIPTEN__
+	if (worker_tasks_left > 0) {
+		lock = SDL_CreateMutex();
+		task_done = SDL_CreateCond();
+	}
+
+	if (lock && task_done) {
+		// leave one core for the main thread
+		int thread_count = std::max(1, std::min(SDL_GetCPUCount() - 1, MAX_WORKERS));
+		thread_count = std::min(thread_count, static_cast<int>(worker_tasks_left));
+
+		// the workers only read from this vector, so it must not be resized once they are running
+		workers.resize(thread_count);
+		for (int i = 0; i < thread_count; ++i) {
+			workers[i].graph = this;
+			workers[i].id = i + 1;
+			workers[i].thread = SDL_CreateThread(runWorker, "task_graph", &workers[i]);
+			if (!workers[i].thread)
+				break;
+			worker_count++;
+		}
+
+		if (worker_count == 0)
+			Utils::logError("TaskGraph: %s: Unable to create worker threads, tasks will run on the main thread: %s", name.c_str(), SDL_GetError());
+	}
+#endif
+
+	if (worker_count == 0) {
+		runSerial();
+	}
+	else {
+		SDL_LockMutex(lock);
+		while (tasks_left > 0) {
+			if (!ready_main.empty()) {
+				size_t index = ready_main.front();
+				ready_main.pop_front();
+
+				SDL_UnlockMutex(lock);
+				runTask(index, 0);
+				SDL_LockMutex(lock);
+
+				finishTask(index);
+			}
+			else {
+				SDL_CondWait(task_done, lock);
+			}
+		}
+		SDL_UnlockMutex(lock);
+
+		for (int i = 0; i < worker_count; ++i) {
+			SDL_WaitThread(workers[i].thread, NULL);
+		}
+	}
+
+	if (task_done)
+		SDL_DestroyCond(task_done);
+	if (lock)
+		SDL_DestroyMutex(lock);
+	task_done = NULL;
+	lock = NULL;
+
+	end_ticks = SDL_GetPerformanceCounter();
+}
+
+int TaskGraph::runWorker(void* data) {
+	Worker* worker = static_cast<Worker*>(data);
+	TaskGraph* graph = worker->graph;
+
+	SDL_LockMutex(graph->lock);
+	while (true) {
+		if (!graph->ready_worker.empty()) {
+			size_t index = graph->ready_worker.front();
+			graph->ready_worker.pop_front();
+
+			SDL_UnlockMutex(graph->lock);
+			graph->runTask(index, worker->id);
+			SDL_LockMutex(graph->lock);
+
+			graph->finishTask(index);
+		}
+		else if (graph->worker_tasks_left == 0) {
+			break;
+		}
+		else {
+			SDL_CondWait(graph->task_done, graph->lock);
+		}
+	}
+	SDL_UnlockMutex(graph->lock);
+
+	return 0;
+}
+
+/**
+ * Dependencies always point to earlier tasks, so tasks can simply run in the order they were added
+ */
+void TaskGraph::runSerial() {
+	for (size_t i = 0; i < tasks.size(); ++i) {
+		runTask(i, 0);
+	}
+	ready_main.clear();
+	ready_worker.clear();
+	tasks_left = 0;
+	worker_tasks_left = 0;
+}
+
+void TaskGraph::runTask(size_t index, int thread_id) {
+	Task& task = tasks[index];
+	task.thread_id = thread_id;
+	task.start_ticks = SDL_GetPerformanceCounter();
+	if (task.function)
+		task.function(task.data);
+	task.end_ticks = SDL_GetPerformanceCounter();
+}
+
+/**
+ * Makes the tasks that were waiting on this one ready; called with the lock held
+ */
+void TaskGraph::finishTask(size_t index) {
+	Task& task = tasks[index];
+
+	tasks_left--;
+	if (!task.main_thread)
+		worker_tasks_left--;
+
+	for (size_t i = 0; i < task.dependents.size(); ++i) {
+		Task& dependent = tasks[task.dependents[i]];
+		dependent.dependencies_left--;
+		if (dependent.dependencies_left == 0) {
+			if (dependent.main_thread)
+				ready_main.push_back(task.dependents[i]);
+			else
+				ready_worker.push_back(task.dependents[i]);
+		}
+	}
+
+	SDL_CondBroadcast(task_done);
+}
+
+void TaskGraph::logTimeline() {
+	const size_t BAR_WIDTH = 40;
+	const Uint64 total_ticks = std::max<Uint64>(end_ticks - start_ticks, 1);
+
+	Utils::logInfo("TaskGraph: %s: %u tasks finished in %.1f ms, using %d worker threads.", name.c_str(), static_cast<unsigned>(tasks.size()), ticksToMS(end_ticks - start_ticks), worker_count);
+
+	for (size_t i = 0; i < tasks.size(); ++i) {
+		const Task& task = tasks[i];
+
+		// the bar shows when the task ran, relative to the whole graph
+		size_t bar_start = static_cast<size_t>((task.start_ticks - start_ticks) * BAR_WIDTH / total_ticks);
+		size_t bar_end = static_cast<size_t>((task.end_ticks - start_ticks) * BAR_WIDTH / total_ticks);
+		bar_start = std::min(bar_start, BAR_WIDTH - 1);
+		bar_end = std::min(std::max(bar_end, bar_start + 1), BAR_WIDTH);
+
+		std::string bar(BAR_WIDTH, '.');
+		bar.replace(bar_start, bar_end - bar_start, bar_end - bar_start, '#');
+
+		std::stringstream thread_name;
+		if (task.thread_id == 0)
+			thread_name << "main";
+		else
+			thread_name << "worker " << task.thread_id;
+
+		Utils::logInfo("TaskGraph: %s: [%s] %8.1f ms +%8.1f ms  %-8s %s", name.c_str(), bar.c_str(), ticksToMS(task.start_ticks - start_ticks), ticksToMS(task.end_ticks - task.start_ticks), thread_name.str().c_str(), task.name.c_str());
+	}
+}
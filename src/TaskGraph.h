@@ -0,0 +1,123 @@
+/*
+Copyright © 2026 Justin Jacobs
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class TaskGraph
+ *
+ * Runs a set of loading tasks, such as parsing the game databases at startup, on worker threads.
+ * A task starts once all of the tasks it depends on have finished.
+ *
+ * Tasks that create SDL resources (textures, sounds, fonts, input devices) must be added with MAIN_THREAD.
+ * They are run by the thread that calls run(). Worker tasks may only read shared state that
+ * their dependencies have finished writing.
+ *
+ * A task can only depend on tasks that were added before it, so running the tasks in the order they
+ * were added is always valid. That order is used if threads aren't available.
+ */
+
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include "CommonIncludes.h"
+
+#include <deque>
+
+class TaskGraph {
+public:
+	typedef void (*TaskFunction)(void* data);
+
+	static const bool MAIN_THREAD = true;
+	static const bool WORKER_THREAD = false;
+
+	explicit TaskGraph(const std::string& _name);
+	~TaskGraph();
+
+	// returns the id of the new task, which is used to declare dependencies
+	size_t addTask(const std::string& task_name, TaskFunction function, void* data, bool main_thread);
+
+	// task won't start before dependency has finished
+	void addDependency(size_t task, size_t dependency);
+
+	// runs all tasks; returns once they have finished
+	void run();
+
+	// writes when each task started, how long it took and which thread ran it to the log
+	void logTimeline();
+
+private:
+	TaskGraph(const TaskGraph&); // not implemented
+
+	class Task {
+	public:
+		std::string name;
+		TaskFunction function;
+		void* data;
+		bool main_thread;
+
+		std::vector<size_t> dependents;
+		size_t dependency_count;
+		size_t dependencies_left;
+
+		int thread_id; // 0 is the main thread
+		Uint64 start_ticks;
+		Uint64 end_ticks;
+
+		Task()
+			: function(NULL)
+			, data(NULL)
+			, main_thread(false)
+			, dependency_count(0)
+			, dependencies_left(0)
+			, thread_id(0)
+			, start_ticks(0)
+			, end_ticks(0) {
+		}
+	};
+
+	class Worker {
+	public:
+		TaskGraph* graph;
+		int id;
+		SDL_Thread* thread;
+	};
+
+	static const int MAX_WORKERS = 4;
+
+	static int runWorker(void* data);
+
+	void runSerial();
+	void runTask(size_t index, int thread_id);
+	void finishTask(size_t index);
+
+	std::string name;
+	std::vector<Task> tasks;
+
+	// ready tasks, in the order they were added
+	std::deque<size_t> ready_main;
+	std::deque<size_t> ready_worker;
+	size_t tasks_left;
+	size_t worker_tasks_left;
+	int worker_count;
+
+	Uint64 start_ticks;
+	Uint64 end_ticks;
+
+	SDL_mutex* lock;
+	SDL_cond* task_done;
+};
+
+#endif // TASK_GRAPH_H
@@ -28,11 +28,16 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "EngineSettings.h"
 #include "FileParser.h"
 #include "ModManager.h"
+#include "Platform.h"
 #include "RenderDevice.h"
+#include "Settings.h"
 #include "SharedResources.h"
 #include "TileSet.h"
+#include "UtilsFileSystem.h"
 #include "UtilsParsing.h"
 
+#include <algorithm>
+
 TileSet::TileSet() {
 	reset();
 }
@@ -51,6 +56,7 @@ void TileSet::reset() {
 
 	tiles.clear();
 	anim.clear();
+	updated_tiles.clear();
 
 	max_size_x = 0;
 	max_size_y = 0;
@@ -151,18 +157,36 @@ void TileSet::load(const std::string& filename) {
 		infile.close();
 	}
 
+	// decode all tileset images at once; loadGraphics() then finds them in the image cache
+	std::vector<Image*> pending_images;
+	for (size_t i = 0; i < image_filenames.size(); ++i) {
+		if (!image_filenames[i].empty())
+			pending_images.push_back(render_device->loadImageAsync(image_filenames[i], RenderDevice::ERROR_NONE));
+	}
+	render_device->waitForImageLoads();
+
 	// load tileset images
 	for (size_t i = 0; i < image_filenames.size(); ++i) {
 		loadGraphics(image_filenames[i], &sprites[i]);
 	}
 
+	for (size_t i = 0; i < pending_images.size(); ++i) {
+		pending_images[i]->unref();
+	}
+
+	// tiles from multiple images are packed together so that the map renderer doesn't keep switching textures
+	if (image_filenames.size() > 1)
+		createAtlas(filename, image_filenames, tile_images, tile_clips);
+
 	// set up individual tile sprites
 	for (size_t i = 0; i < tiles.size(); ++i) {
-		if (!sprites[tile_images[i]])
-			continue;
+		if (!tiles[i].tile) {
+			if (!sprites[tile_images[i]])
+				continue;
 
-		tiles[i].tile = sprites[tile_images[i]]->getGraphics()->createSprite();
-		tiles[i].tile->setClipFromRect(tile_clips[i]);
+			tiles[i].tile = sprites[tile_images[i]]->getGraphics()->createSprite();
+			tiles[i].tile->setClipFromRect(tile_clips[i]);
+		}
 		tiles[i].offset = tile_offsets[i];
 
 		max_size_x = std::max(max_size_x, (tiles[i].tile->getClip().w / eset->tileset.tile_w) + 1);
@@ -172,7 +196,297 @@ void TileSet::load(const std::string& filename) {
 	current_filename = filename;
 }
 
+bool TileSet::AtlasRect::operator<(const AtlasRect& other) const {
+	if (image != other.image) return image < other.image;
+	if (src.x != other.src.x) return src.x < other.src.x;
+	if (src.y != other.src.y) return src.y < other.src.y;
+	if (src.w != other.src.w) return src.w < other.src.w;
+	return src.h < other.src.h;
+}
+
+size_t TileSet::addAtlasRect(std::vector<AtlasRect>& rects, std::map<AtlasRect, size_t>& rect_index, size_t image, const Rect& src) {
+	AtlasRect rect;
+	rect.image = image;
+	rect.src = src;
+
+	std::map<AtlasRect, size_t>::iterator it = rect_index.find(rect);
+	if (it != rect_index.end())
+		return it->second;
+
+	rects.push_back(rect);
+	rect_index[rect] = rects.size() - 1;
+	return rects.size() - 1;
+}
+
+/**
+ * Copy every tile and animation frame into one or more atlas images
+ * Tiles that don't fit, or that have animation frames spread over multiple atlases, keep using their original image
+ */
+void TileSet::createAtlas(const std::string& filename, const std::vector<std::string>& image_filenames, const std::vector<size_t>& tile_images, const std::vector<Rect>& tile_clips) {
+	std::vector<AtlasRect> rects;
+	std::map<AtlasRect, size_t> rect_index;
+	std::vector<int> tile_rects(tiles.size(), -1);
+	std::vector< std::vector<size_t> > anim_rects(anim.size());
+
+	for (size_t i = 0; i < tiles.size(); ++i) {
+		if (!sprites[tile_images[i]] || tile_clips[i].w <= 0 || tile_clips[i].h <= 0)
+			continue;
+
+		tile_rects[i] = static_cast<int>(addAtlasRect(rects, rect_index, tile_images[i], tile_clips[i]));
+
+		if (i < anim.size()) {
+			for (size_t j = 0; j < anim[i].pos.size(); ++j) {
+				Rect frame = tile_clips[i];
+				frame.x = anim[i].pos[j].x;
+				frame.y = anim[i].pos[j].y;
+				anim_rects[i].push_back(addAtlasRect(rects, rect_index, tile_images[i], frame));
+			}
+		}
+	}
+
+	if (rects.empty())
+		return;
+
+	// packing only depends on the tile sizes, so the layout is reused until one of the files changes
+	std::string cache_name = filename;
+	std::replace(cache_name.begin(), cache_name.end(), '/', '_');
+	std::replace(cache_name.begin(), cache_name.end(), '\\', '_');
+	const std::string cache_file = settings->path_user + "cache/tilesets/" + cache_name;
+	const std::string cache_key = getAtlasCacheKey(filename, image_filenames);
+
+	std::vector<Point> atlas_sizes;
+	if (!loadAtlasCache(cache_file, cache_key, rects, atlas_sizes)) {
+		packAtlas(rects, atlas_sizes);
+		saveAtlasCache(cache_file, cache_key, rects, atlas_sizes);
+	}
+
+	std::vector<Image*> atlases(atlas_sizes.size(), NULL);
+	for (size_t i = 0; i < atlas_sizes.size(); ++i) {
+		atlases[i] = render_device->createImage(atlas_sizes[i].x, atlas_sizes[i].y);
+	}
+
+	for (size_t i = 0; i < rects.size(); ++i) {
+		if (rects[i].atlas < 0 || !atlases[rects[i].atlas])
+			continue;
+
+		Rect src = rects[i].src;
+		Rect dest(rects[i].pos.x, rects[i].pos.y, src.w, src.h);
+		render_device->copyToImage(sprites[rects[i].image]->getGraphics(), src, atlases[rects[i].atlas], dest);
+	}
+
+	for (size_t i = 0; i < tiles.size(); ++i) {
+		if (tile_rects[i] == -1) {
+			// empty tiles still need a sprite, but it doesn't matter which image it's from
+			if (sprites[tile_images[i]] && !atlases.empty() && atlases[0]) {
+				tiles[i].tile = atlases[0]->createSprite();
+				tiles[i].tile->setClipFromRect(tile_clips[i]);
+			}
+			continue;
+		}
+
+		const AtlasRect& rect = rects[tile_rects[i]];
+		if (rect.atlas < 0 || !atlases[rect.atlas])
+			continue;
+
+		bool same_atlas = true;
+		for (size_t j = 0; i < anim_rects.size() && j < anim_rects[i].size(); ++j) {
+			if (rects[anim_rects[i][j]].atlas != rect.atlas)
+				same_atlas = false;
+		}
+		if (!same_atlas)
+			continue;
+
+		tiles[i].tile = atlases[rect.atlas]->createSprite();
+		tiles[i].tile->setClipFromRect(Rect(rect.pos.x, rect.pos.y, rect.src.w, rect.src.h));
+
+		for (size_t j = 0; i < anim_rects.size() && j < anim_rects[i].size(); ++j) {
+			anim[i].pos[j] = rects[anim_rects[i][j]].pos;
+		}
+	}
+
+	// the tile sprites hold their own references to the atlases
+	for (size_t i = 0; i < atlases.size(); ++i) {
+		if (atlases[i])
+			atlases[i]->unref();
+	}
+
+	// free the original images, unless some tiles still need them
+	std::vector<bool> image_used(sprites.size(), false);
+	for (size_t i = 0; i < tiles.size(); ++i) {
+		if (!tiles[i].tile)
+			image_used[tile_images[i]] = true;
+	}
+	for (size_t i = 0; i < sprites.size(); ++i) {
+		if (!image_used[i] && sprites[i]) {
+			delete sprites[i];
+			sprites[i] = NULL;
+		}
+	}
+}
+
+/**
+ * Simple shelf packing, tallest rects first
+ * Returns the number of atlases needed
+ */
+int TileSet::packAtlas(std::vector<AtlasRect>& rects, std::vector<Point>& atlas_sizes) {
+	std::vector<std::pair<int, size_t> > order;
+	for (size_t i = 0; i < rects.size(); ++i) {
+		rects[i].atlas = -1;
+		if (rects[i].src.w <= ATLAS_SIZE && rects[i].src.h <= ATLAS_SIZE)
+			order.push_back(std::pair<int, size_t>(-rects[i].src.h, i));
+	}
+	std::stable_sort(order.begin(), order.end());
+
+	atlas_sizes.clear();
+
+	int x = 0;
+	int y = 0;
+	int shelf_h = 0;
+
+	for (size_t i = 0; i < order.size(); ++i) {
+		AtlasRect& rect = rects[order[i].second];
+
+		if (atlas_sizes.empty())
+			atlas_sizes.push_back(Point(0, 0));
+
+		// start a new shelf
+		if (x + rect.src.w > ATLAS_SIZE) {
+			x = 0;
+			y += shelf_h;
+			shelf_h = 0;
+		}
+
+		// start a new atlas
+		if (y + rect.src.h > ATLAS_SIZE) {
+			atlas_sizes.push_back(Point(0, 0));
+			x = 0;
+			y = 0;
+			shelf_h = 0;
+		}
+
+		rect.atlas = static_cast<int>(atlas_sizes.size()) - 1;
+		rect.pos.x = x;
+		rect.pos.y = y;
+
+		x += rect.src.w;
+		shelf_h = std::max(shelf_h, rect.src.h);
+
+		Point& size = atlas_sizes.back();
+		size.x = std::max(size.x, x);
+		size.y = std::max(size.y, y + rect.src.h);
+	}
+
+	return static_cast<int>(atlas_sizes.size());
+}
+
+/**
+ * The cached layout is only valid while the tileset definition and its images are unchanged
+ */
+std::string TileSet::getAtlasCacheKey(const std::string& filename, const std::vector<std::string>& image_filenames) {
+	std::stringstream key;
+	key << filename << ":" << mods->getFileModifiedTime(mods->locate(filename));
+	for (size_t i = 0; i < image_filenames.size(); ++i) {
+		key << ";" << image_filenames[i] << ":" << mods->getFileModifiedTime(mods->locate(image_filenames[i]));
+	}
+	return key.str();
+}
+
+bool TileSet::loadAtlasCache(const std::string& cache_file, const std::string& cache_key, std::vector<AtlasRect>& rects, std::vector<Point>& atlas_sizes) {
+	FileParser infile;
+	if (!infile.open(cache_file, !FileParser::MOD_FILE, FileParser::ERROR_NONE))
+		return false;
+
+	std::map<AtlasRect, size_t> rect_index;
+	for (size_t i = 0; i < rects.size(); ++i) {
+		rects[i].atlas = -1;
+		rect_index[rects[i]] = i;
+	}
+
+	bool valid = false;
+	atlas_sizes.clear();
+
+	while (infile.next()) {
+		if (infile.key == "key") {
+			valid = (infile.val == cache_key);
+			if (!valid)
+				break;
+		}
+		else if (infile.key == "atlas") {
+			Point size;
+			size.x = Parse::popFirstInt(infile.val);
+			size.y = Parse::popFirstInt(infile.val);
+			atlas_sizes.push_back(size);
+		}
+		else if (infile.key == "rect") {
+			AtlasRect rect;
+			rect.image = Parse::toInt(Parse::popFirstString(infile.val));
+			rect.src.x = Parse::popFirstInt(infile.val);
+			rect.src.y = Parse::popFirstInt(infile.val);
+			rect.src.w = Parse::popFirstInt(infile.val);
+			rect.src.h = Parse::popFirstInt(infile.val);
+
+			std::map<AtlasRect, size_t>::iterator it = rect_index.find(rect);
+			if (it == rect_index.end()) {
+				valid = false;
+				break;
+			}
+
+			AtlasRect& dest = rects[it->second];
+			dest.atlas = Parse::popFirstInt(infile.val);
+			dest.pos.x = Parse::popFirstInt(infile.val);
+			dest.pos.y = Parse::popFirstInt(infile.val);
+		}
+	}
+	infile.close();
+
+	if (!valid)
+		return false;
+
+	// every rect that fits in an atlas must have been placed
+	for (size_t i = 0; i < rects.size(); ++i) {
+		if (rects[i].atlas >= static_cast<int>(atlas_sizes.size()))
+			return false;
+		if (rects[i].atlas < 0 && rects[i].src.w <= ATLAS_SIZE && rects[i].src.h <= ATLAS_SIZE)
+			return false;
+	}
+
+	return true;
+}
+
+void TileSet::saveAtlasCache(const std::string& cache_file, const std::string& cache_key, const std::vector<AtlasRect>& rects, const std::vector<Point>& atlas_sizes) {
+	Filesystem::createDir(settings->path_user + "cache");
+	Filesystem::createDir(settings->path_user + "cache/tilesets");
+
+	std::ofstream outfile;
+	outfile.open(cache_file.c_str(), std::ios::out);
+
+	if (outfile.is_open()) {
+		outfile << "## flare-engine tileset atlas cache ##" << "\n";
+		outfile << "key=" << cache_key << "\n";
+
+		for (size_t i = 0; i < atlas_sizes.size(); ++i) {
+			outfile << "atlas=" << atlas_sizes[i].x << "," << atlas_sizes[i].y << "\n";
+		}
+
+		for (size_t i = 0; i < rects.size(); ++i) {
+			if (rects[i].atlas < 0)
+				continue;
+
+			outfile << "rect=" << rects[i].image << "," << rects[i].src.x << "," << rects[i].src.y << "," << rects[i].src.w << "," << rects[i].src.h;
+			outfile << "," << rects[i].atlas << "," << rects[i].pos.x << "," << rects[i].pos.y << "\n";
+		}
+
+		if (outfile.bad()) Utils::logError("TileSet: Unable to write atlas cache file '%s'.", cache_file.c_str());
+		outfile.close();
+		outfile.clear();
+
+		platform.FSCommit();
+	}
+}
+
 void TileSet::logic() {
+	updated_tiles.clear();
+
 	for (size_t i = 0; i < anim.size(); ++i) {
 		Tile_Anim &an = anim[i];
 		if (!an.frames)
@@ -184,11 +498,16 @@ void TileSet::logic() {
 			tiles[i].tile->setClipFromRect(clip);
 			an.duration = 0;
 			an.current_frame = static_cast<unsigned short>((an.current_frame + 1) % an.frames);
+			updated_tiles.push_back(static_cast<unsigned short>(i));
 		}
 		an.duration++;
 	}
 }
 
+bool TileSet::isAnimated(size_t tile_id) {
+	return tile_id < anim.size() && anim[tile_id].frames > 0;
+}
+
 TileSet::~TileSet() {
 	for (size_t i = 0; i < sprites.size(); ++i) {
 		if (sprites[i])
@@ -62,9 +62,32 @@ private:
 		}
 	};
 
+	// a region of one of the tileset images, and where it was placed in the atlas
+	class AtlasRect {
+	public:
+		size_t image;
+		Rect src;
+		int atlas;
+		Point pos;
+		AtlasRect()
+			: image(0)
+			, atlas(-1) {
+		}
+		bool operator<(const AtlasRect& other) const;
+	};
+
+	static const int ATLAS_SIZE = 2048;
+
 	void loadGraphics(const std::string& filename, Sprite** sprite);
 	void reset();
 
+	void createAtlas(const std::string& filename, const std::vector<std::string>& image_filenames, const std::vector<size_t>& tile_images, const std::vector<Rect>& tile_clips);
+	size_t addAtlasRect(std::vector<AtlasRect>& rects, std::map<AtlasRect, size_t>& rect_index, size_t image, const Rect& src);
+	int packAtlas(std::vector<AtlasRect>& rects, std::vector<Point>& atlas_sizes);
+	std::string getAtlasCacheKey(const std::string& filename, const std::vector<std::string>& image_filenames);
+	bool loadAtlasCache(const std::string& cache_file, const std::string& cache_key, std::vector<AtlasRect>& rects, std::vector<Point>& atlas_sizes);
+	void saveAtlasCache(const std::string& cache_file, const std::string& cache_key, const std::vector<AtlasRect>& rects, const std::vector<Point>& atlas_sizes);
+
 	std::string current_filename;
 
 	std::vector<Sprite*> sprites;
@@ -76,9 +99,13 @@ public:
 	~TileSet();
 	void load(const std::string& filename);
 	void logic();
+	bool isAnimated(size_t tile_id);
 
 	std::vector<Tile_Def> tiles;
 
+	// ids of the tiles that changed animation frame during the last call to logic(), in ascending order
+	std::vector<unsigned short> updated_tiles;
+
 	// oversize of the largest tile available, in number of tiles.
 	int max_size_x;
 	int max_size_y;
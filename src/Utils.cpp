@@ -408,9 +408,8 @@ void Utils::logInfo(const char* format, ...) {
 	else if (LOG_FILE_CREATED) {
 		FILE *log_file = fopen(LOG_PATH.c_str(), "a");
 		if (log_file) {
-			fprintf(log_file, "INFO: ");
-			fprintf(log_file, "%s", file_buf);
-			fprintf(log_file, "\n");
+			// a single write, so lines logged by the loading threads don't get mixed up
+			fprintf(log_file, "INFO: %s\n", file_buf);
 			fclose(log_file);
 		}
 	}
@@ -435,9 +434,8 @@ void Utils::logError(const char* format, ...) {
 	else if (LOG_FILE_CREATED) {
 		FILE *log_file = fopen(LOG_PATH.c_str(), "a");
 		if (log_file) {
-			fprintf(log_file, "ERROR: ");
-			fprintf(log_file, "%s", file_buf);
-			fprintf(log_file, "\n");
+			// a single write, so lines logged by the loading threads don't get mixed up
+			fprintf(log_file, "ERROR: %s\n", file_buf);
 			fclose(log_file);
 		}
 	}
@@ -699,6 +697,59 @@ unsigned long Utils::hashString(const std::string& str) {
 	return coll.hash(str.data(), str.data() + str.length());
 }
 
+std::string Utils::encodeBase64(const std::vector<unsigned char>& data) {
+	static const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	std::string str;
+	str.reserve((data.size() + 2) / 3 * 4);
+
+	for (size_t i = 0; i < data.size(); i += 3) {
+		unsigned bits = static_cast<unsigned>(data[i]) << 16;
+		if (i + 1 < data.size()) bits |= static_cast<unsigned>(data[i+1]) << 8;
+		if (i + 2 < data.size()) bits |= static_cast<unsigned>(data[i+2]);
+
+		str += chars[(bits >> 18) & 0x3f];
+		str += chars[(bits >> 12) & 0x3f];
+		str += (i + 1 < data.size() ? chars[(bits >> 6) & 0x3f] : '=');
+		str += (i + 2 < data.size() ? chars[bits & 0x3f] : '=');
+	}
+
+	return str;
+}
+
+/**
+ * Returns false if str contains anything other than base64 characters and padding
+ */
+bool Utils::decodeBase64(const std::string& str, std::vector<unsigned char>& data) {
+	data.clear();
+	data.reserve(str.length() / 4 * 3);
+
+	unsigned bits = 0;
+	int bit_count = 0;
+
+	for (size_t i = 0; i < str.length(); ++i) {
+		const char c = str[i];
+		unsigned val;
+
+		if (c >= 'A' && c <= 'Z') val = c - 'A';
+		else if (c >= 'a' && c <= 'z') val = c - 'a' + 26;
+		else if (c >= '0' && c <= '9') val = c - '0' + 52;
+		else if (c == '+') val = 62;
+		else if (c == '/') val = 63;
+		else if (c == '=') break;
+		else return false;
+
+		bits = (bits << 6) | val;
+		bit_count += 6;
+		if (bit_count >= 8) {
+			bit_count -= 8;
+			data.push_back(static_cast<unsigned char>((bits >> bit_count) & 0xff));
+		}
+	}
+
+	return true;
+}
+
 char* Utils::strdup(const std::string& str) {
 	size_t length = str.length() + 1;
 	char *x = static_cast<char*>(malloc(length));
@@ -156,6 +156,9 @@ namespace Utils {
 
 	unsigned long hashString(const std::string& str);
 
+	std::string encodeBase64(const std::vector<unsigned char>& data);
+	bool decodeBase64(const std::string& str, std::vector<unsigned char>& data);
+
 	char* strdup(const std::string& str);
 
 	void lockFileRead();
@@ -65,6 +65,28 @@ bool Filesystem::fileExists(const std::string &filename) {
 	return exists;
 }
 
+/**
+ * Returns the last modification time of a file, or 0 if the file can't be read
+ */
+long Filesystem::getFileModifiedTime(const std::string &filename) {
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0)
+		return 0;
+
+	return static_cast<long>(st.st_mtime);
+}
+
+/**
+ * Returns the size of a file in bytes, or -1 if the file can't be read
+ */
+long Filesystem::getFileSize(const std::string &filename) {
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0)
+		return -1;
+
+	return static_cast<long>(st.st_size);
+}
+
 /**
  * Returns a vector containing all filenames in a given folder with the given extension
  */
@@ -116,6 +138,44 @@ int Filesystem::getDirList(const std::string &dir, std::vector<std::string> &dir
 	return 0;
 }
 
+/**
+ * Returns the names of all files and directories in a given directory, in the order they are read
+ * Unlike getDirList(), this only needs to stat() entries if the file system doesn't report their type
+ */
+int Filesystem::getDirEntries(const std::string &dir, std::vector<std::string> &files, std::vector<std::string> &dirs) {
+
+	DIR *dp;
+	struct dirent *dirp;
+
+	if((dp  = opendir(dir.c_str())) == NULL)
+		return errno;
+
+	while ((dirp = readdir(dp)) != NULL) {
+		std::string name = std::string(dirp->d_name);
+		if (name == "." || name == "..")
+			continue;
+
+		bool is_dir;
+#ifdef _DIRENT_HAVE_D_TYPE
+		if (dirp->d_type == DT_DIR)
+			is_dir = true;
+		else if (dirp->d_type == DT_REG)
+			is_dir = false;
+		else
+			is_dir = isDirectory(dir + "/" + name, false);
+#else
+		is_dir = isDirectory(dir + "/" + name, false);
+#endif
+
+		if (is_dir)
+			dirs.push_back(name);
+		else
+			files.push_back(name);
+	}
+	closedir(dp);
+	return 0;
+}
+
 bool Filesystem::isDirectory(const std::string &path, bool show_error) {
 	struct stat st;
 	if (stat(path.c_str(), &st) == -1) {
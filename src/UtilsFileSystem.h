@@ -31,8 +31,11 @@ namespace Filesystem {
 	bool pathExists(const std::string &path);
 	void createDir(const std::string &path);
 	bool fileExists(const std::string &filename);
+	long getFileModifiedTime(const std::string &filename);
+	long getFileSize(const std::string &filename);
 	int getFileList(const std::string &dir, const std::string &ext, std::vector<std::string> &files);
 	int getDirList(const std::string &dir, std::vector<std::string> &dirs);
+	int getDirEntries(const std::string &dir, std::vector<std::string> &files, std::vector<std::string> &dirs);
 
 	bool isDirectory(const std::string &path, bool show_error = true);
 
@@ -33,7 +33,7 @@ namespace Parse {
 	std::string getSectionTitle(const std::string& s);
 	void getKeyPair(const std::string& s, std::string& key, std::string& val);
 	std::string stripCarriageReturn(const std::string& line);
-	std::string getLine(std::ifstream& infile);
+	std::string getLine(std::istream& infile);
 	bool tryParseValue(const std::type_info & type, const std::string & value, void * output);
 
 	std::string toString(const std::type_info & type, void * value);
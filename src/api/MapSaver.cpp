@@ -20,7 +20,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MapSaver.h"
 #include "Settings.h"
 
-MapSaver::MapSaver(Map *_map) : map(_map)
+MapSaver::MapSaver(Map *_map) : layer_format(Map::LAYER_FORMAT_DEC), map(_map)
 {
 	EVENT_COMPONENT_NAME[EC::TOOLTIP] = "tooltip";
 	EVENT_COMPONENT_NAME[EC::POWER_PATH] = "power_path";
@@ -153,6 +153,15 @@ void MapSaver::writeLayers(std::ofstream& map_file)
 		map_file << "[layer]" << std::endl;
 
 		map_file << "type=" << map->layernames[i] << std::endl;
+
+		if (layer_format == Map::LAYER_FORMAT_RLE)
+		{
+			map_file << "format=rle" << std::endl;
+			map_file << "data=" << Map::encodeLayerRLE(map->layers[i], map->w, map->h) << std::endl;
+			map_file << std::endl;
+			continue;
+		}
+
 		map_file << "data=" << std::endl;
 
 		std::string layer = "";
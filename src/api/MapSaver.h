@@ -34,6 +34,9 @@ public:
 	bool saveMap(std::string tileset_definitions);
 	bool saveMap(std::string file, std::string tileset_definitions);
 
+	// Map::LAYER_FORMAT_DEC or Map::LAYER_FORMAT_RLE
+	int layer_format;
+
 private:
 	void writeHeader(std::ofstream& map_file);
 	void writeTilesets(std::ofstream& map_file, std::string tileset_definitions);
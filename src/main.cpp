@@ -26,20 +26,27 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include <limits.h>
 
 #include "AnimationManager.h"
+#include "Benchmark.h"
 #include "CombatText.h"
 #include "DeviceList.h"
 #include "EngineSettings.h"
+#include "FileParser.h"
 #include "GameSwitcher.h"
 #include "InputState.h"
+#include "ItemManager.h"
 #include "MessageEngine.h"
+#include "ModArchive.h"
 #include "ModManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "SaveLoad.h"
 #include "SDLFontEngine.h"
 #include "Settings.h"
+#include "SharedGameResources.h"
 #include "SharedResources.h"
 #include "SoundManager.h"
 #include "Stats.h"
+#include "TaskGraph.h"
 #include "TooltipManager.h"
 #include "Utils.h"
 #include "UtilsFileSystem.h"
@@ -73,60 +80,50 @@ bool init_finished = false;
 #endif
 
 /**
- * Game initialization.
+ * Startup tasks, run by init() through a TaskGraph
+ * The worker tasks only parse text files. Anything that creates SDL resources runs on the main thread.
  */
-static void init(const CmdLineArgs& cmd_line_args) {
-	/**
-	 * Set system paths
-	 * PATH_CONF is for user-configurable settings files (e.g. keybindings)
-	 * PATH_USER is for user-specific data (e.g. save games)
-	 * PATH_DATA is for common game data (e.g. images, music)
-	 */
-	platform.setPaths();
-
-	Utils::lockFileCheck();
-
-	Utils::createLogFile();
-	Utils::logInfo(VersionInfo::createVersionStringFull().c_str());
-
-	// SDL Inits
-	if ( SDL_Init (SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_JOYSTICK) < 0 ) {
-		Utils::logError("main: Could not initialize SDL: %s", SDL_GetError());
-		Utils::logErrorDialog("main: Could not initialize SDL: %s", SDL_GetError());
-		Utils::Exit(1);
-	}
+static void initMessages(void*) {
+	msg = new MessageEngine();
+}
 
-	// Shared Resources set-up
+static void initEngineSettings(void*) {
+	// Load miscellaneous settings
+	eset = new EngineSettings();
 
-	mods = new ModManager(&(cmd_line_args.mod_list));
+	// errors are reported on the main thread once the startup tasks have finished
+	eset->load(EngineSettings::DEFER_ERRORS);
+}
 
-	if (!mods->haveFallbackMod()) {
-		Utils::logError("main: Could not find the default mod in the following locations:");
-		if (Filesystem::pathExists(settings->path_user + "mods")) Utils::logError("%smods/", settings->path_user.c_str());
-		if (Filesystem::pathExists(settings->path_data + "mods")) Utils::logError("%smods/", settings->path_data.c_str());
-		Utils::logError("A copy of the default mod is in the \"mods\" directory of the flare-engine repo.");
-		Utils::logError("The repo is located at: https://github.com/flareteam/flare-engine");
-		Utils::logError("Try again after copying the default mod to one of the above directories. Exiting.");
-		Utils::logErrorDialog("main: Could not find the 'default' mod in the following locations:\n\n%smods/\n%smods/", settings->path_user.c_str(), settings->path_data.c_str());
-		Utils::Exit(1);
-	}
+static void initStats(void*) {
+	Stats::init();
+}
 
-	settings->loadSettings();
+static void initItems(void*) {
+	// sounds are loaded once the sound manager exists
+	items = new ItemManager(ItemManager::DEFER_SOUNDS);
+}
 
+static void initSaveLoad(void*) {
 	save_load = new SaveLoad();
-	msg = new MessageEngine();
+}
+
+static void initFont(void*) {
 	font = getFontEngine();
+}
+
+static void initAnimations(void*) {
 	anim = new AnimationManager();
 	comb = new CombatText();
-	
-	// Load miscellaneous settings
-	eset = new EngineSettings();
-	eset->load();
-	
+}
+
+static void initInput(void*) {
 	inpt = getInputManager();
 	icons = NULL;
+}
 
-	Stats::init();
+static void initRenderDevice(void* data) {
+	const std::string* render_device_name = static_cast<const std::string*>(data);
 
 	// platform-specific default screen size
 	platform.setScreenSize();
@@ -134,8 +131,8 @@ static void init(const CmdLineArgs& cmd_line_args) {
 	// Create render Device and Rendering Context.
 	if (platform.default_renderer != "")
 		render_device = getRenderDevice(platform.default_renderer);
-	else if (cmd_line_args.render_device_name != "")
-		render_device = getRenderDevice(cmd_line_args.render_device_name);
+	else if (*render_device_name != "")
+		render_device = getRenderDevice(*render_device_name);
 	else
 		render_device = getRenderDevice(settings->render_device_name);
 
@@ -149,16 +146,107 @@ static void init(const CmdLineArgs& cmd_line_args) {
 
 	// reset the reload_graphics flag
 	render_device->reloadGraphics();
+}
 
+static void initSound(void*) {
 	snd = getSoundManager();
 
 	inpt->initJoystick();
+}
 
+static void initItemSounds(void*) {
+	items->loadSounds();
+}
+
+static void initGameSwitcher(void*) {
 	tooltipm = new TooltipManager();
 
 	gswitch = new GameSwitcher();
 }
 
+/**
+ * Game initialization.
+ */
+static void init(const CmdLineArgs& cmd_line_args) {
+	/**
+	 * Set system paths
+	 * PATH_CONF is for user-configurable settings files (e.g. keybindings)
+	 * PATH_USER is for user-specific data (e.g. save games)
+	 * PATH_DATA is for common game data (e.g. images, music)
+	 */
+	platform.setPaths();
+
+	Utils::lockFileCheck();
+
+	Utils::createLogFile();
+	Utils::logInfo(VersionInfo::createVersionStringFull().c_str());
+
+	// SDL Inits
+	if ( SDL_Init (SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_JOYSTICK) < 0 ) {
+		Utils::logError("main: Could not initialize SDL: %s", SDL_GetError());
+		Utils::logErrorDialog("main: Could not initialize SDL: %s", SDL_GetError());
+		Utils::Exit(1);
+	}
+
+	// Shared Resources set-up
+
+	mods = new ModManager(&(cmd_line_args.mod_list));
+
+	if (!mods->haveFallbackMod()) {
+		Utils::logError("main: Could not find the default mod in the following locations:");
+		if (Filesystem::pathExists(settings->path_user + "mods")) Utils::logError("%smods/", settings->path_user.c_str());
+		if (Filesystem::pathExists(settings->path_data + "mods")) Utils::logError("%smods/", settings->path_data.c_str());
+		Utils::logError("A copy of the default mod is in the \"mods\" directory of the flare-engine repo.");
+		Utils::logError("The repo is located at: https://github.com/flareteam/flare-engine");
+		Utils::logError("Try again after copying the default mod to one of the above directories. Exiting.");
+		Utils::logErrorDialog("main: Could not find the 'default' mod in the following locations:\n\n%smods/\n%smods/", settings->path_user.c_str(), settings->path_data.c_str());
+		Utils::Exit(1);
+	}
+
+	settings->loadSettings();
+
+	// the game databases are parsed on worker threads, while the main thread sets up SDL
+	std::string render_device_name = cmd_line_args.render_device_name;
+
+	TaskGraph startup("startup");
+	const size_t task_messages = startup.addTask("messages", initMessages, NULL, TaskGraph::WORKER_THREAD);
+	const size_t task_engine_settings = startup.addTask("engine settings", initEngineSettings, NULL, TaskGraph::WORKER_THREAD);
+	const size_t task_stats = startup.addTask("stats", initStats, NULL, TaskGraph::WORKER_THREAD);
+	const size_t task_items = startup.addTask("items", initItems, NULL, TaskGraph::WORKER_THREAD);
+	const size_t task_save_load = startup.addTask("save/load", initSaveLoad, NULL, TaskGraph::MAIN_THREAD);
+	const size_t task_font = startup.addTask("font", initFont, NULL, TaskGraph::MAIN_THREAD);
+	const size_t task_animations = startup.addTask("animations", initAnimations, NULL, TaskGraph::MAIN_THREAD);
+	const size_t task_input = startup.addTask("input", initInput, NULL, TaskGraph::MAIN_THREAD);
+	const size_t task_render_device = startup.addTask("render device", initRenderDevice, &render_device_name, TaskGraph::MAIN_THREAD);
+	const size_t task_sound = startup.addTask("sound", initSound, NULL, TaskGraph::MAIN_THREAD);
+	const size_t task_item_sounds = startup.addTask("item sounds", initItemSounds, NULL, TaskGraph::MAIN_THREAD);
+	const size_t task_game_switcher = startup.addTask("game switcher", initGameSwitcher, NULL, TaskGraph::MAIN_THREAD);
+
+	startup.addDependency(task_engine_settings, task_messages);
+	startup.addDependency(task_stats, task_messages);
+	startup.addDependency(task_stats, task_engine_settings);
+	startup.addDependency(task_items, task_engine_settings);
+	startup.addDependency(task_items, task_stats);
+	startup.addDependency(task_animations, task_font);
+	startup.addDependency(task_input, task_messages);
+	startup.addDependency(task_input, task_engine_settings);
+	startup.addDependency(task_render_device, task_engine_settings);
+	startup.addDependency(task_render_device, task_input);
+	startup.addDependency(task_sound, task_render_device);
+	startup.addDependency(task_item_sounds, task_items);
+	startup.addDependency(task_item_sounds, task_sound);
+	startup.addDependency(task_game_switcher, task_save_load);
+	startup.addDependency(task_game_switcher, task_animations);
+	startup.addDependency(task_game_switcher, task_item_sounds);
+
+	startup.run();
+	startup.logTimeline();
+
+	eset->checkErrors();
+
+	FileParser::logStats("startup");
+}
+
 static float getSecondsElapsed(uint64_t prev_ticks, uint64_t now_ticks) {
 	return (static_cast<float>(now_ticks - prev_ticks) / static_cast<float>(SDL_GetPerformanceFrequency()));
 }
@@ -174,10 +262,14 @@ static void mainLoop () {
 	float last_fps = -1;
 
 	while ( !done ) {
+		Profiler::beginFrame();
+
 		int loops = 0;
 		uint64_t now_ticks = SDL_GetPerformanceCounter();
 
 		while (now_ticks >= logic_ticks && loops < settings->max_frames_per_sec) {
+			PROFILER_ZONE("logic");
+
 			// Frames where data loading happens (GameState switching and map loading)
 			// take a long time, so our loop here will think that the game "lagged" and
 			// try to compensate. To prevent this compensation, we mark those frames as
@@ -222,6 +314,9 @@ static void mainLoop () {
 		}
 
 		if (!inpt->window_minimized) {
+			PROFILER_ZONE("render");
+
+			render_device->updateImageLoads();
 			render_device->blankScreen();
 			gswitch->render();
 
@@ -230,7 +325,12 @@ static void mainLoop () {
 				gswitch->showFPS(last_fps);
 			}
 
-			render_device->commitFrame();
+			Profiler::renderGraph();
+
+			{
+				PROFILER_ZONE("RenderDevice::commitFrame");
+				render_device->commitFrame();
+			}
 
 			// calculate the FPS
 			// if the frame completed quickly, we estimate the delay here
@@ -247,6 +347,8 @@ static void mainLoop () {
 			}
 		}
 
+		Profiler::endFrame();
+
 		// delay quick frames
 		// thanks to David Gow: https://davidgow.net/handmadepenguin/ch18.html
 		if (getSecondsElapsed(prev_ticks, SDL_GetPerformanceCounter()) < seconds_per_frame) {
@@ -267,16 +369,26 @@ static void cleanup() {
 
 	delete gswitch;
 
+	// items are loaded at startup, but only deleted by the game states once they have been used
+	delete items;
+	items = NULL;
+
 	delete anim;
 	delete comb;
 	delete font;
 	delete inpt;
-	delete mods;
 	delete msg;
 	delete snd;
 	delete save_load;
 	delete eset;
 
+	// images may still be decoding from a mod archive on the image loading threads
+	if (render_device)
+		render_device->waitForImageLoads();
+
+	// music may still be playing from a mod archive until the sound manager is deleted
+	delete mods;
+
 	if (render_device)
 		render_device->destroyContext();
 	delete render_device;
@@ -323,15 +435,21 @@ void EmscriptenMainLoop() {
 		return;
 	}
 
+	Profiler::beginFrame();
+
 	SDL_PumpEvents();
 	inpt->handle();
 
 	gswitch->logic();
 	inpt->resetScroll();
 
+	render_device->updateImageLoads();
 	render_device->blankScreen();
 	gswitch->render();
+	Profiler::renderGraph();
 	render_device->commitFrame();
+
+	Profiler::endFrame();
 }
 #endif
 
@@ -340,7 +458,12 @@ int main(int argc, char *argv[]) {
 
 	bool debug_event = false;
 	bool done = false;
+	int exit_code = 0;
 	CmdLineArgs cmd_line_args;
+	std::string pack_mod_dir;
+	std::string pack_mod_output;
+	bool run_benchmark = false;
+	Benchmark benchmark;
 
 	for (int i = 1 ; i < argc; i++) {
 		std::string arg_full = std::string(argv[i]);
@@ -395,6 +518,39 @@ int main(int argc, char *argv[]) {
 		else if (arg == "load-script") {
 			settings->load_script = parseArgValue(arg_full);
 		}
+		else if (arg == "pack-mod") {
+			pack_mod_dir = parseArgValue(arg_full);
+		}
+		else if (arg == "pack-output") {
+			pack_mod_output = parseArgValue(arg_full);
+		}
+		else if (arg == "benchmark") {
+			run_benchmark = true;
+		}
+		else if (arg == "benchmark-map") {
+			benchmark.map_filename = parseArgValue(arg_full);
+		}
+		else if (arg == "benchmark-ticks") {
+			benchmark.ticks = static_cast<unsigned>(Parse::toUnsignedLong(parseArgValue(arg_full)));
+		}
+		else if (arg == "benchmark-enemies") {
+			benchmark.enemy_count = static_cast<unsigned>(Parse::toUnsignedLong(parseArgValue(arg_full)));
+		}
+		else if (arg == "benchmark-allies") {
+			benchmark.ally_count = static_cast<unsigned>(Parse::toUnsignedLong(parseArgValue(arg_full)));
+		}
+		else if (arg == "benchmark-category") {
+			benchmark.enemy_category = parseArgValue(arg_full);
+		}
+		else if (arg == "benchmark-power") {
+			benchmark.power_id = Parse::toInt(parseArgValue(arg_full));
+		}
+		else if (arg == "benchmark-volley") {
+			benchmark.volley_size = static_cast<unsigned>(Parse::toUnsignedLong(parseArgValue(arg_full)));
+		}
+		else if (arg == "benchmark-output") {
+			benchmark.output_filename = parseArgValue(arg_full);
+		}
 		else if (arg == "help") {
 			Utils::logInfo("Command line options:\n\
 --help                   Prints this message.\n\
@@ -407,7 +563,24 @@ int main(int argc, char *argv[]) {
 --mods=<MOD>,...         Starts the game with only these mods enabled.\n\
 --load-slot=<SLOT>       Loads a save slot by numerical index.\n\
 --load-script=<SCRIPT>   Execute's a script upon loading a saved game.\n\
-                         The script path is mod-relative.\n");
+                         The script path is mod-relative.\n\
+--pack-mod=<DIR>         Packs a mod folder into a mod archive and exits.\n\
+--pack-output=<FILE>     The archive written by --pack-mod.\n\
+                         The default is the mod folder with '.pak' appended.\n\
+--benchmark              Runs the game logic without a window and exits.\n\
+                         The results are printed as JSON.\n\
+--benchmark-map=<MAP>    The map to run the benchmark on.\n\
+                         The default is the map a new game starts on.\n\
+--benchmark-ticks=<N>    The number of logic ticks to run. The default is 1000.\n\
+--benchmark-enemies=<N>  The number of enemies to spawn. The default is 50.\n\
+--benchmark-allies=<N>   The number of allies to spawn. The default is 0.\n\
+--benchmark-category=<CATEGORY>\n\
+                         The enemy category that enemies and allies are picked from.\n\
+--benchmark-power=<ID>   A power that the hero casts at the nearest enemy.\n\
+--benchmark-volley=<N>   The number of times the power is cast at once, spread over\n\
+                         the enemies around the hero. The default is 1.\n\
+--benchmark-output=<FILE>\n\
+                         Writes the results to a file instead.\n");
 			done = true;
 		}
 		else {
@@ -415,6 +588,29 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
+	if (!done && !pack_mod_dir.empty()) {
+		if (pack_mod_output.empty())
+			pack_mod_output = Filesystem::removeTrailingSlash(pack_mod_dir) + ModArchive::EXTENSION;
+
+		if (!ModArchive::pack(pack_mod_dir, pack_mod_output))
+			exit_code = 1;
+		done = true;
+	}
+
+	if (!done && run_benchmark) {
+		// no window or audio device is needed, so SDL's dummy drivers are used
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+		SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+		settings->audio = false;
+		cmd_line_args.render_device_name = "sdl";
+
+		init(cmd_line_args);
+		if (!benchmark.run())
+			exit_code = 1;
+		cleanup();
+		done = true;
+	}
+
 soft_reset:
 	if (!done) {
 		srand(static_cast<unsigned int>(time(NULL)));
@@ -446,5 +642,5 @@ soft_reset:
 
 	delete settings;
 
-	return 0;
+	return exit_code;
 }